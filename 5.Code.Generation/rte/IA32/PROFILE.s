@@ -0,0 +1,323 @@
+#-------------------------------------------------------------------------------
+#// @brief SnuPL runtime profiler
+
+  .text
+  .align 4
+
+.global _prof_report
+.global _prof_child
+
+.extern _prof_nprocs
+.extern _prof_table
+.extern _prof_outfile
+
+#-------------------------------------------------------------------------------
+# Flat profile support
+#
+# Programs compiled with 'snuplc --profile' count calls and time stamp counter
+# cycles of every procedure inline in the procedure's prologue and epilogue.
+# The compiler emits one record per procedure into the array _prof_table
+#
+#   ------------------------------------------------------------------------
+#   | name | calls | inclusive (lo, hi) | exclusive (lo, hi) | active |
+#   ------------------------------------------------------------------------
+#     +0     +4      +8                   +16                  +24  (28 bytes)
+#
+# followed by the number of records in _prof_nprocs and the name of the output
+# file in _prof_outfile (empty string: print to stderr).
+#
+# _prof_child accumulates the cycles spent in callees of the currently active
+# procedure. Each procedure saves and clears it on entry; on exit it subtracts
+# it from its own inclusive time (exclusive time) and adds its inclusive time
+# to the saved value of the caller.
+#
+# 'active' counts the activations of the procedure that have not returned
+# yet. Nested activations of a recursive procedure are part of the outermost
+# one, so only the outermost activation adds its time to the inclusive time.
+#
+
+  .data
+  .align 4
+
+_prof_child:
+  .long 0, 0
+
+.Lheader:
+  .ascii "flat profile (time stamp counter cycles):\n"
+  .ascii "  %time     exclusive     inclusive      calls  procedure\n"
+.Lheader_end:
+
+  .lcomm _prof_buf, 256
+
+  .text
+
+#-------------------------------------------------------------------------------
+# procedure _prof_report
+# (C: void _prof_report(void))
+#
+# sorts the profile records by exclusive time and prints the flat profile to
+# the file _prof_outfile or stderr.
+#
+# IA32 Linux calling convention
+_prof_report:
+  pushl   %ebp
+  movl    %esp, %ebp
+  pushl   %ebx
+  pushl   %esi
+  pushl   %edi
+  subl    $20, %esp             # -16: fd, -20: scaled total, -24: shift,
+                                # -28: remaining records
+
+  # open output file
+  movl    $2, -16(%ebp)         # default: stderr
+  cmpb    $0, _prof_outfile
+  je      .Lsort
+
+  movl    $_prof_outfile, %ebx  # %ebx = file name
+  movl    $0x241, %ecx          # %ecx = O_WRONLY | O_CREAT | O_TRUNC
+  movl    $0644, %edx           # %edx = mode
+  movl    $5, %eax              # %eax = 5 (open syscall)
+  int     $0x80                 # syscall
+
+  testl   %eax, %eax            # failed? keep printing to stderr
+  js      .Lsort
+  movl    %eax, -16(%ebp)
+
+  # selection sort by exclusive time (descending)
+.Lsort:
+  movl    _prof_nprocs, %ecx    # %ecx = number of unsorted records
+  movl    $_prof_table, %esi    # %esi = first unsorted record
+
+.Lsort_outer:
+  cmpl    $1, %ecx
+  jle     .Lsum
+
+  movl    %esi, %edi            # %edi = record with maximum exclusive time
+  leal    28(%esi), %ebx        # %ebx = candidate
+  leal    -1(%ecx), %edx        # %edx = number of candidates
+
+.Lsort_inner:
+  movl    20(%ebx), %eax        # compare exclusive time (unsigned 64 bit)
+  cmpl    20(%edi), %eax
+  ja      .Lsort_max
+  jb      .Lsort_next
+  movl    16(%ebx), %eax
+  cmpl    16(%edi), %eax
+  jbe     .Lsort_next
+.Lsort_max:
+  movl    %ebx, %edi
+.Lsort_next:
+  addl    $28, %ebx
+  decl    %edx
+  jnz     .Lsort_inner
+
+  cmpl    %esi, %edi            # swap first unsorted and maximum record
+  je      .Lsort_noswap
+  pushl   %ecx
+  movl    $7, %ecx
+.Lsort_swap:
+  movl    -4(%esi,%ecx,4), %eax
+  movl    -4(%edi,%ecx,4), %ebx
+  movl    %ebx, -4(%esi,%ecx,4)
+  movl    %eax, -4(%edi,%ecx,4)
+  loop    .Lsort_swap
+  popl    %ecx
+
+.Lsort_noswap:
+  addl    $28, %esi
+  decl    %ecx
+  jmp     .Lsort_outer
+
+  # total exclusive time, scaled down to 22 bits for the percentage
+.Lsum:
+  xorl    %eax, %eax
+  xorl    %edx, %edx
+  movl    _prof_nprocs, %ecx
+  movl    $_prof_table, %esi
+  testl   %ecx, %ecx
+  jz      .Lscale
+.Lsum_loop:
+  addl    16(%esi), %eax
+  adcl    20(%esi), %edx
+  addl    $28, %esi
+  loop    .Lsum_loop
+
+.Lscale:
+  xorl    %ecx, %ecx            # %ecx = shift count
+.Lscale_loop:
+  testl   %edx, %edx
+  jnz     .Lscale_shift
+  cmpl    $0x400000, %eax
+  jb      .Lscale_done
+.Lscale_shift:
+  shrdl   $1, %edx, %eax
+  shrl    $1, %edx
+  incl    %ecx
+  jmp     .Lscale_loop
+.Lscale_done:
+  movl    %eax, -20(%ebp)
+  movl    %ecx, -24(%ebp)
+
+  # print header
+  movl    $.Lheader_end, %edx
+  subl    $.Lheader, %edx       # %edx = number of characters
+  movl    $.Lheader, %ecx       # %ecx = pointer to string
+  movl    -16(%ebp), %ebx       # %ebx = fd
+  movl    $4, %eax              # %eax = 4 (write syscall)
+  int     $0x80                 # syscall
+
+  # print one line per record
+  movl    _prof_nprocs, %eax
+  movl    %eax, -28(%ebp)
+  movl    $_prof_table, %esi
+
+.Lline:
+  cmpl    $0, -28(%ebp)
+  je      .Lclose
+  movl    $_prof_buf, %edi
+
+  # %time = (exclusive >> shift) * 1000 / scaled total (in 1/10 percent)
+  movl    16(%esi), %eax
+  movl    20(%esi), %edx
+  movl    -24(%ebp), %ecx
+  testl   %ecx, %ecx
+  jz      .Lpercent
+.Lpercent_shift:
+  shrdl   $1, %edx, %eax
+  shrl    $1, %edx
+  loop    .Lpercent_shift
+.Lpercent:
+  imull   $1000, %eax
+  xorl    %edx, %edx
+  movl    -20(%ebp), %ebx
+  testl   %ebx, %ebx
+  jz      .Lpercent_print       # no cycles recorded at all
+  divl    %ebx
+.Lpercent_print:
+  xorl    %edx, %edx
+  movl    $10, %ebx
+  divl    %ebx                  # %eax = percent, %edx = 1/10 percent
+  pushl   %edx
+  xorl    %edx, %edx
+  movl    $5, %ecx
+  call    .Lformat
+  movb    $0x2e, (%edi)         # '.'
+  popl    %eax
+  addb    $0x30, %al
+  movb    %al, 1(%edi)
+  addl    $2, %edi
+
+  movl    16(%esi), %eax        # exclusive
+  movl    20(%esi), %edx
+  movl    $14, %ecx
+  call    .Lformat
+
+  movl    8(%esi), %eax         # inclusive
+  movl    12(%esi), %edx
+  movl    $14, %ecx
+  call    .Lformat
+
+  movl    4(%esi), %eax         # calls
+  xorl    %edx, %edx
+  movl    $11, %ecx
+  call    .Lformat
+
+  movb    $0x20, (%edi)         # procedure name (truncated to 200 characters)
+  movb    $0x20, 1(%edi)
+  addl    $2, %edi
+  movl    (%esi), %ebx
+  movl    $200, %ecx
+.Lname:
+  movb    (%ebx), %al
+  testb   %al, %al
+  je      .Lname_done
+  movb    %al, (%edi)
+  incl    %ebx
+  incl    %edi
+  loop    .Lname
+.Lname_done:
+  movb    $0x0a, (%edi)         # newline
+  incl    %edi
+
+  movl    %edi, %edx
+  subl    $_prof_buf, %edx      # %edx = number of characters
+  movl    $_prof_buf, %ecx      # %ecx = pointer to string
+  movl    -16(%ebp), %ebx       # %ebx = fd
+  movl    $4, %eax              # %eax = 4 (write syscall)
+  int     $0x80                 # syscall
+
+  addl    $28, %esi
+  decl    -28(%ebp)
+  jmp     .Lline
+
+  # close output file
+.Lclose:
+  movl    -16(%ebp), %ebx
+  cmpl    $2, %ebx
+  je      .Ldone
+  movl    $6, %eax              # %eax = 6 (close syscall)
+  int     $0x80                 # syscall
+
+.Ldone:
+  addl    $20, %esp
+  popl    %edi
+  popl    %esi
+  popl    %ebx
+  popl    %ebp
+  ret
+
+
+#-------------------------------------------------------------------------------
+# internal: format an unsigned 64-bit value
+#
+# writes %edx:%eax in decimal notation right-aligned in a field of %ecx
+# characters to (%edi) and advances %edi. Clobbers %eax, %ecx, %edx.
+.Lformat:
+  pushl   %ebx
+  pushl   %esi
+  pushl   %ebp
+  movl    %esp, %ebp
+  pushl   %ecx                  # -4(%ebp) = field width
+  subl    $24, %esp             # digits are stored below -4(%ebp)
+
+  leal    -4(%ebp), %esi        # %esi = position of last digit + 1
+  movl    $10, %ebx
+
+.Lformat_digit:
+  movl    %eax, %ecx            # 64-bit division by 10 in two steps
+  movl    %edx, %eax
+  xorl    %edx, %edx
+  divl    %ebx                  # %eax = high quotient, %edx = remainder
+  xchgl   %eax, %ecx            # %ecx = high quotient, %eax = low word
+  divl    %ebx                  # %eax = low quotient, %edx = digit
+  addb    $0x30, %dl
+  decl    %esi
+  movb    %dl, (%esi)
+  movl    %ecx, %edx            # %edx:%eax = quotient
+  movl    %eax, %ecx
+  orl     %edx, %ecx
+  jnz     .Lformat_digit
+
+  leal    -4(%ebp), %ecx
+  subl    %esi, %ecx            # %ecx = number of digits
+  movl    -4(%ebp), %edx
+  subl    %ecx, %edx            # %edx = number of padding characters
+  jle     .Lformat_copy
+.Lformat_pad:
+  movb    $0x20, (%edi)
+  incl    %edi
+  decl    %edx
+  jnz     .Lformat_pad
+
+.Lformat_copy:
+  movb    (%esi), %al
+  movb    %al, (%edi)
+  incl    %esi
+  incl    %edi
+  loop    .Lformat_copy
+
+  movl    %ebp, %esp
+  popl    %ebp
+  popl    %esi
+  popl    %ebx
+  ret
@@ -0,0 +1,22 @@
+//
+// fib
+//
+// compute Fibonacci numbers recursively
+//
+// input: n
+//
+
+module fib;
+
+var n: integer;
+
+function Fib(n: integer): integer;
+begin
+  if (n < 2) then return n end;
+  return Fib(n-1) + Fib(n-2)
+end Fib;
+
+begin
+  n := ReadInt();
+  WriteStr("fib("); WriteInt(n); WriteStr(") = "); WriteInt(Fib(n)); WriteLn()
+end fib.
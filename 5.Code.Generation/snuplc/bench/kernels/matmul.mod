@@ -0,0 +1,72 @@
+//
+// matmul
+//
+// multiply two n x n integer matrices and print a checksum of the result
+//
+// input: n (at most 300)
+//
+
+module matmul;
+
+var a, b, c: integer[300][300];
+    n: integer;
+
+procedure Init(m: integer[][]; n, seed: integer);
+var i, j: integer;
+begin
+  i := 0;
+  while (i < n) do
+    j := 0;
+    while (j < n) do
+      m[i][j] := (i * seed + j * 7 + 3) - (i * seed + j * 7 + 3) / 19 * 19 - 9;
+      j := j + 1
+    end;
+    i := i + 1
+  end
+end Init;
+
+procedure Multiply(a, b, c: integer[][]; n: integer);
+var i, j, k, s: integer;
+begin
+  i := 0;
+  while (i < n) do
+    j := 0;
+    while (j < n) do
+      s := 0;
+      k := 0;
+      while (k < n) do
+        s := s + a[i][k] * b[k][j];
+        k := k + 1
+      end;
+      c[i][j] := s;
+      j := j + 1
+    end;
+    i := i + 1
+  end
+end Multiply;
+
+function Checksum(m: integer[][]; n: integer): integer;
+var i, j, s: integer;
+begin
+  s := 0;
+  i := 0;
+  while (i < n) do
+    j := 0;
+    while (j < n) do
+      s := s + m[i][j] * (i + 1) - j;
+      j := j + 1
+    end;
+    i := i + 1
+  end;
+  return s
+end Checksum;
+
+begin
+  n := ReadInt();
+
+  Init(a, n, 13);
+  Init(b, n, 5);
+  Multiply(a, b, c, n);
+
+  WriteStr("checksum: "); WriteInt(Checksum(c, n)); WriteLn()
+end matmul.
@@ -0,0 +1,40 @@
+//
+// parse
+//
+// read a list of integers from the input and print statistics
+//
+// input: count followed by count integers in [0, 1000)
+//
+
+module parse;
+
+var hist: integer[10];
+    n, i, v, sum, min, max: integer;
+
+begin
+  n := ReadInt();
+
+  sum := 0;
+  min := 1000;
+  max := -1;
+  i := 0;
+  while (i < n) do
+    v := ReadInt();
+    sum := sum + v;
+    if (v < min) then min := v end;
+    if (v > max) then max := v end;
+    hist[v / 100] := hist[v / 100] + 1;
+    i := i + 1
+  end;
+
+  WriteStr("count: "); WriteInt(n);
+  WriteStr(", sum: "); WriteInt(sum);
+  WriteStr(", min: "); WriteInt(min);
+  WriteStr(", max: "); WriteInt(max); WriteLn();
+
+  i := 0;
+  while (i < 10) do
+    WriteInt(i * 100); WriteStr(": "); WriteInt(hist[i]); WriteLn();
+    i := i + 1
+  end
+end parse.
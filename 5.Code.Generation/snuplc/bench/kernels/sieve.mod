@@ -0,0 +1,51 @@
+//
+// sieve
+//
+// count the primes below n with the sieve of Eratosthenes, r times
+//
+// input: n r
+//
+
+module sieve;
+
+var composite: boolean[2000000];
+    n, r, count: integer;
+
+function Sieve(n: integer): integer;
+var i, j, count: integer;
+begin
+  i := 0;
+  while (i < n) do
+    composite[i] := false;
+    i := i + 1
+  end;
+
+  count := 0;
+  i := 2;
+  while (i < n) do
+    if (!composite[i]) then
+      count := count + 1;
+      j := i + i;
+      while (j < n) do
+        composite[j] := true;
+        j := j + i
+      end
+    end;
+    i := i + 1
+  end;
+
+  return count
+end Sieve;
+
+begin
+  n := ReadInt();
+  r := ReadInt();
+
+  while (r > 0) do
+    count := Sieve(n);
+    r := r - 1
+  end;
+
+  WriteStr("primes below "); WriteInt(n); WriteStr(": "); WriteInt(count);
+  WriteLn()
+end sieve.
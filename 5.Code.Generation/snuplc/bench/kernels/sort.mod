@@ -0,0 +1,95 @@
+//
+// sort
+//
+// sort n pseudo-random numbers with quicksort and insertion sort and
+// verify the result
+//
+// input: n (at most 200000) seed
+//
+
+module sort;
+
+var a: integer[200000];
+    b: integer[5000];
+    n, seed: integer;
+
+function Random(): integer;
+begin
+  seed := seed * 1103515245 + 12345;
+  seed := seed - seed / 2147483647 * 2147483647;
+  if (seed < 0) then seed := -seed end;
+  return seed / 65536
+end Random;
+
+procedure QuickSort(a: integer[]; lo, hi: integer);
+var i, j, p, t: integer;
+begin
+  if (lo < hi) then
+    p := a[(lo + hi) / 2];
+    i := lo;
+    j := hi;
+    while (i <= j) do
+      while (a[i] < p) do i := i + 1 end;
+      while (a[j] > p) do j := j - 1 end;
+      if (i <= j) then
+        t := a[i]; a[i] := a[j]; a[j] := t;
+        i := i + 1;
+        j := j - 1
+      end
+    end;
+    QuickSort(a, lo, j);
+    QuickSort(a, i, hi)
+  end
+end QuickSort;
+
+procedure InsertionSort(a: integer[]; n: integer);
+var i, j, v: integer;
+begin
+  i := 1;
+  while (i < n) do
+    v := a[i];
+    j := i - 1;
+    while ((j >= 0) && (a[j] > v)) do
+      a[j+1] := a[j];
+      j := j - 1
+    end;
+    a[j+1] := v;
+    i := i + 1
+  end
+end InsertionSort;
+
+function Check(a: integer[]; n: integer): integer;
+var i, s: integer;
+begin
+  s := 0;
+  i := 1;
+  while (i < n) do
+    if (a[i-1] > a[i]) then return -1 end;
+    s := s + a[i] / 16;
+    i := i + 1
+  end;
+  return s
+end Check;
+
+procedure Fill(a: integer[]; n: integer);
+var i: integer;
+begin
+  i := 0;
+  while (i < n) do
+    a[i] := Random();
+    i := i + 1
+  end
+end Fill;
+
+begin
+  n := ReadInt();
+  seed := ReadInt();
+
+  Fill(a, n);
+  QuickSort(a, 0, n-1);
+  WriteStr("quicksort: "); WriteInt(Check(a, n)); WriteLn();
+
+  Fill(b, 5000);
+  InsertionSort(b, 5000);
+  WriteStr("insertion sort: "); WriteInt(Check(b, 5000)); WriteLn()
+end sort.
@@ -0,0 +1,124 @@
+//
+// strings
+//
+// generate a pseudo-random text and count words, vowels and palindromic
+// words; reverse the text in place and compare it against a copy
+//
+// input: length (at most 1000000) rounds
+//
+
+module strings;
+
+var text, copy: char[1000000];
+    n, rounds, seed, i: integer;
+
+function Letter(): char;
+var c: integer;
+begin
+  seed := seed * 1103515245 + 12345;
+  seed := seed - seed / 2147483647 * 2147483647;
+  if (seed < 0) then seed := -seed end;
+  c := seed / 65536;
+  c := c - c / 32 * 32;
+  if (c = 0) then return ' ' end;
+  if (c = 1) then return 'a' end;
+  if (c = 2) then return 'e' end;
+  if (c = 3) then return 'i' end;
+  if (c = 4) then return 'o' end;
+  if (c = 5) then return 'u' end;
+  if (c < 12) then return 'x' end;
+  if (c < 18) then return 'n' end;
+  if (c < 24) then return 's' end;
+  return 't'
+end Letter;
+
+function IsVowel(c: char): boolean;
+begin
+  return (c = 'a') || (c = 'e') || (c = 'i') || (c = 'o') || (c = 'u')
+end IsVowel;
+
+function IsPalindrome(s: char[]; lo, hi: integer): boolean;
+begin
+  while (lo < hi) do
+    if (s[lo] # s[hi]) then return false end;
+    lo := lo + 1;
+    hi := hi - 1
+  end;
+  return true
+end IsPalindrome;
+
+procedure Reverse(s: char[]; n: integer);
+var i, j: integer;
+    c: char;
+begin
+  i := 0;
+  j := n - 1;
+  while (i < j) do
+    c := s[i]; s[i] := s[j]; s[j] := c;
+    i := i + 1;
+    j := j - 1
+  end
+end Reverse;
+
+procedure Analyze(s: char[]; n: integer);
+var i, start, words, vowels, palindromes: integer;
+begin
+  words := 0;
+  vowels := 0;
+  palindromes := 0;
+  start := -1;
+  i := 0;
+  while (i <= n) do
+    if ((i = n) || (s[i] = ' ')) then
+      if (start >= 0) then
+        words := words + 1;
+        if (IsPalindrome(s, start, i-1)) then
+          palindromes := palindromes + 1
+        end;
+        start := -1
+      end
+    else
+      if (start < 0) then start := i end;
+      if (IsVowel(s[i])) then vowels := vowels + 1 end
+    end;
+    i := i + 1
+  end;
+
+  WriteStr("words: "); WriteInt(words);
+  WriteStr(", vowels: "); WriteInt(vowels);
+  WriteStr(", palindromes: "); WriteInt(palindromes);
+  WriteLn()
+end Analyze;
+
+function Compare(a, b: char[]; n: integer): integer;
+var i, diff: integer;
+begin
+  diff := 0;
+  i := 0;
+  while (i < n) do
+    if (a[i] # b[n-1-i]) then diff := diff + 1 end;
+    i := i + 1
+  end;
+  return diff
+end Compare;
+
+begin
+  n := ReadInt();
+  rounds := ReadInt();
+  seed := 42;
+
+  i := 0;
+  while (i < n) do
+    text[i] := Letter();
+    copy[i] := text[i];
+    i := i + 1
+  end;
+
+  while (rounds > 0) do
+    Analyze(text, n);
+    Reverse(text, n);
+    rounds := rounds - 1
+  end;
+
+  WriteStr("differences: "); WriteInt(Compare(text, copy, n)); WriteLn()
+end strings.
@@ -0,0 +1,93 @@
+#!/usr/bin/env bash
+#
+# generated-code runtime benchmark
+#
+# compiles each kernel in bench/kernels with 'snuplc --exe' for every flag
+# set, runs it with the fixed input <kernel>.in, validates the output against
+# <kernel>.out and appends the wall time and the number of instructions
+# retired (if perf events are available) to the results file.
+#
+# usage: bench/runtime.sh [KERNEL...]
+#
+# environment:
+#   FLAGSETS  flag sets to compare, separated by ';'. Each entry has the form
+#             name:flags (default: "default:;optimize:--optimize", i.e., the
+#             default pipeline and all optimizations)
+#   RESULTS   results file (default: bench/runtime.results)
+#   REPEAT    number of runs per kernel; the fastest is recorded (default: 3)
+#
+
+BENCH=$(cd "$(dirname "$0")" && pwd)
+ROOT=$(dirname "$BENCH")
+SNUPLC=$ROOT/snuplc
+PERFSTAT=$ROOT/perfstat
+RTE=$(cd "$ROOT/../rte/IA32" && pwd)/
+KERNELS=$BENCH/kernels
+FLAGSETS=${FLAGSETS:-"default:;optimize:--optimize"}
+RESULTS=${RESULTS:-$BENCH/runtime.results}
+REPEAT=${REPEAT:-3}
+
+if [ ! -x "$SNUPLC" ] || [ ! -x "$PERFSTAT" ]; then
+  echo "build snuplc and perfstat first (make snuplc perfstat)."
+  exit 1
+fi
+
+if [ $# -gt 0 ]; then
+  kernels="$@"
+else
+  kernels=$(cd $KERNELS && ls *.mod | sed 's/\.mod$//')
+fi
+
+TMP=$(mktemp -d)
+trap "rm -rf $TMP" EXIT
+
+if [ ! -f $RESULTS ]; then
+  printf "# %-19s %-10s %-10s %-10s %-6s %10s %14s\n" \
+    date revision flags kernel status time instructions > $RESULTS
+fi
+
+date=$(date +%Y-%m-%dT%H:%M:%S)
+rev=$(cd $ROOT && git rev-parse --short HEAD 2>/dev/null || echo unknown)
+fail=0
+
+printf "%-10s %-10s %-6s %10s %14s\n" flags kernel status time instructions
+
+IFS=';' read -ra sets <<< "$FLAGSETS"
+for set in "${sets[@]}"; do
+  name=${set%%:*}
+  flags=${set#*:}
+
+  for k in $kernels; do
+    cp $KERNELS/$k.mod $TMP/$k.mod
+    rm -f $TMP/$k
+    (cd $TMP && $SNUPLC --exe --rte $RTE $flags $k.mod > $TMP/$k.log 2>&1)
+
+    status=ok
+    best=""
+    insn=n/a
+    if [ ! -x $TMP/$k ]; then
+      status=build
+    else
+      for ((r=0; r<REPEAT; r++)); do
+        $PERFSTAT -o $TMP/$k.perf $TMP/$k < $KERNELS/$k.in > $TMP/$k.output 2> $TMP/$k.stderr
+        t=$(awk '$1 == "time" { print $2 }' $TMP/$k.perf)
+        if [ -z "$best" ] || awk -v a=$t -v b=$best 'BEGIN { exit !(a < b) }'; then
+          best=$t
+          insn=$(awk '$1 == "instructions" { print $2 }' $TMP/$k.perf)
+        fi
+        if ! cmp -s $TMP/$k.output $KERNELS/$k.out; then
+          status=wrong
+          break
+        fi
+      done
+    fi
+
+    [ "$status" != ok ] && fail=1
+    line=$(printf "%-10s %-10s %-6s %10.4f %14s" $name $k $status ${best:-0} $insn)
+    echo "$line"
+    printf "  %-19s %-10s %s\n" $date $rev "$line" >> $RESULTS
+  done
+done
+
+echo "results appended to $RESULTS."
+exit $fail
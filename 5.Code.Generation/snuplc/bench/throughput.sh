@@ -0,0 +1,134 @@
+#!/usr/bin/env bash
+#
+# compiler throughput benchmark
+#
+# generates synthetic modules of increasing size with gen_module, compiles
+# them with 'snuplc --time-phases --keep-dead-procs' and reports the time
+# spent in each phase, lines/second and bytes of memory per line.
+#
+# The results are compared against bench/throughput.baseline. The script fails
+#  - if the scaling of the time per line relative to the smallest module or the
+#    memory per line grows by more than TOLERANCE (i.e., if the compiler becomes
+#    super-linear somewhere), or
+#  - if lines/s drops, or the time of a phase grows, by more than
+#    TIME_TOLERANCE (i.e., if the compiler becomes slower at any size). Runs
+#    and phases that take less than MIN_TIME seconds in the baseline are too
+#    noisy to compare and are skipped.
+# The absolute times depend on the machine; re-record the baseline with
+# --update when moving to a different host.
+#
+# usage: bench/throughput.sh [--update]
+#   --update   write the measured values to the baseline file
+#
+# environment:
+#   SIZES           module sizes in lines (default: "1000 10000 100000 1000000")
+#   TOLERANCE       allowed growth factor of the scaling and memory per line
+#                   w.r.t. the baseline (default: 2.0)
+#   TIME_TOLERANCE  allowed slowdown factor of lines/s and phase times
+#                   w.r.t. the baseline (default: 1.5)
+#   MIN_TIME        minimal run or phase time in seconds in the baseline to be
+#                   compared (default: 0.5)
+#
+
+BENCH=$(cd "$(dirname "$0")" && pwd)
+ROOT=$(dirname "$BENCH")
+SNUPLC=$ROOT/snuplc
+GEN=$ROOT/gen_module
+BASELINE=$BENCH/throughput.baseline
+SIZES=${SIZES:-"1000 10000 100000 1000000"}
+TOLERANCE=${TOLERANCE:-2.0}
+TIME_TOLERANCE=${TIME_TOLERANCE:-1.5}
+MIN_TIME=${MIN_TIME:-0.5}
+
+if [ ! -x "$SNUPLC" ] || [ ! -x "$GEN" ]; then
+  echo "build snuplc and gen_module first (make snuplc gen_module)."
+  exit 1
+fi
+
+TMP=$(mktemp -d)
+trap "rm -rf $TMP" EXIT
+
+RESULT=$TMP/result
+printf "# %8s %10s %10s %10s %10s %10s %12s %10s %10s\n" \
+  size lines parse ir backend total lines/s bytes/line scaling > $RESULT
+
+base_tpl=""
+for size in $SIZES; do
+  mod=$TMP/synthetic$size.mod
+  $GEN --lines $size > $mod
+  lines=$(wc -l < $mod)
+
+  # the procedures of the synthetic modules are never called; keep them so
+  # that the backend is measured on the whole module
+  $SNUPLC --time-phases --keep-dead-procs $mod > $TMP/log 2>&1
+  if [ ! -f $mod.s ]; then
+    echo "compilation of a $size line module failed:"
+    cat $TMP/log
+    exit 1
+  fi
+
+  phase() { awk -v p=$1 '$1 == "time" && $2 == p { print $3 }' $TMP/log; }
+  parse=$(phase parse); ir=$(phase ir); backend=$(phase backend); total=$(phase total)
+  kb=$(awk '$1 == "memory" && $2 == "peak" { print $3 }' $TMP/log)
+
+  # time per line, normalized to the smallest module
+  tpl=$(awk -v t=$total -v l=$lines 'BEGIN { printf "%.9f", t/l }')
+  [ -z "$base_tpl" ] && base_tpl=$tpl
+  awk -v s=$size -v l=$lines -v p=$parse -v i=$ir -v b=$backend -v t=$total \
+      -v kb=$kb -v tpl=$tpl -v btpl=$base_tpl 'BEGIN {
+    printf "  %8d %10d %10.4f %10.4f %10.4f %10.4f %12.0f %10.0f %10.2f\n",
+      s, l, p, i, b, t, (t > 0 ? l/t : 0), kb*1024/l, (btpl > 0 ? tpl/btpl : 1)
+  }' >> $RESULT
+
+  rm -f $mod $mod.s
+done
+
+cat $RESULT
+
+if [ "$1" == "--update" ]; then
+  cp $RESULT $BASELINE
+  echo "baseline updated."
+  exit 0
+fi
+
+if [ ! -f $BASELINE ]; then
+  echo "no baseline found; run '$0 --update' to create one."
+  exit 0
+fi
+
+# compare scaling, memory per line, lines/s and phase times with the baseline
+awk -v tol=$TOLERANCE -v ttol=$TIME_TOLERANCE -v mint=$MIN_TIME '
+  BEGIN { name[3] = "parse"; name[4] = "ir"; name[5] = "backend" }
+  FNR == 1 { next }
+  NR == FNR {
+    scaling[$1] = $9; bpl[$1] = $8; lps[$1] = $7; total[$1] = $6
+    for (c=3; c<=5; c++) t[$1, c] = $c
+    next
+  }
+  ($1 in scaling) {
+    if ((total[$1] >= mint) && ($7 * ttol < lps[$1])) {
+      printf "FAIL: %d lines: %d lines/s (baseline: %d)\n", $1, $7, lps[$1]
+      fail = 1
+    }
+    for (c=3; c<=5; c++) {
+      if ((t[$1, c] >= mint) && ($c > t[$1, c] * ttol)) {
+        printf "FAIL: %d lines: %s takes %.4f s (baseline: %.4f s)\n",
+          $1, name[c], $c, t[$1, c]
+        fail = 1
+      }
+    }
+    if ($9 > scaling[$1] * tol) {
+      printf "FAIL: %d lines: time per line scales by %.2f (baseline: %.2f)\n",
+        $1, $9, scaling[$1]
+      fail = 1
+    }
+    if ($8 > bpl[$1] * tol) {
+      printf "FAIL: %d lines: %d bytes per line (baseline: %d)\n",
+        $1, $8, bpl[$1]
+      fail = 1
+    }
+  }
+  END {
+    if (!fail) print "throughput OK."
+    exit fail
+  }' $BASELINE $RESULT
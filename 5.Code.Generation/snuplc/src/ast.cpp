@@ -35,12 +35,15 @@
 //------------------------------------------------------------------------------
 
 #include <iostream>
+#include <algorithm>
 #include <cassert>
+#include <climits>
 #include <cstring>
 
 #include <typeinfo>
 
 #include "ast.h"
+#include "remarks.h"
 using namespace std;
 
 
@@ -253,6 +256,7 @@ CTacAddr* CAstScope::ToTac(CCodeBlock *cb)
   CAstStatement *s = GetStatementSequence();
   while (s) {
     CTacLabel *next = cb->CreateLabel();
+    cb->SetLineNumber(s->GetToken().GetLineNumber());
     s->ToTac(cb, next);
     cb->AddInstr(next);
     s = s->GetNext();
@@ -275,6 +279,14 @@ void CAstScope::SetSymbolTable(CSymtab *st)
   _symtab = st;
 }
 
+void CAstScope::RemoveChild(CAstScope *child)
+{
+  vector<CAstScope*>::iterator it =
+    find(_children.begin(), _children.end(), child);
+  assert(it != _children.end());
+  _children.erase(it);
+}
+
 void CAstScope::AddChild(CAstScope *child)
 {
   _children.push_back(child);
@@ -393,6 +405,12 @@ CAstStatAssign::CAstStatAssign(CToken t,
   assert(rhs != NULL);
 }
 
+CAstStatAssign::~CAstStatAssign(void)
+{
+  delete _lhs;
+  delete _rhs;
+}
+
 CAstDesignator* CAstStatAssign::GetLHS(void) const
 {
   return _lhs;
@@ -519,6 +537,11 @@ CAstStatCall::CAstStatCall(CToken t, CAstFunctionCall *call)
   assert(call != NULL);
 }
 
+CAstStatCall::~CAstStatCall(void)
+{
+  delete _call;
+}
+
 CAstFunctionCall* CAstStatCall::GetCall(void) const
 {
   return _call;
@@ -584,6 +607,11 @@ CAstStatReturn::CAstStatReturn(CToken t, CAstScope *scope, CAstExpression *expr)
   assert(scope != NULL);
 }
 
+CAstStatReturn::~CAstStatReturn(void)
+{
+  delete _expr;
+}
+
 CAstScope* CAstStatReturn::GetScope(void) const
 {
   return _scope;
@@ -711,6 +739,13 @@ CAstStatIf::CAstStatIf(CToken t, CAstExpression *cond,
   assert(cond != NULL);
 }
 
+CAstStatIf::~CAstStatIf(void)
+{
+  delete _cond;
+  delete _ifBody;
+  delete _elseBody;
+}
+
 CAstExpression* CAstStatIf::GetCondition(void) const
 {
   return _cond;
@@ -859,26 +894,404 @@ CTacAddr* CAstStatIf::ToTac(CCodeBlock *cb, CTacLabel *next)
   cb->AddInstr(nextTrue);
   while (ifBody) {
     CTacLabel *nextIfBody = cb->CreateLabel();
+    cb->SetLineNumber(ifBody->GetToken().GetLineNumber());
     ifBody->ToTac(cb, nextIfBody);
     cb->AddInstr(nextIfBody);
     ifBody = ifBody->GetNext();
   }
+  cb->SetLineNumber(GetToken().GetLineNumber());
   cb->AddInstr(new CTacInstr(opGoto, next, NULL, NULL));
 
   cb->AddInstr(nextFalse);
   while (elseBody) {
     CTacLabel *nextElseBody = cb->CreateLabel();
+    cb->SetLineNumber(elseBody->GetToken().GetLineNumber());
     elseBody->ToTac(cb, nextElseBody);
     cb->AddInstr(nextElseBody);
     elseBody = elseBody->GetNext();
   }
 
+  cb->SetLineNumber(GetToken().GetLineNumber());
   cb->AddInstr(new CTacInstr(opGoto, next, NULL, NULL));
 
   return NULL;
 }
 
 
+//------------------------------------------------------------------------------
+// CAstStatCase
+//
+CAstStatCase::CAstStatCase(CToken t, CAstExpression *selector)
+  : CAstStatement(t), _selector(selector), _elseBody(NULL)
+{
+  assert(selector != NULL);
+}
+
+CAstStatCase::~CAstStatCase(void)
+{
+  delete _selector;
+  for (size_t k=0; k<_labels.size(); k++) {
+    for (const auto &l : _labels[k]) {
+      delete l.first;
+      delete l.second;
+    }
+    delete _bodies[k];
+  }
+  delete _elseBody;
+}
+
+CAstExpression* CAstStatCase::GetSelector(void) const
+{
+  return _selector;
+}
+
+void CAstStatCase::AddArm(const vector<CaseLabel> &labels, CAstStatement *body)
+{
+  assert(labels.size() > 0);
+
+  _labels.push_back(labels);
+  _bodies.push_back(body);
+}
+
+int CAstStatCase::GetNArms(void) const
+{
+  return (int)_labels.size();
+}
+
+const vector<CAstStatCase::CaseLabel>& CAstStatCase::GetLabels(int index) const
+{
+  assert((index >= 0) && (index < (int)_labels.size()));
+  return _labels[index];
+}
+
+CAstStatement* CAstStatCase::GetBody(int index) const
+{
+  assert((index >= 0) && (index < (int)_bodies.size()));
+  return _bodies[index];
+}
+
+void CAstStatCase::SetElseBody(CAstStatement *elseBody)
+{
+  _elseBody = elseBody;
+}
+
+CAstStatement* CAstStatCase::GetElseBody(void) const
+{
+  return _elseBody;
+}
+
+bool CAstStatCase::TypeCheck(CToken *t, string *msg) const
+{
+  ostringstream out;
+  CAstExpression *sel = GetSelector();
+  CTypeManager *tm = CTypeManager::Get();
+
+  // Type check for selector expression
+  if (!sel->TypeCheck(t, msg))
+    return false;
+
+  // check whether its type is integer or char type
+  const CType *st = sel->GetType();
+  if (!st || !(st->Match(tm->GetInt()) || st->Match(tm->GetChar()))) {
+    if (t) *t = sel->GetToken();
+    if (msg) {
+      out << "case selector should be integer or char type, but ";
+      if (st) out << st;
+      else out << "<INVALID>";
+      out << " appeared" << endl;
+      *msg = out.str();
+    }
+    return false;
+  }
+
+  // labels must be constants of the selector's type, ranges must not be
+  // empty and no value may select more than one arm
+  vector<pair<pair<long long, long long>, CAstConstant*> > values;
+  for (const auto &labels : _labels) {
+    for (const auto &l : labels) {
+      for (CAstConstant *c : { l.first, l.second }) {
+        if (c == NULL) continue;
+        if (!c->TypeCheck(t, msg))
+          return false;
+        if (!c->GetType()->Match(st)) {
+          if (t) *t = c->GetToken();
+          if (msg) {
+            out << "case label should be " << st << " type, but "
+                << c->GetType() << " appeared" << endl;
+            *msg = out.str();
+          }
+          return false;
+        }
+      }
+
+      long long low = l.first->GetValue();
+      long long high = l.second != NULL ? l.second->GetValue() : low;
+      if (low > high) {
+        if (t) *t = l.first->GetToken();
+        if (msg) *msg = "empty case label range.";
+        return false;
+      }
+      values.push_back(make_pair(make_pair(low, high), l.first));
+    }
+  }
+
+  sort(values.begin(), values.end());
+  for (size_t i=1; i<values.size(); i++) {
+    if (values[i].first.first <= values[i-1].first.second) {
+      if (t) *t = values[i].second->GetToken();
+      if (msg) *msg = "duplicate case label.";
+      return false;
+    }
+  }
+
+  // Type check for statements in the arms and the else-body (can be empty)
+  vector<CAstStatement*> bodies = _bodies;
+  bodies.push_back(_elseBody);
+  for (CAstStatement *body : bodies) {
+    while (body) {
+      if (!body->TypeCheck(t, msg))
+        return false;
+      body = body->GetNext();
+    }
+  }
+
+  return true;
+}
+
+ostream& CAstStatCase::print(ostream &out, int indent) const
+{
+  string ind(indent, ' ');
+
+  out << ind << "case selector" << endl;
+  _selector->print(out, indent+2);
+  for (size_t k=0; k<_labels.size(); k++) {
+    out << ind << "case-arm";
+    for (size_t j=0; j<_labels[k].size(); j++) {
+      const CaseLabel &l = _labels[k][j];
+      out << (j == 0 ? " " : ", ") << l.first->GetValueStr();
+      if (l.second != NULL) out << ".." << l.second->GetValueStr();
+    }
+    out << endl;
+    if (_bodies[k] != NULL) {
+      CAstStatement *s = _bodies[k];
+      do {
+        s->print(out, indent+2);
+        s = s->GetNext();
+      } while (s != NULL);
+    } else out << ind << "  empty." << endl;
+  }
+  out << ind << "else-body" << endl;
+  if (_elseBody != NULL) {
+    CAstStatement *s = _elseBody;
+    do {
+      s->print(out, indent+2);
+      s = s->GetNext();
+    } while (s != NULL);
+  } else out << ind << "  empty." << endl;
+
+  return out;
+}
+
+string CAstStatCase::dotAttr(void) const
+{
+  return " [label=\"case\",shape=box]";
+}
+
+void CAstStatCase::toDot(ostream &out, int indent) const
+{
+  string ind(indent, ' ');
+
+  CAstNode::toDot(out, indent);
+
+  _selector->toDot(out, indent);
+  out << ind << dotID() << "->" << _selector->dotID() << ";" << endl;
+
+  vector<CAstStatement*> bodies = _bodies;
+  bodies.push_back(_elseBody);
+  for (CAstStatement *s : bodies) {
+    string prev = dotID();
+    while (s != NULL) {
+      s->toDot(out, indent);
+      out << ind << prev << " -> " << s->dotID() << " [style=dotted];"
+          << endl;
+      prev = s->dotID();
+      s = s->GetNext();
+    }
+  }
+}
+
+CTacAddr* CAstStatCase::ToTac(CCodeBlock *cb, CTacLabel *next)
+{
+  /* The TAC of CAstStatCase has the form as following;
+   *
+   *   (dispatch of the selector to case_1..case_n or case_else)
+   * case_1:
+   *   (statement sequence of arm 1)
+   *   goto next
+   *   ...
+   * case_else:
+   *   (elseBody statement sequence)
+   *   goto next
+   *
+   * The sorted label ranges are grouped into clusters. A cluster of at
+   * least MinTableRanges ranges that covers at least MinTableDensity percent
+   * of its span is dispatched through a jump table (opSwitch), all other
+   * ranges by compares. More than MaxLinearTests clusters are searched
+   * binarily.
+   */
+  CTacAddr *sel = GetSelector()->ToTac(cb);
+  if (dynamic_cast<CTacReference*>(sel) != NULL) {
+    // the selector is compared several times; load array elements once
+    CTacTemp *tmp = cb->CreateTemp(GetSelector()->GetType());
+    cb->AddInstr(new CTacInstr(opAssign, tmp, sel));
+    sel = tmp;
+  }
+
+  vector<CTacLabel*> arms;
+  vector<SRange> ranges;
+  for (size_t k=0; k<_labels.size(); k++) {
+    arms.push_back(cb->CreateLabel("case"));
+    for (const auto &l : _labels[k]) {
+      long long low = l.first->GetValue();
+      long long high = l.second != NULL ? l.second->GetValue() : low;
+      ranges.push_back({ low, high, arms[k] });
+    }
+  }
+  CTacLabel *deflt = _elseBody != NULL ? cb->CreateLabel("case_else") : next;
+
+  // sort the ranges and merge adjacent ones with the same target
+  sort(ranges.begin(), ranges.end(),
+       [](const SRange &a, const SRange &b) { return a.low < b.low; });
+  vector<SRange> merged;
+  for (const auto &r : ranges) {
+    if (!merged.empty() && (merged.back().high + 1 == r.low) &&
+        (merged.back().target == r.target)) merged.back().high = r.high;
+    else merged.push_back(r);
+  }
+  ranges.swap(merged);
+
+  // cluster the ranges greedily from the lowest one: a jump table extends
+  // as far as it is dense enough
+  vector<SCluster> clusters;
+  int ntables = 0;
+  for (size_t i=0; i<ranges.size(); ) {
+    size_t last = i;
+    long long covered = 0;
+    for (size_t j=i; j<ranges.size(); j++) {
+      long long span = ranges[j].high - ranges[i].low + 1;
+      if (span > MaxTableSpan) break;
+      covered += ranges[j].high - ranges[j].low + 1;
+      if ((j-i+1 >= MinTableRanges) && (100*covered >= MinTableDensity*span))
+        last = j;
+    }
+    clusters.push_back({ i, last, last > i });
+    if (last > i) ntables++;
+    i = last + 1;
+  }
+
+  cb->SetLineNumber(GetToken().GetLineNumber());
+  Dispatch(cb, sel, ranges, clusters, 0, clusters.size(),
+           INT_MIN, INT_MAX, deflt);
+
+  CRemarks *rm = CRemarks::Get();
+  if (rm->IsEnabled(rkPassed)) {
+    ostringstream msg;
+    msg << "case statement with " << ranges.size() << " label range(s) "
+        << "dispatched by " << ntables << " jump table(s) and "
+        << clusters.size() - ntables << " compare(s)";
+    if (clusters.size() > MaxLinearTests) msg << " in a binary search";
+    rm->Add(rkPassed, "lowering", cb->GetName(), cb->GetLineNumber(),
+            msg.str());
+  }
+
+  // arms
+  vector<CAstStatement*> bodies = _bodies;
+  if (_elseBody != NULL) {
+    arms.push_back(deflt);
+    bodies.push_back(_elseBody);
+  }
+  for (size_t k=0; k<arms.size(); k++) {
+    cb->AddInstr(arms[k]);
+    CAstStatement *body = bodies[k];
+    while (body) {
+      CTacLabel *nextBody = cb->CreateLabel();
+      cb->SetLineNumber(body->GetToken().GetLineNumber());
+      body->ToTac(cb, nextBody);
+      cb->AddInstr(nextBody);
+      body = body->GetNext();
+    }
+    cb->SetLineNumber(GetToken().GetLineNumber());
+    cb->AddInstr(new CTacInstr(opGoto, next, NULL, NULL));
+  }
+
+  return NULL;
+}
+
+void CAstStatCase::Dispatch(CCodeBlock *cb, CTacAddr *sel,
+                            const vector<SRange> &ranges,
+                            const vector<SCluster> &clusters,
+                            size_t from, size_t to,
+                            long long minv, long long maxv,
+                            CTacLabel *deflt) const
+{
+  // binary search: split the clusters at the low bound of the middle one
+  if (to - from > MaxLinearTests) {
+    size_t mid = (from + to) / 2;
+    long long pivot = ranges[clusters[mid].first].low;
+    CTacLabel *lower = cb->CreateLabel("case_lt");
+
+    cb->AddInstr(new CTacInstr(opLessThan, lower, sel, new CTacConst(pivot)));
+    Dispatch(cb, sel, ranges, clusters, mid, to, pivot, maxv, deflt);
+    cb->AddInstr(lower);
+    Dispatch(cb, sel, ranges, clusters, from, mid, minv, pivot-1, deflt);
+    return;
+  }
+
+  // linear tests in ascending order; values below the tested cluster that
+  // were not dispatched yet select no arm
+  for (size_t c=from; c<to; c++) {
+    const SCluster &cl = clusters[c];
+    const SRange &r = ranges[cl.first];
+
+    if (cl.table) {
+      long long low = r.low, high = ranges[cl.last].high;
+      vector<CTacLabel*> targets(high - low + 1, deflt);
+      for (size_t k=cl.first; k<=cl.last; k++) {
+        for (long long v=ranges[k].low; v<=ranges[k].high; v++) {
+          targets[v - low] = ranges[k].target;
+        }
+      }
+      cb->AddInstr(new CTacSwitch(sel, low, targets));
+      if (minv >= low) minv = high + 1;
+    } else if (r.low == r.high) {
+      if ((minv == r.low) && (maxv == r.low)) {
+        cb->AddInstr(new CTacInstr(opGoto, r.target));
+        return;
+      }
+      cb->AddInstr(new CTacInstr(opEqual, r.target, sel, new CTacConst(r.low)));
+      if (minv == r.low) minv++;
+      if (maxv == r.low) maxv--;
+    } else {
+      if (minv < r.low) {
+        cb->AddInstr(new CTacInstr(opLessThan, deflt, sel,
+                                   new CTacConst(r.low)));
+        minv = r.low;
+      }
+      if (maxv <= r.high) {
+        cb->AddInstr(new CTacInstr(opGoto, r.target));
+        return;
+      }
+      cb->AddInstr(new CTacInstr(opLessEqual, r.target, sel,
+                                 new CTacConst(r.high)));
+      minv = r.high + 1;
+    }
+    if (minv > maxv) return;
+  }
+
+  cb->AddInstr(new CTacInstr(opGoto, deflt));
+}
+
+
 //------------------------------------------------------------------------------
 // CAstStatWhile
 //
@@ -889,6 +1302,12 @@ CAstStatWhile::CAstStatWhile(CToken t,
   assert(cond != NULL);
 }
 
+CAstStatWhile::~CAstStatWhile(void)
+{
+  delete _cond;
+  delete _body;
+}
+
 CAstExpression* CAstStatWhile::GetCondition(void) const
 {
   return _cond;
@@ -988,28 +1407,33 @@ CTacAddr* CAstStatWhile::ToTac(CCodeBlock *cb, CTacLabel *next)
 
   /* The TAC of CAstStatWhile has the form as follwing;
    *
+   *   goto while_cond
+   * while_body:
+   *   (whileBody statement sequence)
    * while_cond:
    *   if (the condition is true) goto while_body
    *   goto next
-   * while_body:
-   *   (whileBody statement sequence)
-   *   goto while_cond
    * next:
+   *
+   * The loop is rotated: the condition is tested at the bottom and every
+   * iteration executes a single conditional branch. The final "goto next"
+   * is part of the condition's jumping code.
    */
 
-  cb->AddInstr(cond);
-  GetCondition()->ToTac(cb, body, next);
+  cb->AddInstr(new CTacInstr(opGoto, cond, NULL, NULL));
 
   cb->AddInstr(body);
   while (bodyStat) {
     CTacLabel *nextBody = cb->CreateLabel();
+    cb->SetLineNumber(bodyStat->GetToken().GetLineNumber());
     bodyStat->ToTac(cb, nextBody);
     cb->AddInstr(nextBody);
     bodyStat = bodyStat->GetNext();
   }
 
-  cb->AddInstr(new CTacInstr(opGoto, cond, NULL, NULL));
-  cb->AddInstr(new CTacInstr(opGoto, next, NULL, NULL));
+  cb->SetLineNumber(GetToken().GetLineNumber());
+  cb->AddInstr(cond);
+  GetCondition()->ToTac(cb, body, next);
 
   return NULL;
 }
@@ -1062,6 +1486,7 @@ CAstBinaryOp::CAstBinaryOp(CToken t, EOperation oper,
   // these are the only binary operation we support for now
   assert((oper == opAdd)        || (oper == opSub)         ||
          (oper == opMul)        || (oper == opDiv)         ||
+         (oper == opMod)        ||
          (oper == opAnd)        || (oper == opOr)          ||
          (oper == opEqual)      || (oper == opNotEqual)    ||
          (oper == opLessThan)   || (oper == opLessEqual)   ||
@@ -1071,6 +1496,12 @@ CAstBinaryOp::CAstBinaryOp(CToken t, EOperation oper,
   assert(r != NULL);
 }
 
+CAstBinaryOp::~CAstBinaryOp(void)
+{
+  delete _left;
+  delete _right;
+}
+
 CAstExpression* CAstBinaryOp::GetLeft(void) const
 {
   return _left;
@@ -1147,6 +1578,7 @@ bool CAstBinaryOp::TypeCheck(CToken *t, string *msg) const
     case opSub:
     case opMul:
     case opDiv:
+    case opMod:
       if (!lt->Match(tm->GetInt())) {
         if (t) *t = lhs->GetToken();
         if (msg) {
@@ -1215,6 +1647,7 @@ const CType* CAstBinaryOp::GetType(void) const
     case opSub:
     case opMul:
     case opDiv:
+    case opMod:
       ret = CTypeManager::Get()->GetInt();
       break;
     case opAnd:
@@ -1276,10 +1709,20 @@ CTacAddr* CAstBinaryOp::ToTac(CCodeBlock *cb)
   EOperation oper = GetOperation();
   CTypeManager *tm = CTypeManager::Get();
 
-  /* when oper == "+", "-", "*", or "/",
+  /* when oper == "+", "-", "*", "/", or "mod",
    * the expression is an integer type
    */
-  if (oper == opAdd || oper == opSub || oper == opMul || oper == opDiv) {
+  if (oper == opAdd || oper == opSub || oper == opMul || oper == opDiv ||
+      oper == opMod) {
+    /* x - x/y*y computes the remainder */
+    CAstExpression *x, *y;
+    if ((oper == opSub) && IsTruncation(right, x, y) && SameValue(left, x)) {
+      RemainderIdiom(cb, "x - x/y*y");
+      CTacTemp *val = cb->CreateTemp(tm->GetInt());
+      cb->AddInstr(new CTacInstr(opMod, val, x->ToTac(cb), y->ToTac(cb)));
+      return val;
+    }
+
     CTacAddr *leftTac = left->ToTac(cb), *rightTac = right->ToTac(cb);
     CTacTemp *val = cb->CreateTemp(tm->GetInt());
     cb->AddInstr(new CTacInstr(oper, val, leftTac, rightTac));
@@ -1308,7 +1751,18 @@ CTacAddr* CAstBinaryOp::ToTac(CCodeBlock *cb,
   CAstExpression *left = GetLeft(), *right = GetRight();
   CTacLabel *nextCond = cb->CreateLabel();
 
-  if (IsRelOp(oper)) {
+  /* x/y*y = x (or #) tests whether y divides x */
+  CAstExpression *x, *y;
+  if (((oper == opEqual) || (oper == opNotEqual)) &&
+      ((IsTruncation(left, x, y) && SameValue(right, x)) ||
+       (IsTruncation(right, x, y) && SameValue(left, x)))) {
+    RemainderIdiom(cb, "x/y*y " + string(oper == opEqual ? "=" : "#") + " x");
+    CTacTemp *rem = cb->CreateTemp(CTypeManager::Get()->GetInt());
+    cb->AddInstr(new CTacInstr(opMod, rem, x->ToTac(cb), y->ToTac(cb)));
+    cb->AddInstr(new CTacInstr(oper, ltrue, rem, new CTacConst(0)));
+    cb->AddInstr(new CTacInstr(opGoto, lfalse));
+  }
+  else if (IsRelOp(oper)) {
     cb->AddInstr(new CTacInstr(oper, ltrue, left->ToTac(cb), right->ToTac(cb)));
     cb->AddInstr(new CTacInstr(opGoto, lfalse));
   }
@@ -1344,6 +1798,82 @@ CTacAddr* CAstBinaryOp::ToTac(CCodeBlock *cb,
 }
 
 
+bool CAstBinaryOp::IsTruncation(CAstExpression *e, CAstExpression *&x,
+                                CAstExpression *&y)
+{
+  CAstBinaryOp *mul = dynamic_cast<CAstBinaryOp*>(e);
+  if ((mul == NULL) || (mul->GetOperation() != opMul)) return false;
+
+  for (int k=0; k<2; k++) {
+    CAstBinaryOp *div = dynamic_cast<CAstBinaryOp*>(
+                          k == 0 ? mul->GetLeft() : mul->GetRight());
+    CAstExpression *f = k == 0 ? mul->GetRight() : mul->GetLeft();
+
+    if ((div != NULL) && (div->GetOperation() == opDiv) &&
+        SameValue(div->GetRight(), f)) {
+      x = div->GetLeft();
+      y = div->GetRight();
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool CAstBinaryOp::SameValue(const CAstExpression *a, const CAstExpression *b)
+{
+  if ((a == NULL) || (b == NULL) || (typeid(*a) != typeid(*b))) return false;
+
+  const CAstConstant *ca = dynamic_cast<const CAstConstant*>(a);
+  if (ca != NULL) {
+    return ca->GetValue() == dynamic_cast<const CAstConstant*>(b)->GetValue();
+  }
+
+  const CAstArrayDesignator *aa = dynamic_cast<const CAstArrayDesignator*>(a);
+  if (aa != NULL) {
+    const CAstArrayDesignator *ab = dynamic_cast<const CAstArrayDesignator*>(b);
+    if ((aa->GetSymbol() != ab->GetSymbol()) ||
+        (aa->GetNIndices() != ab->GetNIndices())) return false;
+    for (int i=0; i<aa->GetNIndices(); i++) {
+      if (!SameValue(aa->GetIndex(i), ab->GetIndex(i))) return false;
+    }
+    return true;
+  }
+
+  const CAstDesignator *da = dynamic_cast<const CAstDesignator*>(a);
+  if (da != NULL) {
+    return da->GetSymbol() == dynamic_cast<const CAstDesignator*>(b)->GetSymbol();
+  }
+
+  const CAstUnaryOp *ua = dynamic_cast<const CAstUnaryOp*>(a);
+  if (ua != NULL) {
+    const CAstUnaryOp *ub = dynamic_cast<const CAstUnaryOp*>(b);
+    return (ua->GetOperation() == ub->GetOperation()) &&
+           SameValue(ua->GetOperand(), ub->GetOperand());
+  }
+
+  const CAstBinaryOp *ba = dynamic_cast<const CAstBinaryOp*>(a);
+  if (ba != NULL) {
+    const CAstBinaryOp *bb = dynamic_cast<const CAstBinaryOp*>(b);
+    return (ba->GetOperation() == bb->GetOperation()) &&
+           SameValue(ba->GetLeft(), bb->GetLeft()) &&
+           SameValue(ba->GetRight(), bb->GetRight());
+  }
+
+  // function calls, strings, special operations
+  return false;
+}
+
+void CAstBinaryOp::RemainderIdiom(CCodeBlock *cb, string idiom) const
+{
+  CRemarks *rm = CRemarks::Get();
+  if (rm->IsEnabled(rkPassed)) {
+    rm->Add(rkPassed, "lowering", cb->GetName(), cb->GetLineNumber(),
+            "'" + idiom + "' computed with a single remainder operation");
+  }
+}
+
+
 //------------------------------------------------------------------------------
 // CAstUnaryOp
 //
@@ -1354,6 +1884,11 @@ CAstUnaryOp::CAstUnaryOp(CToken t, EOperation oper, CAstExpression *e)
   assert(e != NULL);
 }
 
+CAstUnaryOp::~CAstUnaryOp(void)
+{
+  delete _operand;
+}
+
 CAstExpression* CAstUnaryOp::GetOperand(void) const
 {
   return _operand;
@@ -1497,6 +2032,14 @@ CTacAddr* CAstUnaryOp::ToTac(CCodeBlock *cb)
       if (oper == opNeg)
         val = -val;
       CTacConst *numTac = new CTacConst(val);
+
+      CRemarks *rm = CRemarks::Get();
+      if (rm->IsEnabled(rkPassed)) {
+        ostringstream msg;
+        msg << "folded unary " << oper << " of constant into " << val;
+        rm->Add(rkPassed, "lowering", cb->GetName(), cb->GetLineNumber(),
+                msg.str());
+      }
       return numTac;
     }
   }
@@ -1546,6 +2089,11 @@ CAstSpecialOp::CAstSpecialOp(CToken t, EOperation oper, CAstExpression *e,
          ((oper == opCast) && (type != NULL)));
 }
 
+CAstSpecialOp::~CAstSpecialOp(void)
+{
+  delete _operand;
+}
+
 CAstExpression* CAstSpecialOp::GetOperand(void) const
 {
   return _operand;
@@ -1658,6 +2206,11 @@ CAstFunctionCall::CAstFunctionCall(CToken t, const CSymProc *symbol)
   assert(symbol != NULL);
 }
 
+CAstFunctionCall::~CAstFunctionCall(void)
+{
+  for (size_t i=0; i<_arg.size(); i++) delete _arg[i];
+}
+
 const CSymProc* CAstFunctionCall::GetSymbol(void) const
 {
   return _symbol;
@@ -1888,6 +2441,11 @@ CAstArrayDesignator::CAstArrayDesignator(CToken t, const CSymbol *symbol)
 {
 }
 
+CAstArrayDesignator::~CAstArrayDesignator(void)
+{
+  for (size_t i=0; i<_idx.size(); i++) delete _idx[i];
+}
+
 void CAstArrayDesignator::AddIndex(CAstExpression *idx)
 {
   assert(!_done);
@@ -2209,6 +2767,13 @@ CTacAddr* CAstConstant::ToTac(CCodeBlock *cb,
 {
   long long cond = GetValue();
 
+  CRemarks *rm = CRemarks::Get();
+  if (rm->IsEnabled(rkPassed)) {
+    rm->Add(rkPassed, "lowering", cb->GetName(), cb->GetLineNumber(),
+            string("constant condition '") + GetValueStr() +
+            "' lowered to an unconditional branch");
+  }
+
   if (cond)
     cb->AddInstr(new CTacInstr(opGoto, ltrue, NULL, NULL));
   else
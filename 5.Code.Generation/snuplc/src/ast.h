@@ -190,6 +190,9 @@ class CAstScope : public CAstNode {
     /// @brief return the @a i-th subordinate scope
     CAstScope* GetChild(size_t i) const;
 
+    /// @brief remove the subordinate scope @a child (it is not deleted)
+    void RemoveChild(CAstScope *child);
+
     /// @brief get the symbol table for this scope
     CSymtab* GetSymbolTable(void) const;
 
@@ -457,6 +460,7 @@ class CAstStatAssign : public CAstStatement {
     /// @param lhs left-hand side of assignment (designator)
     /// @param rhs right-hand side of assignment (expression)
     CAstStatAssign(CToken t, CAstDesignator *lhs, CAstExpression *rhs);
+    virtual ~CAstStatAssign(void);
 
     /// @}
 
@@ -537,6 +541,7 @@ class CAstStatCall : public CAstStatement {
     /// @param t token in input stream (used for error reporting purposes)
     /// @param call function call node
     CAstStatCall(CToken t, CAstFunctionCall *call);
+    virtual ~CAstStatCall(void);
 
     /// @}
 
@@ -613,6 +618,7 @@ class CAstStatReturn : public CAstStatement {
     /// @param s enclosing scope (needed for type checking)
     /// @param expr returned expression (or NULL)
     CAstStatReturn(CToken t, CAstScope *scope, CAstExpression *expr);
+    virtual ~CAstStatReturn(void);
 
     /// @}
 
@@ -695,6 +701,7 @@ class CAstStatIf : public CAstStatement {
     /// @param elseBody statement list of else-body
     CAstStatIf(CToken t, CAstExpression *cond,
                CAstStatement *ifBody, CAstStatement *elseBody);
+    virtual ~CAstStatIf(void);
 
     /// @}
 
@@ -761,6 +768,134 @@ class CAstStatIf : public CAstStatement {
 };
 
 
+//------------------------------------------------------------------------------
+/// @brief AST case statement node
+///
+/// node representing a case statement. Each arm is selected by a list of
+/// constant labels, a label is either a single value or a range low..high.
+/// Dense sets of labels are dispatched through a jump table, sparse sets by
+/// a binary search over the labels.
+///
+
+class CAstStatCase : public CAstStatement {
+  public:
+    /// @brief a case label: a single value (second == NULL) or a range
+    typedef pair<CAstConstant*, CAstConstant*> CaseLabel;
+
+    /// @name constructors/destructors
+    /// @{
+
+    /// @param t token in input stream (used for error reporting purposes)
+    /// @param selector case selector (expression)
+    CAstStatCase(CToken t, CAstExpression *selector);
+    virtual ~CAstStatCase(void);
+
+    /// @}
+
+    /// @name property manipulation
+    /// @{
+
+    /// @brief return the case selector
+    /// @retval CAstExpression* case selector
+    CAstExpression* GetSelector(void) const;
+
+    /// @brief add an arm
+    /// @param labels labels selecting the arm
+    /// @param body statement list of the arm
+    void AddArm(const vector<CaseLabel> &labels, CAstStatement *body);
+
+    /// @brief return the number of arms
+    /// @retval int number of arms
+    int GetNArms(void) const;
+
+    /// @brief return the labels of arm @a index
+    const vector<CaseLabel>& GetLabels(int index) const;
+
+    /// @brief return the body of arm @a index
+    /// @retval CAstStatement* statement list of the arm
+    CAstStatement* GetBody(int index) const;
+
+    /// @brief set the else-body
+    /// @param elseBody statement list executed if no label matches
+    void SetElseBody(CAstStatement *elseBody);
+
+    /// @brief return the else-body
+    /// @retval CAstStatement* else-body statement sequence
+    CAstStatement* GetElseBody(void) const;
+
+    /// @}
+
+    /// @name type management
+    /// @{
+
+    /// @brief perform type checking
+    /// @param t (out, optional) type error at token t
+    /// @param msg (out, optional) type error message
+    /// @retval true if no type error has been found
+    /// @retval false otherwise
+    virtual bool TypeCheck(CToken *t, string *msg) const;
+
+    /// @}
+
+    /// @name output
+    /// @{
+
+    /// @brief print the node to an output stream
+    /// @param out output stream
+    /// @param indent indentation
+    virtual ostream&  print(ostream &out, int indent=0) const;
+
+    /// @brief return the node's attributes in (dot) string format
+    /// @retval string node attributes as a string
+    virtual string dotAttr(void) const;
+
+    /// @brief print the node in dot format to an output stream
+    /// @param out output stream
+    /// @param indent indentation
+    virtual void toDot(ostream &out, int indent=0) const;
+
+    /// @}
+
+
+    /// @name transformation into TAC
+    /// @{
+
+    virtual CTacAddr* ToTac(CCodeBlock *cb, CTacLabel *next);
+
+    /// @}
+
+  private:
+    /// @brief a range of values dispatched to the same target
+    struct SRange {
+      long long low, high;          ///< values low..high
+      CTacLabel *target;            ///< target
+    };
+
+    /// @brief a cluster of consecutive ranges dispatched by one test
+    struct SCluster {
+      size_t first, last;           ///< ranges first..last
+      bool table;                   ///< dispatched through a jump table
+    };
+
+    /// @brief emit the dispatch of @a sel to clusters @a from..@a to-1
+    /// @param minv,maxv known bounds of the value of @a sel
+    void Dispatch(CCodeBlock *cb, CTacAddr *sel,
+                  const vector<SRange> &ranges,
+                  const vector<SCluster> &clusters, size_t from, size_t to,
+                  long long minv, long long maxv, CTacLabel *deflt) const;
+
+    CAstExpression *_selector;      ///< selector
+    vector<vector<CaseLabel> > _labels; ///< labels of the arms
+    vector<CAstStatement*> _bodies; ///< bodies of the arms
+    CAstStatement *_elseBody;       ///< else body
+
+    static const int MinTableRanges = 4; ///< min. #ranges of a jump table
+    static const int MinTableDensity = 40; ///< min. % of covered values
+    static const int MaxTableSpan = 1024; ///< max. #entries of a jump table
+    static const int MaxLinearTests = 3; ///< max. #clusters tested linearly
+};
+
+
 //------------------------------------------------------------------------------
 /// @brief AST while statement node
 ///
@@ -776,6 +911,7 @@ class CAstStatWhile : public CAstStatement {
     /// @param cond while condition (expression)
     /// @param body statement list of body
     CAstStatWhile(CToken t, CAstExpression *cond, CAstStatement *body);
+    virtual ~CAstStatWhile(void);
 
     /// @}
 
@@ -922,6 +1058,7 @@ class CAstBinaryOp : public CAstOperation {
     /// @param l left operand
     /// @param r right operand
     CAstBinaryOp(CToken t, EOperation o, CAstExpression *l, CAstExpression *r);
+    virtual ~CAstBinaryOp(void);
 
     /// @}
 
@@ -982,6 +1119,25 @@ class CAstBinaryOp : public CAstOperation {
 
     /// @}
 
+  protected:
+    /// @name remainder idioms
+    /// @{
+
+    /// @brief returns true if @a e has the form "x/y*y" or "y*(x/y)"
+    /// @param x (out) dividend
+    /// @param y (out) divisor
+    static bool IsTruncation(CAstExpression *e, CAstExpression *&x,
+                             CAstExpression *&y);
+
+    /// @brief returns true if @a a and @a b are free of side effects and
+    ///        always evaluate to the same value
+    static bool SameValue(const CAstExpression *a, const CAstExpression *b);
+
+    /// @brief report that @a idiom has been replaced by a remainder
+    void RemainderIdiom(CCodeBlock *cb, string idiom) const;
+
+    /// @}
+
   private:
     CAstExpression *_left;          ///< left operand
     CAstExpression *_right;         ///< right operand
@@ -1003,6 +1159,7 @@ class CAstUnaryOp : public CAstOperation {
     /// @param o (unary) operation
     /// @param e operand
     CAstUnaryOp(CToken t, EOperation o, CAstExpression *e);
+    virtual ~CAstUnaryOp(void);
 
     /// @}
 
@@ -1082,6 +1239,7 @@ class CAstSpecialOp : public CAstOperation {
     /// @param type type (ignored except for opCast operations)
     CAstSpecialOp(CToken t, EOperation o, CAstExpression *e,
                   const CType *type=NULL);
+    virtual ~CAstSpecialOp(void);
 
     /// @}
 
@@ -1159,6 +1317,7 @@ class CAstFunctionCall : public CAstExpression {
     /// @param t token in input stream (used for error reporting purposes)
     /// @param symbol symbol of function to call
     CAstFunctionCall(CToken t, const CSymProc *symbol);
+    virtual ~CAstFunctionCall(void);
 
     /// @}
 
@@ -1338,6 +1497,7 @@ class CAstArrayDesignator : public CAstDesignator {
     /// @param t token in input stream (used for error reporting purposes)
     /// @param symbol variable symbol
     CAstArrayDesignator(CToken t, const CSymbol *symbol);
+    virtual ~CAstArrayDesignator(void);
 
     /// @}
 
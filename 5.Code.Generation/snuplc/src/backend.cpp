@@ -33,14 +33,29 @@
 //------------------------------------------------------------------------------
 
 #include <fstream>
+#include <algorithm>
+#include <functional>
+#include <map>
 #include <sstream>
 #include <iomanip>
 #include <cassert>
 
 #include "backend.h"
+#include "remarks.h"
 using namespace std;
 
 
+//------------------------------------------------------------------------------
+// memoization caches
+//
+// direct-mapped; every entry holds up to two arguments, the result and a
+// valid flag (16 bytes)
+//
+static const int MemoEntries = 1024;
+static const int MemoEntrySize = 16;
+static const int MemoMaxArgs = 2;
+
+
 //------------------------------------------------------------------------------
 // CBackend
 //
@@ -97,85 +112,254 @@ void CBackend::EmitFooter(void)
 // CBackendx86
 //
 CBackendx86::CBackendx86(ostream &out)
-  : CBackend(out), _curr_scope(NULL)
+  : CBackend(out), _curr_scope(NULL), _comments(true), _profile(false),
+    _cg(NULL), _memoize(false), _dpe(false), _icf(false), _ipra(false),
+    _regcall(false), _accumulate(false), _args_size(0), _stage_size(0)
 {
   _ind = string(4, ' ');
 }
 
+const int CBackendx86::NumArgRegs;
+const char *CBackendx86::ArgReg[] = { "%ecx", "%edx" };
+const char *CBackendx86::CandidateReg = "%esi";
+
 CBackendx86::~CBackendx86(void)
 {
 }
 
+void CBackendx86::SetProfile(bool profile, string file)
+{
+  _profile = profile;
+  _profile_file = file;
+}
+
+void CBackendx86::SetCallGraph(const CCallGraph *cg)
+{
+  _cg = cg;
+}
+
+void CBackendx86::SetMemoize(bool memoize)
+{
+  _memoize = memoize;
+}
+
+void CBackendx86::SetDeadProcElim(bool dpe)
+{
+  _dpe = dpe;
+}
+
+void CBackendx86::SetCodeFolding(bool icf)
+{
+  _icf = icf;
+}
+
+void CBackendx86::SetIPRA(bool ipra)
+{
+  _ipra = ipra;
+}
+
+void CBackendx86::SetRegisterArgs(bool regcall)
+{
+  _regcall = regcall;
+}
+
+void CBackendx86::SetAccumulateArgs(bool accumulate)
+{
+  _accumulate = accumulate;
+}
+
+void CBackendx86::SetComments(bool comments)
+{
+  _comments = comments;
+}
+
+bool CBackendx86::BeginModule(CModule *m)
+{
+  assert((m != NULL) && !_profile && !_memoize && (_cg == NULL));
+  _m = m;
+  _procs.clear();
+
+  if (!_out.good()) return false;
+
+  EmitHeader();
+  EmitTextHeader();
+
+  return _out.good();
+}
+
+void CBackendx86::EmitProcedure(CScope *proc)
+{
+  assert((proc != NULL) && (proc->GetParent() == _m));
+
+  _procs.insert(proc->GetName());
+  SetScope(proc);
+  EmitScope(proc);
+  SetScope(NULL);
+}
+
+bool CBackendx86::EndModule(void)
+{
+  if (!_out.good()) return false;
+
+  SetScope(_m);
+  EmitScope(_m);
+  EmitTextFooter();
+  EmitData();
+  EmitFooter();
+
+  return _out.good();
+}
+
 void CBackendx86::EmitHeader(void)
 {
-  _out << "##################################################" << endl
-       << "# " << _m->GetName() << endl
-       << "#" << endl
-       << endl;
+  _out << "##################################################" << '\n'
+       << "# " << _m->GetName() << '\n'
+       << "#" << '\n'
+       << '\n';
+}
+
+void CBackendx86::EmitTextHeader(void)
+{
+  _out << _ind << "#-----------------------------------------" << '\n'
+       << _ind << "# text section" << '\n'
+       << _ind << "#" << '\n'
+       << _ind << ".text" << '\n'
+       << _ind << ".align 4" << '\n'
+       << '\n'
+       << _ind << "# entry point and pre-defined functions" << '\n'
+       << _ind << ".global main" << '\n'
+       << _ind << ".extern DIM" << '\n'
+       << _ind << ".extern DOFS" << '\n'
+       << _ind << ".extern ReadInt" << '\n'
+       << _ind << ".extern WriteInt" << '\n'
+       << _ind << ".extern WriteStr" << '\n'
+       << _ind << ".extern WriteChar" << '\n'
+       << _ind << ".extern WriteLn" << '\n';
+  if (_profile)
+    _out << _ind << ".extern _prof_report" << '\n'
+         << _ind << ".extern _prof_child" << '\n';
+  _out << '\n';
+}
+
+void CBackendx86::EmitTextFooter(void)
+{
+  _out << _ind << "# end of text section" << '\n'
+       << _ind << "#-----------------------------------------" << '\n'
+       << '\n';
 }
 
 void CBackendx86::EmitCode(void)
 {
-  _out << _ind << "#-----------------------------------------" << endl
-       << _ind << "# text section" << endl
-       << _ind << "#" << endl
-       << _ind << ".text" << endl
-       << _ind << ".align 4" << endl
-       << endl
-       << _ind << "# entry point and pre-defined functions" << endl
-       << _ind << ".global main" << endl
-       << _ind << ".extern DIM" << endl
-       << _ind << ".extern DOFS" << endl
-       << _ind << ".extern ReadInt" << endl
-       << _ind << ".extern WriteInt" << endl
-       << _ind << ".extern WriteStr" << endl
-       << _ind << ".extern WriteChar" << endl
-       << _ind << ".extern WriteLn" << endl
-       << endl;
+  EmitTextHeader();
 
   /*
    * forall s in subscopes do
    *   EmitScope(s)
    * EmitScope(program)
+   *
+   * procedures unreachable from the program are skipped. With code folding,
+   * each procedure is first emitted into a buffer; if a procedure with the
+   * same code (ignoring comments and its own name) has already been emitted,
+   * the procedure becomes an alias of that procedure. Profiled procedures
+   * are never folded since each has its own profile record.
+   * With interprocedural register allocation, callees are emitted before
+   * their callers (postorder of the call graph) so that the registers a
+   * callee clobbers are known when its callers are emitted.
    */
-  const vector<CScope*> &subscopes = _m->GetSubscopes();
+  CRemarks *rm = CRemarks::Get();
+  map<size_t, vector<pair<string, CScope*> > > emitted;
+
+  vector<CScope*> subscopes = _m->GetSubscopes();
+  _procs.clear();
+  for (const auto &s : subscopes) _procs.insert(s->GetName());
+
+  if (_ipra && (_cg != NULL)) {
+    vector<CScope*> order;
+    for (const auto &s : _cg->GetScopes()) {
+      if (find(subscopes.begin(), subscopes.end(), s) != subscopes.end())
+        order.push_back(s);
+    }
+    for (const auto &s : subscopes) {
+      if (find(order.begin(), order.end(), s) == order.end())
+        order.push_back(s);
+    }
+    subscopes = order;
+  }
+
   for (const auto &s : subscopes) {
+    if (!IsEmitted(s)) {
+      rm->Add(rkPassed, "dpe", s->GetDisplayName(), s->GetLineNumber(),
+              "unreachable procedure removed");
+      continue;
+    }
+
     SetScope(s);
+    if (!_icf || _profile) {
+      EmitScope(s);
+      continue;
+    }
+
+    ostringstream buf;
+    streambuf *sb = _out.rdbuf(buf.rdbuf());
     EmitScope(s);
+    _out.rdbuf(sb);
+
+    string key = CodeKey(buf.str(), s->GetName());
+    vector<pair<string, CScope*> > &bucket = emitted[hash<string>()(key)];
+
+    CScope *same = NULL;
+    for (const auto &e : bucket) {
+      if (e.first == key) same = e.second;
+    }
+
+    if (same == NULL) {
+      bucket.push_back(make_pair(key, s));
+      _out << buf.str();
+    } else {
+      _out << _ind << "# scope " << s->GetName() << ": identical to "
+           << same->GetName() << '\n'
+           << _ind << ".set " << s->GetName() << ", " << same->GetName()
+           << '\n' << '\n';
+      _clobber[s->GetName()] = _clobber[same->GetName()];
+      rm->Add(rkPassed, "icf", s->GetDisplayName(), s->GetLineNumber(),
+              "identical code folded into '" + same->GetDisplayName() + "'");
+    }
   }
   SetScope(_m);
   EmitScope(_m);
 
-  _out << _ind << "# end of text section" << endl
-       << _ind << "#-----------------------------------------" << endl
-       << endl;
+  EmitTextFooter();
 }
 
 void CBackendx86::EmitData(void)
 {
-  _out << _ind << "#-----------------------------------------" << endl
-       << _ind << "# global data section" << endl
-       << _ind << "#" << endl
-       << _ind << ".data" << endl
-       << _ind << ".align 4" << endl
-       << endl;
+  _out << _ind << "#-----------------------------------------" << '\n'
+       << _ind << "# global data section" << '\n'
+       << _ind << "#" << '\n'
+       << _ind << ".data" << '\n'
+       << _ind << ".align 4" << '\n'
+       << '\n';
 
   EmitGlobalData(_m);
+  if (_profile) EmitProfileData();
+
+  _out << _ind << "# end of global data section" << '\n'
+       << _ind << "#-----------------------------------------" << '\n'
+       << '\n';
 
-  _out << _ind << "# end of global data section" << endl
-       << _ind << "#-----------------------------------------" << endl
-       << endl;
+  if (_memo.size() > 0) EmitMemoData();
 }
 
 void CBackendx86::EmitFooter(void)
 {
-  _out << _ind << ".end" << endl
-       << "##################################################" << endl;
+  _out << _ind << ".end" << '\n'
+       << "##################################################" << '\n';
 }
 
 void CBackendx86::SetScope(CScope *scope)
 {
   _curr_scope = scope;
+  _label_prefix = scope != NULL ? "l_" + scope->GetName() + "_" : "";
 }
 
 CScope* CBackendx86::GetScope(void) const
@@ -193,65 +377,644 @@ void CBackendx86::EmitScope(CScope *scope)
   else label = scope->GetName();
 
   /* label */
-  _out << _ind << "# scope " << scope->GetName() << endl
-       << label << ":" << endl;
+  _out << _ind << "# scope " << scope->GetName() << '\n'
+       << label << ":" << '\n';
 
-  /* ComputeStackOffsets(scope) */
-  _out << _ind << "# stack offsets:" << endl;
-  size_t size = ComputeStackOffsets(scope->GetSymbolTable(), +8, -12);
-  _out << endl;
+  /* ComputeStackOffsets(scope)
+   * the profiling data (16 bytes) is placed right below the saved registers,
+   * followed by the arguments passed in registers
+   */
+  int prof = _profile ? 16 : 0;
+  int nregs = 0;
+  if (scope->GetParent() != NULL)
+    nregs = RegArgs(dynamic_cast<const CSymProc*>(scope->GetDeclaration()));
+  _out << _ind << "# stack offsets:" << '\n';
+  size_t size = ComputeStackOffsets(scope->GetSymbolTable(), +8, -12 - prof,
+                                    nregs);
+  _out << '\n';
+
+  /* outgoing arguments are stored into an area at the bottom of the frame;
+   * arguments that cannot be stored there directly are staged in slots
+   * between the locals and the argument area
+   */
+  const list<CTacInstr*> &instructions = scope->GetCodeBlock()->GetInstr();
+  FindRegisterArgs(instructions);
+  FindOutgoingArgs(instructions, -12 - prof - 4*nregs - (int)size);
+  FindLoopHeaders(instructions);
+  int args = _args_size + _stage_size;
+  int frame = size + prof + 4*nregs + args;
+
+  CRemarks *rm = CRemarks::Get();
+  if (rm->IsEnabled(rkAnalysis)) {
+    int ntemps = scope->GetNumTemps(), nlocals = -ntemps;
+    for (const auto &s : scope->GetSymbolTable()->GetSymbols()) {
+      if (s->GetSymbolType() == stLocal) nlocals++;
+    }
 
-  /* emit function prologue */
-  _out << _ind << "# prologue" << endl;
-  EmitInstruction("pushl", "%ebp");
-  EmitInstruction("movl", "%esp, %ebp");
-  EmitInstruction("pushl", "%ebx", "save callee saved registers");
-  EmitInstruction("pushl", "%esi");
-  EmitInstruction("pushl", "%edi");
-  EmitInstruction("subl", "$" + to_string(size) + ", %esp", "make room for locals");
+    ostringstream msg;
+    msg << "stack frame of " << size << " bytes for " << nlocals
+        << " local(s) and " << ntemps << " temporaries, cleared by "
+        << (size >= 20 ? "rep stosl" : "movl");
+    rm->Add(rkAnalysis, "frame", scope->GetDisplayName(),
+            scope->GetLineNumber(), msg.str());
+  }
+
+  /* the function body is emitted into a buffer first; the registers it
+   * clobbers determine which callee-saved registers the prologue saves
+   */
+  ostringstream body;
+  streambuf *sb = _out.rdbuf(body.rdbuf());
+
+  /* store the arguments passed in registers before the profiling or the
+   * memset code clobbers them
+   */
+  for (int r=0; r<nregs; r++) {
+    EmitInstruction("movl", string(ArgReg[r]) + ", " + ParamOperand(r),
+                    r == 0 ? "store register arguments" : "");
+  }
+
+  if (_profile) EmitProfileEntry();
+
+  string why;
+  bool memo = _memoize && IsMemoizable(scope, &why);
+  if (memo) {
+    _memo.push_back(scope);
+    EmitMemoLookup();
+    rm->Add(rkPassed, "memoize", scope->GetDisplayName(),
+            scope->GetLineNumber(),
+            "results cached in a " + to_string(MemoEntries) + "-entry table");
+  } else if (_memoize && (why != "not recursive") && (why != "not a function")) {
+    rm->Add(rkMissed, "memoize", scope->GetDisplayName(),
+            scope->GetLineNumber(), "recursive function not memoized: " + why);
+  }
 
   /* memset local stack area to 0
    * there are 2 different ways depending on total stack offset
    */
   if (size >= 20) {
-    _out << endl;
+    _out << '\n';
     EmitInstruction("cld", "", "memset local stack area to 0");
     EmitInstruction("xorl", "%eax, %eax");
     EmitInstruction("movl", "$" + to_string(size/4) + ", %ecx");
-    EmitInstruction("mov", "%esp, %edi");
+    if (args > 0) EmitInstruction("leal", to_string(args) + "(%esp), %edi");
+    else EmitInstruction("mov", "%esp, %edi");
     EmitInstruction("rep", "stosl");
   }
   else if (size > 0) {
-    _out << endl;
+    _out << '\n';
     EmitInstruction("xorl", "%eax, %eax", "memset local stack area to 0");
     for (int i = size - 4; i >= 0; i -= 4)
-      EmitInstruction("movl", "%eax, " + to_string(i) + "(%esp)");
+      EmitInstruction("movl", "%eax, " + to_string(i + args) + "(%esp)");
   }
 
   /* emit local data */
   if (scope->GetParent())
     EmitLocalData(scope);
-  _out << endl;
-
-  /* emit function body */
-  _out << _ind << "# function body" << endl;
-  const list<CTacInstr*> &instructions = scope->GetCodeBlock()->GetInstr();
+  _out << '\n';
 
+  /* emit function body
+   * the rarely executed code at the end of the body goes into a separate
+   * section so that it does not dilute the instruction cache
+   */
+  const CTacInstr *cold = scope->GetCodeBlock()->GetColdCode();
+  _out << _ind << "# function body" << '\n';
   for (const auto &i : instructions) {
+    if (i == cold) {
+      _out << '\n'
+           << _ind << ".pushsection .text.unlikely" << '\n';
+    }
     EmitInstruction(i);
   }
-  _out << endl;
+  if (cold != NULL) _out << _ind << ".popsection" << '\n';
+  _out << '\n';
+
+  _out << Label("exit") << ":" << '\n';
+  if (memo) EmitMemoUpdate();
+  if (_profile) EmitProfileExit();
+
+  _out.rdbuf(sb);
+
+  /* callee-saved registers to save; the slots of registers that are not
+   * saved remain part of the frame so that the stack offsets do not change
+   */
+  vector<string> save = SavedRegisters(scope, body.str());
+  int unused = 4*(3 - (int)save.size());
+
+  /* emit function prologue */
+  _out << _ind << "# prologue" << '\n';
+  EmitInstruction("pushl", "%ebp");
+  EmitInstruction("movl", "%esp, %ebp");
+  for (size_t r=0; r<save.size(); r++) {
+    EmitInstruction("pushl", save[r], r == 0 ? "save callee saved registers" : "");
+  }
+  EmitInstruction("subl", "$" + to_string(frame + unused) + ", %esp", "make room for locals");
+
+  _out << body.str();
 
   /* emit function epilogue */
-  _out << Label("exit") << ":" << endl
-       << _ind << "# epilogue" << endl;
-  EmitInstruction("addl", "$" + to_string(size) + ", %esp", "remove locals");
-  EmitInstruction("popl", "%edi");
-  EmitInstruction("popl", "%esi");
-  EmitInstruction("popl", "%ebx");
+  _out << _ind << "# epilogue" << '\n';
+  EmitInstruction("addl", "$" + to_string(frame + unused) + ", %esp", "remove locals");
+  for (size_t r=save.size(); r>0; r--) {
+    EmitInstruction("popl", save[r-1]);
+  }
   EmitInstruction("popl", "%ebp");
   EmitInstruction("ret");
-  _out << endl;
+  _out << '\n';
+}
+
+int CBackendx86::RegArgs(const CSymProc *proc) const
+{
+  if (!_regcall || (proc == NULL) || !IsProcedure(proc->GetName())) return 0;
+  return min(proc->GetNParams(), NumArgRegs);
+}
+
+string CBackendx86::ParamOperand(int index) const
+{
+  for (const auto &s : GetScope()->GetSymbolTable()->GetSymbols()) {
+    const CSymParam *p = dynamic_cast<const CSymParam*>(s);
+    if ((p != NULL) && (p->GetIndex() == index)) {
+      return to_string(p->GetOffset()) + "(" + p->GetBaseRegister() + ")";
+    }
+  }
+  assert(false);
+  return "";
+}
+
+void CBackendx86::FindRegisterArgs(const list<CTacInstr*> &instr)
+{
+  /* an argument is loaded directly into its register if no instruction
+   * between its param and the call clobbers %ecx or %edx. Going backwards
+   * from the call, only params and instructions using %eax/%ebx/%edi are
+   * skipped; the remaining register arguments are pushed and popped into
+   * their register right before the call.
+   */
+  _regcall_param.clear();
+  _regcall_direct.clear();
+
+  vector<CTacInstr*> code(instr.begin(), instr.end());
+  for (size_t pc=0; pc<code.size(); pc++) {
+    if (code[pc]->GetOperation() != opCall) continue;
+
+    const CTacName *fun = dynamic_cast<const CTacName*>(code[pc]->GetSrc(1));
+    int nregs = RegArgs(dynamic_cast<const CSymProc*>(fun->GetSymbol()));
+    int direct = 0;
+
+    for (size_t j=pc; (j > 0) && (direct < nregs); j--) {
+      CTacInstr *i = code[j-1];
+      EOperation op = i->GetOperation();
+
+      if (op == opParam) {
+        const CTacConst *idx = dynamic_cast<const CTacConst*>(i->GetDest());
+        if (idx->GetValue() != direct) break;
+        _regcall_param.insert(i);
+        direct++;
+      }
+      else if ((op != opAddress) && (op != opAssign) &&
+               (op != opAdd) && (op != opSub) && (op != opNeg) && (op != opPos)) {
+        break;
+      }
+    }
+    _regcall_direct[code[pc]] = direct;
+  }
+}
+
+void CBackendx86::FindOutgoingArgs(const list<CTacInstr*> &instr,
+                                   int stage_ofs)
+{
+  /* params are matched with their call by scanning backwards: the params
+   * of a call precede it in descending order, possibly interleaved with
+   * complete nested calls computing the arguments.
+   * A stack argument is stored directly into the argument area unless a
+   * nested call between the param and its call uses the same slot. Such
+   * arguments, and register arguments that cannot be loaded directly into
+   * their register, are staged in a frame slot and moved into place right
+   * before the call. Staging slots are shared by calls at the same nesting
+   * depth.
+   */
+  _args_slot.clear();
+  _args_staged.clear();
+  _args_size = _stage_size = 0;
+  if (!_accumulate) return;
+
+  struct TOpenCall {
+    CTacInstr *call;
+    int nparams, nregs, next;
+    int used;                       // #slots used by nested calls
+  };
+  vector<TOpenCall> open;
+  map<pair<int, int>, int> slots;
+
+  vector<CTacInstr*> code(instr.begin(), instr.end());
+  for (size_t pc=code.size(); pc > 0; pc--) {
+    CTacInstr *i = code[pc-1];
+
+    if (i->GetOperation() == opCall) {
+      const CTacName *fun = dynamic_cast<const CTacName*>(i->GetSrc(1));
+      const CSymProc *proc = dynamic_cast<const CSymProc*>(fun->GetSymbol());
+      assert(proc != NULL);
+
+      TOpenCall c = { i, proc->GetNParams(), RegArgs(proc), 0, 0 };
+      _args_size = max(_args_size, 4*(c.nparams - c.nregs));
+      _args_staged[i];
+
+      for (auto &o : open) o.used = max(o.used, c.nparams - c.nregs);
+      if (c.nparams > 0) open.push_back(c);
+    }
+    else if (i->GetOperation() == opParam) {
+      assert(open.size() > 0);
+      TOpenCall &c = open.back();
+      int k = dynamic_cast<const CTacConst*>(i->GetDest())->GetValue();
+      assert(k == c.next);
+
+      bool staged;
+      if (k < c.nregs) staged = _regcall_param.find(i) == _regcall_param.end();
+      else staged = k - c.nregs < c.used;
+
+      if (staged) {
+        pair<int, int> key(open.size()-1, k);
+        if (slots.find(key) == slots.end()) {
+          int n = slots.size();
+          slots[key] = n;
+        }
+        int ofs = stage_ofs - 4*(slots[key] + 1);
+        _args_slot[i] = to_string(ofs) + "(%ebp)";
+        _args_staged[c.call].push_back(make_pair(k, ofs));
+      } else if (k >= c.nregs) {
+        _args_slot[i] = to_string(4*(k - c.nregs)) + "(%esp)";
+      }
+
+      if (++c.next == c.nparams) open.pop_back();
+    }
+  }
+  _stage_size = 4*slots.size();
+}
+
+void CBackendx86::FindLoopHeaders(const list<CTacInstr*> &instr)
+{
+  /* labels targeted by a branch further down are loop headers; they are
+   * aligned to 16 bytes unless that requires more than 10 bytes of padding.
+   * Loops in the rarely executed code are not aligned.
+   */
+  const CTacInstr *cold = GetScope()->GetCodeBlock()->GetColdCode();
+  set<const CTacInstr*> seen;
+
+  _loop_headers.clear();
+  for (const auto &i : instr) {
+    if (i == cold) break;
+    if (i->GetOperation() == opLabel) seen.insert(i);
+    else if (i->IsBranch()) {
+      const CTacInstr *target = dynamic_cast<const CTacLabel*>(i->GetDest());
+      if (seen.find(target) != seen.end()) _loop_headers.insert(target);
+    }
+  }
+}
+
+bool CBackendx86::IsProcedure(const string &name) const
+{
+  return _procs.find(name) != _procs.end();
+}
+
+vector<string> CBackendx86::SavedRegisters(CScope *scope, const string &body)
+{
+  static const char *callee_saved[] = { "%ebx", "%esi", "%edi" };
+
+  /* registers clobbered by the body, including those clobbered by callees
+   * (implicit operands of rdtsc, cdq, idivl and one-operand imull included)
+   */
+  set<string> clobber;
+  istringstream in(body);
+  string line;
+
+  while (getline(in, line)) {
+    size_t c = line.find('#');
+    if (c != string::npos) line.erase(c);
+
+    istringstream l(line);
+    string mnm, args;
+    l >> mnm;
+    getline(l, args);
+
+    if ((mnm == "rdtsc") || (mnm == "cdq") || (mnm == "idivl") ||
+        ((mnm == "imull") && (args.find(',') == string::npos))) {
+      clobber.insert("%eax");
+      clobber.insert("%edx");
+    }
+
+    if (mnm == "call") {
+      args.erase(0, args.find_first_not_of(" \t"));
+      args.erase(args.find_last_not_of(" \t") + 1);
+
+      map<string, set<string> >::const_iterator it = _clobber.find(args);
+      if (it != _clobber.end()) {
+        clobber.insert(it->second.begin(), it->second.end());
+      } else if ((args == "DIM") || (args == "DOFS")) {
+        clobber.insert("%eax");
+      } else if (IsProcedure(args)) {
+        // not emitted yet (recursion): assume the worst
+        clobber.insert(callee_saved, callee_saved+3);
+        clobber.insert("%eax"); clobber.insert("%ecx"); clobber.insert("%edx");
+      } else {
+        // runtime routines follow the IA32 C calling convention
+        clobber.insert("%eax"); clobber.insert("%ecx"); clobber.insert("%edx");
+      }
+      continue;
+    }
+
+    for (size_t p = args.find('%'); p != string::npos; p = args.find('%', p+1)) {
+      string r = args.substr(p, 4);
+      if ((r.size() == 4) && (r[1] == 'e')) {
+        clobber.insert(r);
+      } else if (args.size() >= p+3) {
+        // 8/16-bit registers: %al, %ax, ...
+        clobber.insert(string("%e") + args[p+1] + "x");
+      }
+    }
+  }
+  clobber.erase("%ebp");
+  clobber.erase("%esp");
+
+  /* the module body is called from the C runtime and procedures are called
+   * by other procedures only. Apart from the register candidates in
+   * CandidateReg, values are never kept in registers across calls (see
+   * EmitInstruction(opCall)), so callers of a procedure only need
+   * CandidateReg to be preserved.
+   */
+  bool exported = (scope->GetParent() == NULL) || !_ipra || (_cg == NULL);
+
+  vector<string> save;
+  for (int r=0; r<3; r++) {
+    if (!exported && (string(callee_saved[r]) != CandidateReg)) continue;
+    if (!_ipra || (_cg == NULL) || (clobber.find(callee_saved[r]) != clobber.end())) {
+      save.push_back(callee_saved[r]);
+      clobber.erase(callee_saved[r]);
+    }
+  }
+
+  string label = scope->GetParent() == NULL ? "main" : scope->GetName();
+  _clobber[label] = clobber;
+
+  if (_ipra && (_cg != NULL)) {
+    ostringstream msg;
+    msg << "clobbers";
+    for (const auto &r : clobber) msg << " " << r;
+    if (clobber.size() == 0) msg << " nothing";
+    msg << "; saves " << save.size() << " of 3 callee-saved registers";
+    CRemarks::Get()->Add(save.size() < 3 ? rkPassed : rkAnalysis, "ipra",
+                         scope->GetDisplayName(), scope->GetLineNumber(),
+                         msg.str());
+  }
+
+  return save;
+}
+
+bool CBackendx86::IsEmitted(CScope *scope) const
+{
+  return !_dpe || (_cg == NULL) || _cg->IsReachable(scope);
+}
+
+string CBackendx86::CodeKey(const string &text, const string &name) const
+{
+  istringstream in(text);
+  ostringstream key;
+  string line;
+  string label = "l_" + name + "_";
+
+  while (getline(in, line)) {
+    // strip comments and trailing blanks
+    size_t c = line.find('#');
+    if (c != string::npos) line.erase(c);
+    line.erase(line.find_last_not_of(" \t") + 1);
+    if (line.find_first_not_of(" \t") == string::npos) continue;
+
+    // the scope's own name: entry label, local labels and recursive calls
+    if (line == name + ":") line = "%:";
+    for (size_t p = line.find(label); p != string::npos;
+         p = line.find(label, p)) {
+      line.replace(p, label.size(), "l_%_");
+    }
+    if (line == _ind + "call    " + name) line = _ind + "call    %";
+
+    key << line << "\n";
+  }
+
+  return key.str();
+}
+
+void CBackendx86::EmitProfileEntry(void)
+{
+  /* profiling data on the stack
+   *   -16(%ebp)  caller's _prof_child (hi)
+   *   -20(%ebp)  caller's _prof_child (lo)
+   *   -24(%ebp)  time stamp counter at entry (hi)
+   *   -28(%ebp)  time stamp counter at entry (lo)
+   */
+  _out << '\n';
+  EmitInstruction("rdtsc", "", "profile: entry time stamp");
+  EmitInstruction("movl", "%eax, -28(%ebp)");
+  EmitInstruction("movl", "%edx, -24(%ebp)");
+  EmitInstruction("movl", "_prof_child, %eax", "save and clear callee cycles");
+  EmitInstruction("movl", "_prof_child+4, %edx");
+  EmitInstruction("movl", "%eax, -20(%ebp)");
+  EmitInstruction("movl", "%edx, -16(%ebp)");
+  EmitInstruction("movl", "$0, _prof_child");
+  EmitInstruction("movl", "$0, _prof_child+4");
+  EmitInstruction("incl", ProfileRecord(GetScope()) + "+24", "enter activation");
+}
+
+void CBackendx86::EmitProfileExit(void)
+{
+  string rec = ProfileRecord(GetScope());
+
+  /* inclusive += now - entry (outermost activation only; the time of nested
+   *                           activations is part of it)
+   * exclusive += now - entry - callee cycles
+   * caller's callee cycles += now - entry
+   */
+  _out << _ind << "# profile" << '\n';
+  EmitInstruction("movl", "%eax, %ebx", "save return value");
+  EmitInstruction("rdtsc");
+  EmitInstruction("subl", "-28(%ebp), %eax");
+  EmitInstruction("sbbl", "-24(%ebp), %edx", "%edx:%eax = inclusive cycles");
+  EmitInstruction("decl", rec + "+24", "leave activation");
+  EmitInstruction("jnz", Label("prof_nested"));
+  EmitInstruction("addl", "%eax, " + rec + "+8");
+  EmitInstruction("adcl", "%edx, " + rec + "+12");
+  _out << Label("prof_nested") << ":" << '\n';
+  EmitInstruction("movl", "%eax, %ecx");
+  EmitInstruction("movl", "%edx, %edi");
+  EmitInstruction("subl", "_prof_child, %eax");
+  EmitInstruction("sbbl", "_prof_child+4, %edx", "%edx:%eax = exclusive cycles");
+  EmitInstruction("addl", "%eax, " + rec + "+16");
+  EmitInstruction("adcl", "%edx, " + rec + "+20");
+  EmitInstruction("addl", "-20(%ebp), %ecx");
+  EmitInstruction("adcl", "-16(%ebp), %edi");
+  EmitInstruction("movl", "%ecx, _prof_child");
+  EmitInstruction("movl", "%edi, _prof_child+4");
+  EmitInstruction("incl", rec + "+4", "count call");
+  EmitInstruction("movl", "%ebx, %eax");
+
+  // the module body prints the profile before returning
+  if (GetScope()->GetParent() == NULL) {
+    EmitInstruction("pushl", "%eax");
+    EmitInstruction("call", "_prof_report");
+    EmitInstruction("popl", "%eax");
+  }
+}
+
+void CBackendx86::EmitProfileData(void)
+{
+  vector<CScope*> scopes;
+  for (const auto &s : _m->GetSubscopes()) {
+    if (IsEmitted(s)) scopes.push_back(s);
+  }
+  scopes.push_back(_m);
+
+  /* profile records (see rte/IA32/PROFILE.s)
+   *   name, calls, inclusive cycles (8 bytes), exclusive cycles (8 bytes),
+   *   active activations
+   */
+  _out << _ind << "# profile records" << '\n'
+       << _ind << ".global _prof_nprocs" << '\n'
+       << _ind << ".global _prof_table" << '\n'
+       << _ind << ".global _prof_outfile" << '\n'
+       << _ind << ".align 4" << '\n'
+       << left << setw(36) << "_prof_nprocs:" << "# number of records" << '\n'
+       << _ind << ".long " << scopes.size() << '\n'
+       << "_prof_table:" << '\n';
+  for (size_t i = 0; i < scopes.size(); i++) {
+    _out << left << setw(36) << ProfileRecord(scopes[i]) + ":"
+         << "# " << scopes[i]->GetName() << '\n'
+         << _ind << ".long " << ProfileRecord(scopes[i]) << "_name, 0" << '\n'
+         << _ind << ".long 0, 0, 0, 0, 0" << '\n';
+  }
+  for (size_t i = 0; i < scopes.size(); i++) {
+    _out << ProfileRecord(scopes[i]) << "_name:" << '\n'
+         << _ind << ".asciz \"" << scopes[i]->GetDisplayName() << "\""
+         << '\n';
+  }
+  _out << "_prof_outfile:" << '\n'
+       << _ind << ".asciz \"" << _profile_file << "\"" << '\n'
+       << '\n';
+}
+
+string CBackendx86::ProfileRecord(CScope *scope) const
+{
+  assert(scope != NULL);
+
+  if (scope->GetParent() == NULL) return "_prof_main";
+  else return "_prof_" + scope->GetName();
+}
+
+bool CBackendx86::IsMemoizable(CScope *scope, string *reason) const
+{
+  assert(scope != NULL);
+
+  string r;
+  const CSymProc *proc = dynamic_cast<const CSymProc*>(scope->GetDeclaration());
+
+  if (proc == NULL) r = "not a function";
+  else if (!proc->GetDataType()->IsScalar()) r = "no integer result";
+  else if ((_cg == NULL) || !_cg->IsRecursive(scope)) r = "not recursive";
+  else if (!proc->IsPure()) r = "not pure";
+  else if ((proc->GetNParams() == 0) || (proc->GetNParams() > MemoMaxArgs)) {
+    r = "more than " + to_string(MemoMaxArgs) + " or no arguments";
+  } else {
+    for (int p=0; p<proc->GetNParams(); p++) {
+      if (!proc->GetParam(p)->GetDataType()->IsScalar()) {
+        r = "non-integer argument";
+      }
+    }
+
+    // the arguments are used as the cache key when the function returns
+    for (const auto &i : scope->GetCodeBlock()->GetInstr()) {
+      const CTacName *d = dynamic_cast<const CTacName*>(i->GetDest());
+      if ((d != NULL) && (d->GetSymbol()->GetSymbolType() == stParam)) {
+        r = "assigns to argument '" + d->GetSymbol()->GetName() + "'";
+      }
+    }
+  }
+
+  if (reason != NULL) *reason = r;
+  return r == "";
+}
+
+void CBackendx86::MemoEntry(string reg)
+{
+  const CSymProc *proc = dynamic_cast<const CSymProc*>(GetScope()->GetDeclaration());
+  assert(proc != NULL);
+
+  /* index = (arg0 + 37*arg1) mod MemoEntries */
+  EmitInstruction("movl", ParamOperand(0) + ", " + reg);
+  if (proc->GetNParams() > 1) {
+    EmitInstruction("imull", "$37, " + ParamOperand(1) + ", %edx");
+    EmitInstruction("addl", "%edx, " + reg);
+  }
+  EmitInstruction("andl", Imm(MemoEntries-1) + ", " + reg);
+  EmitInstruction("shll", Imm(4) + ", " + reg);
+  EmitInstruction("leal", MemoTable(GetScope()) + "(" + reg + "), " + reg);
+}
+
+void CBackendx86::EmitMemoLookup(void)
+{
+  const CSymProc *proc = dynamic_cast<const CSymProc*>(GetScope()->GetDeclaration());
+  assert(proc != NULL);
+
+  /* entry: arg0, arg1, result, valid */
+  _out << '\n';
+  _out << _ind << "# memoization: look up cache" << '\n';
+  MemoEntry("%ecx");
+  EmitInstruction("cmpl", "$0, 12(%ecx)");
+  EmitInstruction("je", Label("memo_miss"));
+  for (int p=0; p<proc->GetNParams(); p++) {
+    EmitInstruction("movl", ParamOperand(p) + ", %edx");
+    EmitInstruction("cmpl", to_string(4*p) + "(%ecx), %edx");
+    EmitInstruction("jne", Label("memo_miss"));
+  }
+  EmitInstruction("movl", "8(%ecx), %eax", "cache hit");
+  EmitInstruction("jmp", Label("memo_hit"));
+  _out << Label("memo_miss") << ":" << '\n';
+}
+
+void CBackendx86::EmitMemoUpdate(void)
+{
+  const CSymProc *proc = dynamic_cast<const CSymProc*>(GetScope()->GetDeclaration());
+  assert(proc != NULL);
+
+  _out << _ind << "# memoization: update cache" << '\n';
+  MemoEntry("%ecx");
+  for (int p=0; p<proc->GetNParams(); p++) {
+    EmitInstruction("movl", ParamOperand(p) + ", %edx");
+    EmitInstruction("movl", "%edx, " + to_string(4*p) + "(%ecx)");
+  }
+  EmitInstruction("movl", "%eax, 8(%ecx)");
+  EmitInstruction("movl", "$1, 12(%ecx)");
+  _out << Label("memo_hit") << ":" << '\n';
+}
+
+void CBackendx86::EmitMemoData(void)
+{
+  _out << _ind << "#-----------------------------------------" << '\n'
+       << _ind << "# memoization caches" << '\n'
+       << _ind << "#" << '\n'
+       << _ind << ".bss" << '\n'
+       << _ind << ".align 4" << '\n'
+       << '\n';
+
+  for (const auto &s : _memo) {
+    _out << left << setw(36) << MemoTable(s) + ":"
+         << "# " << s->GetName() << ", " << MemoEntries << " entries" << '\n'
+         << _ind << ".skip " << MemoEntries*MemoEntrySize << '\n';
+  }
+
+  _out << '\n'
+       << _ind << "# end of memoization caches" << '\n'
+       << _ind << "#-----------------------------------------" << '\n'
+       << '\n';
+}
+
+string CBackendx86::MemoTable(CScope *scope) const
+{
+  return "_memo_" + scope->GetName();
 }
 
 void CBackendx86::EmitGlobalData(CScope *scope)
@@ -276,7 +1039,7 @@ void CBackendx86::EmitGlobalData(CScope *scope)
 
     if (s->GetSymbolType() == stGlobal) {
       if (!header) {
-        _out << _ind << "# scope: " << scope->GetName() << endl;
+        _out << _ind << "# scope: " << scope->GetName() << '\n';
         header = true;
       }
 
@@ -284,10 +1047,10 @@ void CBackendx86::EmitGlobalData(CScope *scope)
       if ((t->GetAlign() > 1) && (size % t->GetAlign() != 0)) {
         size += t->GetAlign() - size % t->GetAlign();
         _out << setw(4) << " " << ".align "
-             << right << setw(3) << t->GetAlign() << endl;
+             << right << setw(3) << t->GetAlign() << '\n';
       }
 
-      _out << left << setw(36) << s->GetName() + ":" << "# " << t << endl;
+      _out << left << setw(36) << s->GetName() + ":" << "# " << t << '\n';
 
       if (t->IsArray()) {
         const CArrayType *a = dynamic_cast<const CArrayType*>(t);
@@ -295,13 +1058,13 @@ void CBackendx86::EmitGlobalData(CScope *scope)
         int dim = a->GetNDim();
 
         _out << setw(4) << " "
-          << ".long " << right << setw(4) << dim << endl;
+          << ".long " << right << setw(4) << dim << '\n';
 
         for (int d=0; d<dim; d++) {
           assert(a != NULL);
 
           _out << setw(4) << " "
-            << ".long " << right << setw(4) << a->GetNElem() << endl;
+            << ".long " << right << setw(4) << a->GetNElem() << '\n';
 
           a = dynamic_cast<const CArrayType*>(a->GetInnerType());
         }
@@ -313,18 +1076,18 @@ void CBackendx86::EmitGlobalData(CScope *scope)
         assert(sdi != NULL);  // only support string data initializers for now
 
         _out << left << setw(4) << " "
-          << ".asciz " << '"' << sdi->GetData() << '"' << endl;
+          << ".asciz " << '"' << sdi->GetData() << '"' << '\n';
       } else {
         _out  << left << setw(4) << " "
           << ".skip " << dec << right << setw(4) << t->GetDataSize()
-          << endl;
+          << '\n';
       }
 
       size += t->GetSize();
     }
   }
 
-  _out << endl;
+  _out << '\n';
 
   // emit globals in subscopes (necessary if we support static local variables)
   vector<CScope*>::const_iterator sit = scope->GetSubscopes().begin();
@@ -389,9 +1152,13 @@ void CBackendx86::EmitInstruction(CTacInstr *i)
 {
   assert(i != NULL);
 
-  ostringstream cmt;
-  string mnm;
-  cmt << i;
+  // formatting the instruction is expensive; only do it if it is emitted
+  string cmt, mnm;
+  if (_comments) {
+    ostringstream o;
+    o << i;
+    cmt = o.str();
+  }
 
   EOperation op = i->GetOperation();
 
@@ -402,9 +1169,10 @@ void CBackendx86::EmitInstruction(CTacInstr *i)
     case opSub:
     case opMul:
     case opDiv:
+    case opMod:
     case opAnd:
     case opOr:
-      Load(i->GetSrc(1), "%eax", cmt.str());
+      Load(i->GetSrc(1), "%eax", cmt);
       Load(i->GetSrc(2), "%ebx");
       if (op == opAdd)
         EmitInstruction("addl", "%ebx, %eax");
@@ -416,6 +1184,11 @@ void CBackendx86::EmitInstruction(CTacInstr *i)
         EmitInstruction("cdq");
         EmitInstruction("idivl", "%ebx");
       }
+      else if (op == opMod) {
+        /* idivl leaves the remainder in %edx */
+        EmitInstruction("cdq");
+        EmitInstruction("idivl", "%ebx");
+      }
       else if (op == opAnd) {
         /* opAnd will not be appeared */
         EmitInstruction("andl", "%eax, %ebx");
@@ -425,7 +1198,7 @@ void CBackendx86::EmitInstruction(CTacInstr *i)
         EmitInstruction("orl", "%eax, %ebx");
       }
 
-      Store(i->GetDest(), 'a');
+      Store(i->GetDest(), op == opMod ? 'd' : 'a');
       break;
 
     // unary operators
@@ -433,7 +1206,7 @@ void CBackendx86::EmitInstruction(CTacInstr *i)
     case opPos:
     case opNeg:
     case opNot:
-      Load(i->GetSrc(1), "%eax", cmt.str());
+      Load(i->GetSrc(1), "%eax", cmt);
       if (op == opNeg)
         EmitInstruction("negl", "%eax");
       else if (op == opNot) {
@@ -446,26 +1219,32 @@ void CBackendx86::EmitInstruction(CTacInstr *i)
     // memory operations
     // dst = src1
     case opAssign:
-      Load(i->GetSrc(1), "%eax", cmt.str());
+      if (IsRegister(i->GetSrc(1)) || IsRegister(i->GetDest())) {
+        /* register candidates are copied directly */
+        string src = Operand(i->GetSrc(1));
+        EmitInstruction("movl", src + ", " + Operand(i->GetDest()), cmt);
+        break;
+      }
+      Load(i->GetSrc(1), "%eax", cmt);
       Store(i->GetDest(), 'a');
       break;
 
     // pointer operations
     // dst = &src1
     case opAddress:
-      EmitInstruction("leal", Operand(i->GetSrc(1)) + ", %eax", cmt.str());
+      EmitInstruction("leal", Operand(i->GetSrc(1)) + ", %eax", cmt);
       Store(i->GetDest(), 'a');
       break;
     // dst = *src1
     case opDeref:
       // opDeref not generated for now
-      EmitInstruction("# opDeref", "not implemented", cmt.str());
+      EmitInstruction("# opDeref", "not implemented", cmt);
       break;
 
     // unconditional branching
     // goto dst
     case opGoto:
-      EmitInstruction("jmp", Label(dynamic_cast<const CTacLabel*>(i->GetDest())), cmt.str());
+      EmitInstruction("jmp", Label(dynamic_cast<const CTacLabel*>(i->GetDest())), cmt);
       break;
 
     // conditional branching
@@ -476,12 +1255,39 @@ void CBackendx86::EmitInstruction(CTacInstr *i)
     case opLessEqual:
     case opBiggerThan:
     case opBiggerEqual:
-      Load(i->GetSrc(1), "%eax", cmt.str());
+      Load(i->GetSrc(1), "%eax", cmt);
       Load(i->GetSrc(2), "%ebx");
       EmitInstruction("cmpl", "%ebx, %eax");
       EmitInstruction("j" + Condition(op), Label(dynamic_cast<const CTacLabel*>(i->GetDest())));
       break;
 
+    // indexed branching through a jump table in the read-only data section
+    // switch src1 - low goto targets (falls through if out of range)
+    case opSwitch:
+    {
+      const CTacSwitch *sw = dynamic_cast<const CTacSwitch*>(i);
+      assert(sw != NULL);
+
+      const vector<CTacLabel*> &targets = sw->GetTargets();
+      string table = Label("sw" + to_string(i->GetId()));
+
+      Load(i->GetSrc(1), "%eax", cmt);
+      if (sw->GetLow() != 0) EmitInstruction("subl", Imm(sw->GetLow()) + ", %eax");
+      EmitInstruction("cmpl", Imm(targets.size()-1) + ", %eax");
+      EmitInstruction("ja", table + "_end");
+      EmitInstruction("jmp", "*" + table + "(,%eax,4)");
+
+      _out << _ind << ".pushsection .rodata" << '\n'
+           << _ind << ".align 4" << '\n'
+           << table << ":" << '\n';
+      for (const auto &t : targets) {
+        _out << _ind << ".long  " << Label(t) << '\n';
+      }
+      _out << _ind << ".popsection" << '\n'
+           << table << "_end:" << '\n';
+      break;
+    }
+
     // function call-related operations
     case opCall:
     {
@@ -490,48 +1296,124 @@ void CBackendx86::EmitInstruction(CTacInstr *i)
       assert(fun != NULL);
       assert(sym != NULL);
 
-      EmitInstruction("call", sym->GetName(), cmt.str());
-      if (sym->GetNParams() > 0)
-        EmitInstruction("addl", "$" + to_string(4 * sym->GetNParams()) + ", %esp");
+      int nregs = RegArgs(sym);
+      if (_accumulate) {
+        // move the staged arguments into place (through %ebx to leave
+        // %eax as set by the last param)
+        const vector<pair<int, int> > &staged = _args_staged[i];
+        for (size_t a=0; a<staged.size(); a++) {
+          int k = staged[a].first;
+          string slot = to_string(staged[a].second) + "(%ebp)";
+          string c = a == 0 ? cmt : "";
+          if (k < nregs) {
+            EmitInstruction("movl", slot + ", " + ArgReg[k], c);
+          } else {
+            EmitInstruction("movl", slot + ", %ebx", c);
+            EmitInstruction("movl", "%ebx, " + to_string(4*(k-nregs)) + "(%esp)");
+          }
+        }
+        EmitInstruction("call", sym->GetName(), staged.size() == 0 ? cmt : "");
+      } else {
+        // register arguments that could not be loaded directly were pushed
+        int direct = 0;
+        map<const CTacInstr*, int>::const_iterator it = _regcall_direct.find(i);
+        if (it != _regcall_direct.end()) direct = it->second;
+        for (int r=direct; r<nregs; r++) {
+          EmitInstruction("popl", ArgReg[r], r == direct ? cmt : "");
+        }
+
+        EmitInstruction("call", sym->GetName(), direct == nregs ? cmt : "");
+        if (sym->GetNParams() > nregs)
+          EmitInstruction("addl", "$" + to_string(4 * (sym->GetNParams() - nregs)) + ", %esp");
+      }
       if (i->GetDest())
         Store(i->GetDest(), 'a');
       break;
     }
     case opReturn:
       if (i->GetSrc(1)) {
-        Load(i->GetSrc(1), "%eax", cmt.str());
+        Load(i->GetSrc(1), "%eax", cmt);
         EmitInstruction("jmp", Label("exit"));
       }
       else
-        EmitInstruction("jmp", Label("exit"), cmt.str());
+        EmitInstruction("jmp", Label("exit"), cmt);
       break;
     case opParam:
-      Load(i->GetSrc(1), "%eax", cmt.str());
-      EmitInstruction("pushl", "%eax");
+    {
+      const CTacConst *idx = dynamic_cast<const CTacConst*>(i->GetDest());
+      assert(idx != NULL);
+
+      // register arguments go through %eax as well: the value left in %eax
+      // is the exit code of programs whose body does not set it
+      if (_regcall_param.find(i) != _regcall_param.end()) {
+        Load(i->GetSrc(1), "%eax", cmt);
+        EmitInstruction("movl", string("%eax, ") + ArgReg[idx->GetValue()]);
+      } else if (_accumulate) {
+        Load(i->GetSrc(1), "%eax", cmt);
+        map<const CTacInstr*, string>::const_iterator it = _args_slot.find(i);
+        assert(it != _args_slot.end());
+        EmitInstruction("movl", "%eax, " + it->second);
+      } else {
+        Load(i->GetSrc(1), "%eax", cmt);
+        EmitInstruction("pushl", "%eax");
+      }
       break;
+    }
+
+    // conditional assignment
+    // dst = (left relOp right) ? src1 : src2
+    case opSelect:
+    {
+      const CTacSelect *sel = dynamic_cast<const CTacSelect*>(i);
+      assert(sel != NULL);
+
+      Load(sel->GetLeft(), "%eax", cmt);
+      Load(sel->GetRight(), "%ebx");
+      EmitInstruction("cmpl", "%ebx, %eax");
+      Load(i->GetSrc(2), "%eax");
+      Load(i->GetSrc(1), "%ebx");
+      EmitInstruction("cmov" + Condition(sel->GetCondition()), "%ebx, %eax");
+      Store(i->GetDest(), 'a');
+      break;
+    }
 
     // special
     case opLabel:
-      _out << Label(dynamic_cast<CTacLabel*>(i)) << ":" << endl;
+      if (_loop_headers.find(i) != _loop_headers.end())
+        _out << _ind << ".p2align 4,,10" << '\n';
+      _out << Label(dynamic_cast<CTacLabel*>(i)) << ":" << '\n';
       break;
 
     case opNop:
-      EmitInstruction("nop", "", cmt.str());
+      EmitInstruction("nop", "", cmt);
       break;
 
     default:
-      EmitInstruction("# ???", "not implemented", cmt.str());
+      EmitInstruction("# ???", "not implemented", cmt);
   }
 }
 
-void CBackendx86::EmitInstruction(string mnemonic, string args, string comment)
+void CBackendx86::EmitInstruction(const string &mnemonic, const string &args,
+                                  const string &comment)
 {
-  _out << left
-       << _ind
-       << setw(7) << mnemonic << " "
-       << setw(23) << args;
-  if (comment != "") _out << " # " << comment;
-  _out << endl;
+  // the line is assembled in a buffer that is reused for all instructions
+  _line.assign(_ind);
+  _line.append(mnemonic);
+  if (_comments || (args != "")) {
+    if (mnemonic.size() < 7) _line.append(7 - mnemonic.size(), ' ');
+    _line.push_back(' ');
+    _line.append(args);
+  }
+  if (_comments) {
+    if (args.size() < 23) _line.append(23 - args.size(), ' ');
+    if (comment != "") {
+      _line.append(" # ");
+      _line.append(comment);
+    }
+  }
+  _line.push_back('\n');
+
+  _out.write(_line.data(), _line.size());
 }
 
 void CBackendx86::Load(CTacAddr *src, string dst, string comment)
@@ -596,6 +1478,8 @@ string CBackendx86::Operand(const CTac *op)
     ESymbolType symbolType = sym->GetSymbolType();
     if (symbolType == stGlobal || symbolType == stProcedure)
       operand = sym->GetName();
+    else if (IsRegister(op))
+      operand = CandidateReg;
     else {
       operand = to_string(sym->GetOffset()) + "(" + sym->GetBaseRegister() + ")";
     }
@@ -613,6 +1497,18 @@ string CBackendx86::Operand(const CTac *op)
   return operand;
 }
 
+bool CBackendx86::IsRegister(const CTac *op) const
+{
+  /* the register candidates of a scope have disjoint live ranges; they
+   * all share one callee-saved register that is not used otherwise
+   */
+  const CTacName *n = dynamic_cast<const CTacName*>(op);
+  if ((n == NULL) || (dynamic_cast<const CTacReference*>(op) != NULL))
+    return false;
+
+  return GetScope()->GetRegisterCandidates().count(n->GetSymbol()) > 0;
+}
+
 string CBackendx86::Imm(int value) const
 {
   ostringstream o;
@@ -622,21 +1518,16 @@ string CBackendx86::Imm(int value) const
 
 string CBackendx86::Label(const CTacLabel* label) const
 {
-  CScope *cs = GetScope();
-  assert(cs != NULL);
+  assert(GetScope() != NULL);
 
-  ostringstream o;
-  o << "l_" << cs->GetName() << "_" << label->GetLabel();
-  return o.str();
-  return "l_" + cs->GetName() + "_" + label->GetLabel();
+  return _label_prefix + label->GetLabel();
 }
 
 string CBackendx86::Label(string label) const
 {
-  CScope *cs = GetScope();
-  assert(cs != NULL);
+  assert(GetScope() != NULL);
 
-  return "l_" + cs->GetName() + "_" + label;
+  return _label_prefix + label;
 }
 
 string CBackendx86::Condition(EOperation cond) const
@@ -693,13 +1584,20 @@ int CBackendx86::OperandSize(CTac *t) const
 }
 
 size_t CBackendx86::ComputeStackOffsets(CSymtab *symtab,
-                                        int param_ofs,int local_ofs)
+                                        int param_ofs,int local_ofs,
+                                        int nregs)
 {
   assert(symtab != NULL);
   vector<CSymbol*> slist = symtab->GetSymbols();
 
   size_t size = 0;
 
+  /* arguments passed in registers are stored right below local_ofs; they
+   * are not included in the returned size (and not cleared by the memset)
+   */
+  int reg_ofs = local_ofs;
+  local_ofs -= 4 * nregs;
+
   /* foreach local symbol l in slist do
    *   compute aligned offset on stack and store in symbol l
    *   set base register to %ebp
@@ -752,7 +1650,9 @@ size_t CBackendx86::ComputeStackOffsets(CSymtab *symtab,
     /* parameter doesn't require alignment rule.
      * its offset is always (start_param_ofs + 4 * index)
      */
-    int offset = param_ofs + 4 * dynamic_cast<CSymParam*>(p)->GetIndex();
+    int index = dynamic_cast<CSymParam*>(p)->GetIndex();
+    int offset = param_ofs + 4 * (index - nregs);
+    if (index < nregs) offset = reg_ofs - 4 * (index + 1);
     p->SetOffset(offset);
     p->SetBaseRegister("%ebp");
   }
@@ -771,7 +1671,7 @@ size_t CBackendx86::ComputeStackOffsets(CSymtab *symtab,
       continue;
 
     _out << _ind << "#" << setw(7) << std::right << s->GetOffset() << "(" << s->GetBaseRegister() << ")"
-         << setw(4) << std::right << s->GetDataType()->GetSize() << setw(2) << s << endl;
+         << setw(4) << std::right << s->GetDataType()->GetSize() << setw(2) << s << '\n';
   }
 
   return size;
@@ -37,9 +37,12 @@
 
 #include <iostream>
 #include <vector>
+#include <map>
+#include <set>
 
 #include "symtab.h"
 #include "ir.h"
+#include "ipa.h"
 
 using namespace std;
 
@@ -98,6 +101,66 @@ class CBackendx86 : public CBackend {
 
     /// @}
 
+    /// @name code generation options
+    /// @{
+
+    /// @brief enable/disable profiling instrumentation
+    /// @param profile instrument procedures with call/cycle counters
+    /// @param file file the profile is written to at exit (default: stderr)
+    void SetProfile(bool profile, string file="");
+
+    /// @brief set the call graph of the module (required by interprocedural
+    ///        optimizations)
+    void SetCallGraph(const CCallGraph *cg);
+
+    /// @brief enable/disable memoization of pure recursive functions
+    void SetMemoize(bool memoize);
+
+    /// @brief enable/disable the removal of procedures that are unreachable
+    ///        from the module body (requires the call graph)
+    void SetDeadProcElim(bool dpe);
+
+    /// @brief enable/disable folding of procedures with identical code
+    void SetCodeFolding(bool icf);
+
+    /// @brief enable/disable interprocedural register allocation: procedures
+    ///        only save the callee-saved registers they actually clobber
+    ///        (requires the call graph)
+    void SetIPRA(bool ipra);
+
+    /// @brief enable/disable passing the first NumArgRegs arguments of
+    ///        calls between procedures of the module in registers
+    void SetRegisterArgs(bool regcall);
+
+    /// @brief enable/disable storing outgoing arguments into an area
+    ///        reserved once per frame instead of pushing them
+    void SetAccumulateArgs(bool accumulate);
+
+    /// @brief enable/disable the comments showing the TAC instruction that
+    ///        emitted x86 instructions implement
+    void SetComments(bool comments);
+
+    /// @}
+
+    /// @name streaming output methods
+    /// @{
+
+    /// @brief emit the code of a module procedure by procedure: BeginModule()
+    ///        emits the header, EmitProcedure() the code of one procedure,
+    ///        and EndModule() the module body, the data and the footer.
+    ///        Options that need the whole module (profiling, memoization,
+    ///        the call graph) are not supported.
+    bool BeginModule(CModule *m);
+
+    /// @brief emit the code of procedure @a proc of the current module.
+    ///        @a proc may be deleted after the call.
+    void EmitProcedure(CScope *proc);
+
+    /// @brief emit the remaining parts of the current module
+    bool EndModule(void);
+
+    /// @}
+
   protected:
     /// @name detailed output methods
     /// @{
@@ -112,6 +175,12 @@ class CBackendx86 : public CBackend {
     /// @name additional methods
     /// @{
 
+    /// @brief emit the start of the text section
+    void EmitTextHeader(void);
+
+    /// @brief emit the end of the text section
+    void EmitTextFooter(void);
+
     /// @brief set the current scope
     void SetScope(CScope *scope);
 
@@ -121,6 +190,42 @@ class CBackendx86 : public CBackend {
     /// @brief emit a scope
     virtual void EmitScope(CScope *scope);
 
+    /// @brief returns true if the code of @a scope is emitted
+    bool IsEmitted(CScope *scope) const;
+
+    /// @brief return the code of a scope emitted by EmitScope() without
+    ///        comments and with the scope's name replaced by '%'. Scopes
+    ///        with the same key compile to identical code.
+    /// @param text emitted code
+    /// @param name scope name
+    string CodeKey(const string &text, const string &name) const;
+
+    /// @brief return the number of arguments of @a proc passed in registers
+    int RegArgs(const CSymProc *proc) const;
+
+    /// @brief return the operand of parameter @a index of the current scope
+    string ParamOperand(int index) const;
+
+    /// @brief determine the register arguments that can be loaded directly
+    ///        into their register by the param instruction
+    void FindRegisterArgs(const list<CTacInstr*> &instr);
+
+    /// @brief assign the slots of outgoing arguments (accumulate mode)
+    /// @param instr instructions of the current scope
+    /// @param stage_ofs offset below which staging slots are allocated
+    void FindOutgoingArgs(const list<CTacInstr*> &instr, int stage_ofs);
+
+    /// @brief determine the labels that are the target of backward branches
+    void FindLoopHeaders(const list<CTacInstr*> &instr);
+
+    /// @brief returns true if @a name is a procedure of the module
+    bool IsProcedure(const string &name) const;
+
+    /// @brief return the callee-saved registers that the prologue of @a scope
+    ///        must save given its emitted function @a body, and record the
+    ///        registers a call to @a scope clobbers
+    vector<string> SavedRegisters(CScope *scope, const string &body);
+
     /// @brief emit global data
     virtual void EmitGlobalData(CScope *s);
 
@@ -137,8 +242,8 @@ class CBackendx86 : public CBackend {
 
     /// @brief emit an instruction
 
-    virtual void EmitInstruction(string mnemonic, string args="",
-                                 string comment="");
+    virtual void EmitInstruction(const string &mnemonic, const string &args="",
+                                 const string &comment="");
 
     /// @brief emit a load instruction
     void Load(CTacAddr *src, string dst, string comment="");
@@ -150,6 +255,10 @@ class CBackendx86 : public CBackend {
     /// @param op the operand
     string Operand(const CTac *op);
 
+    /// @brief returns true if @a op is kept in a register (see
+    ///        CScope::GetRegisterCandidates())
+    bool IsRegister(const CTac *op) const;
+
     /// @brief return an immediate for @a value
     string Imm(int value) const;
 
@@ -165,6 +274,38 @@ class CBackendx86 : public CBackend {
     /// @brief compute the size of operator @t
     int OperandSize(CTac *t) const;
 
+    /// @brief emit the profiling code at the entry of the current scope
+    virtual void EmitProfileEntry(void);
+
+    /// @brief emit the profiling code at the exit of the current scope
+    virtual void EmitProfileExit(void);
+
+    /// @brief emit the profile records of all scopes
+    virtual void EmitProfileData(void);
+
+    /// @brief return the label of the profile record of @a scope
+    string ProfileRecord(CScope *scope) const;
+
+    /// @brief returns true if calls to @a scope can be served from a cache.
+    ///        If not, the reason is returned in @a reason (if not NULL)
+    bool IsMemoizable(CScope *scope, string *reason=NULL) const;
+
+    /// @brief emit the cache lookup at the entry of the current scope
+    virtual void EmitMemoLookup(void);
+
+    /// @brief emit the cache update at the exit of the current scope
+    virtual void EmitMemoUpdate(void);
+
+    /// @brief emit the cache tables of all memoized scopes
+    virtual void EmitMemoData(void);
+
+    /// @brief emit code computing the address of the cache entry for the
+    ///        arguments of the current scope into register @a reg
+    void MemoEntry(string reg);
+
+    /// @brief return the label of the cache table of @a scope
+    string MemoTable(CScope *scope) const;
+
     /// @brief compute the location of local variables, temporaries and
     ///        arguments on the stack. Returns the total size occupied on
     ///        the stack as well as the the number of arguments for this
@@ -172,12 +313,45 @@ class CBackendx86 : public CBackend {
     /// @param symtab symbol table
     /// @param param_ofs offset to parameters from base pointer after epilogue
     /// @param local_ofs offset to local vars from base pointer after epilogue
-    size_t ComputeStackOffsets(CSymtab *symtab, int param_ofs, int local_ofs);
+    /// @param nregs number of arguments passed in registers
+    size_t ComputeStackOffsets(CSymtab *symtab, int param_ofs, int local_ofs,
+                               int nregs=0);
 
     /// @}
 
     string _ind;                    ///< indentation
     CScope *_curr_scope;            ///< current scope
+    string _label_prefix;           ///< prefix of the labels of the scope
+    bool _comments;                 ///< emit comments with TAC instructions
+    string _line;                   ///< buffer of EmitInstruction()
+
+    bool _profile;                  ///< emit profiling instrumentation
+    string _profile_file;           ///< profile output file (empty: stderr)
+
+    const CCallGraph *_cg;          ///< call graph (may be NULL)
+    bool _memoize;                  ///< memoize pure recursive functions
+    vector<CScope*> _memo;          ///< memoized scopes
+
+    bool _dpe;                      ///< remove unreachable procedures
+    bool _icf;                      ///< fold identical procedures
+
+    bool _ipra;                     ///< interprocedural register allocation
+    map<string, set<string> > _clobber; ///< registers clobbered by a call
+    set<string> _procs;             ///< procedures of the module
+
+    bool _regcall;                  ///< pass arguments in registers
+    set<const CTacInstr*> _regcall_param; ///< params loaded into registers
+    map<const CTacInstr*, int> _regcall_direct; ///< #direct register args
+    bool _accumulate;               ///< store outgoing args in a fixed area
+    int _args_size;                 ///< size of the outgoing argument area
+    int _stage_size;                ///< size of the staging slots
+    map<const CTacInstr*, string> _args_slot; ///< slot of a param
+    map<const CTacInstr*, vector<pair<int, int> > > _args_staged;
+                                    ///< staged (index, offset) of a call
+    set<const CTacInstr*> _loop_headers; ///< targets of backward branches
+    static const int NumArgRegs = 2;  ///< number of argument registers
+    static const char *ArgReg[NumArgRegs]; ///< argument registers
+    static const char *CandidateReg; ///< register of register candidates
 };
 
 
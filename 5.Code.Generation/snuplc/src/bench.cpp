@@ -0,0 +1,273 @@
+//------------------------------------------------------------------------------
+/// @brief SnuPL micro-benchmarks of the compiler internals
+//------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "scanner.h"
+#include "parser.h"
+#include "type.h"
+#include "symtab.h"
+#include "ir.h"
+#include "backend.h"
+#include "synth.h"
+using namespace std;
+
+//------------------------------------------------------------------------------
+// micro-benchmarks for the individual compiler components. Each benchmark
+// runs on generated inputs of increasing size; every measurement is repeated
+// (after one warm-up run) and reported as median, mean, standard deviation
+// and median time per input unit.
+//
+
+int reps = 10;                      ///< repetitions per measurement
+long long max_size = 100000;        ///< largest input size
+string filter = "";                 ///< run only benchmarks containing filter
+
+/// @brief stream buffer that discards all output
+class CNullBuffer : public streambuf {
+  protected:
+    virtual int overflow(int c) { return c; };
+    virtual streamsize xsputn(const char *, streamsize n) { return n; };
+};
+
+/// @brief a benchmark: prepares its input outside of the measurement
+///        (setup), then runs the measured code (run) and cleans up (teardown)
+struct SBenchmark {
+  string name;                      ///< benchmark name
+  string unit;                      ///< input unit (lines, symbols, ...)
+  long long min_size;               ///< smallest input size
+  long long max_size;               ///< largest input size (0: --max-size)
+  function<void(long long)> setup;  ///< prepare input of a given size
+  function<void(void)> run;         ///< measured code
+  function<void(void)> teardown;    ///< release resources
+};
+
+/// @brief time one run of @a b in seconds
+double Measure(SBenchmark &b, long long size)
+{
+  b.setup(size);
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  b.run();
+  chrono::steady_clock::time_point end = chrono::steady_clock::now();
+  b.teardown();
+
+  return chrono::duration<double>(end - start).count();
+}
+
+/// @brief run benchmark @a b for all sizes and print the statistics
+void Run(SBenchmark &b)
+{
+  long long max = b.max_size > 0 ? min(b.max_size, max_size) : max_size;
+
+  for (long long size = b.min_size; size <= max; size *= 10) {
+    Measure(b, size);                           // warm-up
+
+    vector<double> t;
+    for (int r=0; r<reps; r++) t.push_back(Measure(b, size));
+
+    sort(t.begin(), t.end());
+    double median = t.size() % 2 ? t[t.size()/2]
+                                 : (t[t.size()/2-1] + t[t.size()/2]) / 2;
+    double mean = 0, var = 0;
+    for (const auto &v : t) mean += v;
+    mean /= t.size();
+    for (const auto &v : t) var += (v - mean) * (v - mean);
+    double stddev = t.size() > 1 ? sqrt(var / (t.size() - 1)) : 0;
+
+    cout << "  " << left << setw(22) << b.name
+         << right << setw(9) << size << " " << left << setw(8) << b.unit
+         << right << fixed << setprecision(3)
+         << setw(11) << median * 1e3 << setw(11) << mean * 1e3
+         << setw(10) << stddev * 1e3
+         << setw(7) << setprecision(1) << (mean > 0 ? 100 * stddev / mean : 0)
+         << "%" << setw(12) << setprecision(1) << median * 1e9 / size
+         << endl;
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// benchmarks
+//
+
+string source;                      ///< generated module
+CAstModule *ast = NULL;             ///< parsed module
+CModule *module = NULL;             ///< IR of the module
+CSymtab *symtab = NULL;             ///< symbol table
+vector<CSymbol*> symbols;           ///< symbols to insert
+vector<string> names;               ///< names to look up
+long long n = 0;                    ///< input size
+
+/// @brief generate a module of @a lines lines
+void Generate(long long lines)
+{
+  CModuleGenerator gen;
+  source = gen.Generate(lines);
+}
+
+/// @brief parse the generated module
+CAstModule* ParseSource(void)
+{
+  CParser p(new CScanner(source));
+  CAstModule *m = dynamic_cast<CAstModule*>(p.Parse());
+  if (p.HasError()) {
+    cerr << "parse error: " << p.GetErrorMessage() << endl;
+    exit(EXIT_FAILURE);
+  }
+  return m;
+}
+
+void Nothing(void)
+{
+}
+
+void Scan(void)
+{
+  CScanner s(source);
+  while (s.Get().GetType() != tEOF);
+}
+
+void Parse(void)
+{
+  ast = ParseSource();
+}
+
+void DeleteAST(void)
+{
+  delete ast;
+  ast = NULL;
+}
+
+void Lower(void)
+{
+  module = new CModule(ast);
+}
+
+void DeleteModule(void)
+{
+  delete module;
+  module = NULL;
+  DeleteAST();
+}
+
+void Emit(void)
+{
+  CNullBuffer buf;
+  ostream out(&buf);
+  CBackendx86 be(out);
+  be.Emit(module);
+}
+
+void SetupSymbols(long long size)
+{
+  const CType *t = CTypeManager::Get()->GetInt();
+
+  symtab = new CSymtab();
+  symbols.clear();
+  names.clear();
+  for (long long i=0; i<size; i++) {
+    ostringstream o;
+    o << "v" << (i * 7919) % size;
+    names.push_back(o.str());
+    symbols.push_back(new CSymGlobal(o.str(), t));
+  }
+}
+
+void AddSymbols(void)
+{
+  for (const auto &s : symbols) symtab->AddSymbol(s);
+}
+
+void FindSymbols(void)
+{
+  for (const auto &s : names) {
+    if (symtab->FindSymbol(s) == NULL) abort();
+  }
+}
+
+void DeleteSymtab(void)
+{
+  delete symtab;
+  symtab = NULL;
+}
+
+void GetTypes(void)
+{
+  CTypeManager *tm = CTypeManager::Get();
+  const CType *base = tm->GetInt();
+
+  // the type manager never releases types; each size only creates new
+  // types in the warm-up run and measures lookups afterwards
+  for (long long i=1; i<=n; i++) {
+    const CArrayType *a = tm->GetArray(i, base);
+    tm->GetPointer(a);
+  }
+}
+
+
+void Syntax(void)
+{
+  cout << "Usage: microbench [--reps N] [--max-size N] [FILTER]" << endl
+       << "Run the micro-benchmarks whose name contains FILTER." << endl
+       << "  --reps N       repetitions per measurement. Default: 10" << endl
+       << "  --max-size N   largest input size. Default: 100000" << endl;
+  exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+  for (int i=1; i<argc; i++) {
+    if ((strcmp(argv[i], "--reps") == 0) && (i+1 < argc)) {
+      reps = atoi(argv[++i]);
+    } else if ((strcmp(argv[i], "--max-size") == 0) && (i+1 < argc)) {
+      max_size = atoll(argv[++i]);
+    } else if (argv[i][0] == '-') {
+      Syntax();
+    } else {
+      filter = argv[i];
+    }
+  }
+  if (reps < 1) reps = 1;
+
+  vector<SBenchmark> benchmarks = {
+    { "CScanner::Get",        "lines",   1000, 0,
+      Generate, Scan, Nothing },
+    { "CParser::Parse",       "lines",   1000, 0,
+      Generate, Parse, DeleteAST },
+    { "CSymtab::AddSymbol",   "symbols", 1000, 0,
+      SetupSymbols, AddSymbols, DeleteSymtab },
+    { "CSymtab::FindSymbol",  "symbols", 1000, 0,
+      [](long long s) { SetupSymbols(s); AddSymbols(); },
+      FindSymbols, DeleteSymtab },
+    // GetArray/GetPointer search linearly; larger sizes take minutes
+    { "CTypeManager::GetArray", "types",    100, 10000,
+      [](long long s) { n = s; }, GetTypes, Nothing },
+    { "CModule::CModule",     "lines",   1000, 0,
+      [](long long s) { Generate(s); Parse(); }, Lower, DeleteModule },
+    { "CBackendx86::Emit",    "lines",   1000, 0,
+      [](long long s) { Generate(s); Parse(); Lower(); }, Emit, DeleteModule },
+  };
+
+  cout << "  " << left << setw(22) << "benchmark"
+       << right << setw(9) << "size" << " " << left << setw(8) << "unit"
+       << right << setw(11) << "median ms" << setw(11) << "mean ms"
+       << setw(10) << "stddev" << setw(8) << "rsd"
+       << setw(12) << "ns/unit" << endl;
+
+  for (auto &b : benchmarks) {
+    if (b.name.find(filter) != string::npos) Run(b);
+  }
+
+  return EXIT_SUCCESS;
+}
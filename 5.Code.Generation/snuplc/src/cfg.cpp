@@ -0,0 +1,601 @@
+//------------------------------------------------------------------------------
+/// @brief SnuPL control flow graph
+//------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cassert>
+#include <iomanip>
+
+#include "cfg.h"
+using namespace std;
+
+
+//------------------------------------------------------------------------------
+// CBasicBlock
+//
+CBasicBlock::CBasicBlock(int id)
+  : _id(id), _idom(NULL), _rpo(-1), _loop(NULL)
+{
+}
+
+int CBasicBlock::GetId(void) const
+{
+  return _id;
+}
+
+const list<CTacInstr*>& CBasicBlock::GetInstr(void) const
+{
+  return _instr;
+}
+
+CTacLabel* CBasicBlock::GetLabel(void) const
+{
+  return _instr.empty() ? NULL : dynamic_cast<CTacLabel*>(_instr.front());
+}
+
+CTacInstr* CBasicBlock::GetLast(void) const
+{
+  return _instr.empty() ? NULL : _instr.back();
+}
+
+const vector<CBasicBlock*>& CBasicBlock::GetSucc(void) const
+{
+  return _succ;
+}
+
+const vector<CBasicBlock*>& CBasicBlock::GetPred(void) const
+{
+  return _pred;
+}
+
+CBasicBlock* CBasicBlock::GetIDom(void) const
+{
+  return _idom;
+}
+
+bool CBasicBlock::IsReachable(void) const
+{
+  return _rpo != -1;
+}
+
+CLoop* CBasicBlock::GetLoop(void) const
+{
+  return _loop;
+}
+
+int CBasicBlock::GetLineNumber(void) const
+{
+  for (const auto &i : _instr) {
+    if (i->GetLineNumber() != 0) return i->GetLineNumber();
+  }
+  return 0;
+}
+
+ostream& CBasicBlock::print(ostream &out, int indent) const
+{
+  string ind(indent, ' ');
+
+  out << ind << "BB" << _id << ":";
+  out << "  pred:";
+  for (const auto &p : _pred) out << " BB" << p->_id;
+  out << "  succ:";
+  for (const auto &s : _succ) out << " BB" << s->_id;
+  if (_idom != NULL) out << "  idom: BB" << _idom->_id;
+  if (!IsReachable()) out << "  (unreachable)";
+  if (_loop != NULL) out << "  loop depth: " << _loop->GetDepth();
+  out << endl;
+
+  for (const auto &i : _instr) {
+    i->print(out, indent+2);
+    out << endl;
+  }
+
+  return out;
+}
+
+ostream& operator<<(ostream &out, const CBasicBlock &t)
+{
+  return t.print(out);
+}
+
+ostream& operator<<(ostream &out, const CBasicBlock *t)
+{
+  return t->print(out);
+}
+
+
+//------------------------------------------------------------------------------
+// CLoop
+//
+CLoop::CLoop(CBasicBlock *header)
+  : _header(header), _parent(NULL), _trip(-1)
+{
+  assert(header != NULL);
+}
+
+CBasicBlock* CLoop::GetHeader(void) const
+{
+  return _header;
+}
+
+const vector<CBasicBlock*>& CLoop::GetBlocks(void) const
+{
+  return _blocks;
+}
+
+const vector<CBasicBlock*>& CLoop::GetLatches(void) const
+{
+  return _latches;
+}
+
+bool CLoop::Contains(const CBasicBlock *bb) const
+{
+  return (bb != NULL) && (bb->GetId() < (int)_member.size()) &&
+         _member[bb->GetId()];
+}
+
+CLoop* CLoop::GetParent(void) const
+{
+  return _parent;
+}
+
+const vector<CLoop*>& CLoop::GetSubloops(void) const
+{
+  return _subloops;
+}
+
+int CLoop::GetDepth(void) const
+{
+  return _parent == NULL ? 1 : _parent->GetDepth() + 1;
+}
+
+long long CLoop::GetTripCount(void) const
+{
+  return _trip;
+}
+
+
+//------------------------------------------------------------------------------
+// CCfg
+//
+CCfg::CCfg(CCodeBlock *cb)
+  : _cb(cb)
+{
+  assert(cb != NULL);
+
+  BuildBlocks();
+  ComputeDominators();
+  FindLoops();
+}
+
+CCfg::~CCfg(void)
+{
+  for (const auto &l : _loops) delete l;
+  for (const auto &b : _blocks) delete b;
+}
+
+CCodeBlock* CCfg::GetCodeBlock(void) const
+{
+  return _cb;
+}
+
+const vector<CBasicBlock*>& CCfg::GetBlocks(void) const
+{
+  return _blocks;
+}
+
+CBasicBlock* CCfg::GetEntry(void) const
+{
+  return _blocks.empty() ? NULL : _blocks.front();
+}
+
+CBasicBlock* CCfg::GetBlock(const CTacLabel *label) const
+{
+  map<const CTacLabel*, CBasicBlock*>::const_iterator it = _labels.find(label);
+  return it == _labels.end() ? NULL : it->second;
+}
+
+bool CCfg::Dominates(const CBasicBlock *a, const CBasicBlock *b) const
+{
+  if ((a == NULL) || (b == NULL) || !b->IsReachable()) return false;
+
+  // dominators precede the blocks they dominate in reverse postorder
+  while ((b != NULL) && (b->_rpo >= a->_rpo)) {
+    if (a == b) return true;
+    b = b->_idom;
+  }
+  return false;
+}
+
+const vector<CLoop*>& CCfg::GetLoops(void) const
+{
+  return _loops;
+}
+
+void CCfg::AddEdge(CBasicBlock *from, CBasicBlock *to)
+{
+  assert((from != NULL) && (to != NULL));
+
+  if (find(from->_succ.begin(), from->_succ.end(), to) != from->_succ.end())
+    return;
+
+  from->_succ.push_back(to);
+  to->_pred.push_back(from);
+}
+
+void CCfg::BuildBlocks(void)
+{
+  // a new block starts at labels and after branches, switches and returns
+  CBasicBlock *bb = NULL;
+
+  for (const auto &i : _cb->GetInstr()) {
+    CTacLabel *lbl = dynamic_cast<CTacLabel*>(i);
+
+    if ((bb == NULL) || ((lbl != NULL) && !bb->_instr.empty())) {
+      bb = new CBasicBlock(_blocks.size());
+      _blocks.push_back(bb);
+    }
+
+    bb->_instr.push_back(i);
+    if (lbl != NULL) _labels[lbl] = bb;
+
+    EOperation op = i->GetOperation();
+    if (i->IsBranch() || (op == opSwitch) || (op == opReturn)) bb = NULL;
+  }
+
+  // connect the blocks
+  for (size_t b=0; b<_blocks.size(); b++) {
+    bb = _blocks[b];
+    CBasicBlock *next = b+1 < _blocks.size() ? _blocks[b+1] : NULL;
+    CTacInstr *last = bb->GetLast();
+    EOperation op = last->GetOperation();
+
+    if (last->IsBranch()) {
+      CBasicBlock *target = GetBlock(dynamic_cast<CTacLabel*>(last->GetDest()));
+      assert(target != NULL);
+      AddEdge(bb, target);
+    }
+
+    if (op == opSwitch) {
+      const CTacSwitch *sw = dynamic_cast<const CTacSwitch*>(last);
+      for (const auto &t : sw->GetTargets()) {
+        CBasicBlock *target = GetBlock(t);
+        assert(target != NULL);
+        AddEdge(bb, target);
+      }
+    }
+
+    if ((op != opGoto) && (op != opReturn) && (next != NULL)) AddEdge(bb, next);
+  }
+}
+
+void CCfg::ComputeDominators(void)
+{
+  if (_blocks.empty()) return;
+
+  // number the reachable blocks in reverse postorder
+  vector<CBasicBlock*> post;
+  vector<bool> visited(_blocks.size(), false);
+  vector<pair<CBasicBlock*, size_t> > stack;
+
+  stack.push_back(make_pair(GetEntry(), 0));
+  visited[0] = true;
+  while (!stack.empty()) {
+    CBasicBlock *bb = stack.back().first;
+    size_t &s = stack.back().second;
+
+    if (s < bb->_succ.size()) {
+      CBasicBlock *succ = bb->_succ[s++];
+      if (!visited[succ->_id]) {
+        visited[succ->_id] = true;
+        stack.push_back(make_pair(succ, 0));
+      }
+    } else {
+      post.push_back(bb);
+      stack.pop_back();
+    }
+  }
+
+  _rpo.assign(post.rbegin(), post.rend());
+  for (size_t i=0; i<_rpo.size(); i++) _rpo[i]->_rpo = i;
+
+  // iterative dominator computation (Cooper, Harvey & Kennedy)
+  CBasicBlock *entry = GetEntry();
+  entry->_idom = entry;
+
+  bool changed = true;
+  while (changed) {
+    changed = false;
+
+    for (size_t i=1; i<_rpo.size(); i++) {
+      CBasicBlock *bb = _rpo[i];
+      CBasicBlock *idom = NULL;
+
+      for (const auto &p : bb->_pred) {
+        if (p->_idom == NULL) continue;
+        if (idom == NULL) { idom = p; continue; }
+
+        CBasicBlock *a = p, *b = idom;
+        while (a != b) {
+          while (a->_rpo > b->_rpo) a = a->_idom;
+          while (b->_rpo > a->_rpo) b = b->_idom;
+        }
+        idom = a;
+      }
+
+      if (bb->_idom != idom) {
+        bb->_idom = idom;
+        changed = true;
+      }
+    }
+  }
+
+  entry->_idom = NULL;
+}
+
+void CCfg::FindLoops(void)
+{
+  // collect the back edges, grouped by header
+  map<CBasicBlock*, CLoop*> headers;
+  vector<CLoop*> loops;
+
+  for (const auto &bb : _rpo) {
+    for (const auto &h : bb->_succ) {
+      if (!Dominates(h, bb)) continue;
+
+      CLoop *&l = headers[h];
+      if (l == NULL) {
+        l = new CLoop(h);
+        l->_member.assign(_blocks.size(), false);
+        l->_member[h->_id] = true;
+        loops.push_back(l);
+      }
+      l->_latches.push_back(bb);
+    }
+  }
+
+  // the body of a natural loop consists of all blocks that reach a latch
+  // without passing through the header
+  for (const auto &l : loops) {
+    vector<CBasicBlock*> work(l->_latches);
+
+    while (!work.empty()) {
+      CBasicBlock *bb = work.back();
+      work.pop_back();
+      if (l->_member[bb->_id]) continue;
+
+      l->_member[bb->_id] = true;
+      for (const auto &p : bb->_pred) {
+        if (p->IsReachable()) work.push_back(p);
+      }
+    }
+
+    for (const auto &bb : _blocks) {
+      if (l->_member[bb->_id]) l->_blocks.push_back(bb);
+    }
+  }
+
+  // nesting: an enclosing loop is always larger than the loops it contains
+  stable_sort(loops.begin(), loops.end(),
+              [](const CLoop *a, const CLoop *b)
+              { return a->_blocks.size() > b->_blocks.size(); });
+
+  for (size_t i=0; i<loops.size(); i++) {
+    CLoop *l = loops[i];
+
+    for (size_t j=0; j<i; j++) {
+      if (loops[j]->Contains(l->_header) &&
+          ((l->_parent == NULL) ||
+           (loops[j]->_blocks.size() < l->_parent->_blocks.size()))) {
+        l->_parent = loops[j];
+      }
+    }
+    if (l->_parent != NULL) l->_parent->_subloops.push_back(l);
+
+    for (const auto &bb : l->_blocks) bb->_loop = l;
+
+    _loops.push_back(l);
+  }
+
+  for (const auto &l : _loops) ComputeTripCount(l);
+}
+
+/// @brief return the relation with swapped operands
+static EOperation Mirror(EOperation op)
+{
+  switch (op) {
+    case opLessThan:    return opBiggerThan;
+    case opLessEqual:   return opBiggerEqual;
+    case opBiggerThan:  return opLessThan;
+    case opBiggerEqual: return opLessEqual;
+    default:            return op;
+  }
+}
+
+/// @brief number of iterations of a loop "i := c0; while (i op c) i := i + k"
+///        (-1 if the loop does not terminate without overflow)
+static long long Iterations(EOperation op, long long c0, long long c,
+                            long long k)
+{
+  switch (op) {
+    case opLessThan:
+      if (c0 >= c) return 0;
+      return k > 0 ? (c - c0 + k - 1) / k : -1;
+    case opLessEqual:
+      if (c0 > c) return 0;
+      return k > 0 ? (c - c0) / k + 1 : -1;
+    case opBiggerThan:
+      if (c0 <= c) return 0;
+      return k < 0 ? (c0 - c - k - 1) / -k : -1;
+    case opBiggerEqual:
+      if (c0 < c) return 0;
+      return k < 0 ? (c0 - c) / -k + 1 : -1;
+    case opNotEqual:
+      if (c0 == c) return 0;
+      if ((k == 0) || ((c - c0) % k != 0) || ((c - c0) / k < 0)) return -1;
+      return (c - c0) / k;
+    case opEqual:
+      if (c0 != c) return 0;
+      return k != 0 ? 1 : -1;
+    default:
+      return -1;
+  }
+}
+
+/// @brief returns true if @a a names symbol @a s directly (not a reference)
+static bool IsName(const CTac *a, const CSymbol *s)
+{
+  const CTacName *n = dynamic_cast<const CTacName*>(a);
+  return (n != NULL) && (dynamic_cast<const CTacReference*>(a) == NULL) &&
+         (n->GetSymbol() == s);
+}
+
+void CCfg::ComputeTripCount(CLoop *loop)
+{
+  // we recognize loops of the form
+  //
+  //   i := c0; while (i relop c) do ... i := i +/- k ... end
+  //
+  // where i is a scalar variable that is assigned exactly once in the loop
+  // on every iteration, and c0, c, and k are constants.
+  CBasicBlock *h = loop->_header;
+  CTacInstr *br = h->GetLast();
+  if ((br == NULL) || !IsRelOp(br->GetOperation())) return;
+
+  CBasicBlock *target = GetBlock(dynamic_cast<CTacLabel*>(br->GetDest()));
+  CBasicBlock *next = h->_id+1 < (int)_blocks.size() ? _blocks[h->_id+1] : NULL;
+  if (loop->Contains(target) == loop->Contains(next)) return;
+
+  // relation under which the loop continues
+  EOperation op = br->GetOperation();
+  if (!loop->Contains(target)) op = NegateRelOp(op);
+
+  CTacAddr *var = br->GetSrc(1);
+  CTacConst *bound = dynamic_cast<CTacConst*>(br->GetSrc(2));
+  if (bound == NULL) {
+    var = br->GetSrc(2);
+    bound = dynamic_cast<CTacConst*>(br->GetSrc(1));
+    op = Mirror(op);
+  }
+  if ((bound == NULL) || (dynamic_cast<CTacTemp*>(var) != NULL) ||
+      (dynamic_cast<CTacReference*>(var) != NULL)) return;
+
+  CTacName *name = dynamic_cast<CTacName*>(var);
+  if ((name == NULL) || !name->GetSymbol()->GetDataType()->IsInt()) return;
+  const CSymbol *sym = name->GetSymbol();
+
+  // find the single update of the variable in the loop
+  CTacInstr *update = NULL;
+  CBasicBlock *ubb = NULL;
+  for (const auto &bb : loop->_blocks) {
+    for (const auto &i : bb->_instr) {
+      if (IsName(i->GetDest(), sym)) {
+        if (update != NULL) return;
+        update = i;
+        ubb = bb;
+      }
+
+      // calls may modify global variables
+      if ((i->GetOperation() == opCall) &&
+          (sym->GetSymbolType() == stGlobal)) {
+        const CTacName *callee = dynamic_cast<const CTacName*>(i->GetSrc(1));
+        const CSymProc *proc =
+          dynamic_cast<const CSymProc*>(callee->GetSymbol());
+        if ((proc == NULL) || proc->WritesGlobal(sym)) return;
+      }
+    }
+  }
+  if (update == NULL) return;
+
+  for (const auto &l : loop->_latches) {
+    if (!Dominates(ubb, l)) return;
+  }
+
+  // the update is either "i := i +/- k" or "t := i +/- k; i := t"
+  CTacInstr *step = update;
+  if (update->GetOperation() == opAssign) {
+    CTacTemp *t = dynamic_cast<CTacTemp*>(update->GetSrc(1));
+    if (t == NULL) return;
+
+    step = NULL;
+    for (const auto &i : ubb->_instr) {
+      if (i == update) break;
+      CTacTemp *d = dynamic_cast<CTacTemp*>(i->GetDest());
+      if ((d != NULL) && (d->GetSymbol() == t->GetSymbol())) step = i;
+    }
+    if (step == NULL) return;
+  }
+
+  long long k;
+  EOperation sop = step->GetOperation();
+  CTacConst *kc = dynamic_cast<CTacConst*>(step->GetSrc(2));
+  if (((sop == opAdd) || (sop == opSub)) && IsName(step->GetSrc(1), sym) &&
+      (kc != NULL)) {
+    k = sop == opAdd ? kc->GetValue() : -kc->GetValue();
+  } else if ((sop == opAdd) && IsName(step->GetSrc(2), sym) &&
+             ((kc = dynamic_cast<CTacConst*>(step->GetSrc(1))) != NULL)) {
+    k = kc->GetValue();
+  } else {
+    return;
+  }
+
+  // find the initial value on the path leading to the loop
+  CBasicBlock *pre = NULL;
+  for (const auto &p : h->_pred) {
+    if (loop->Contains(p)) continue;
+    if (pre != NULL) return;
+    pre = p;
+  }
+
+  CTacConst *init = NULL;
+  for (size_t n=0; (pre != NULL) && (n < _blocks.size()); n++) {
+    for (list<CTacInstr*>::reverse_iterator it = pre->_instr.rbegin();
+         it != pre->_instr.rend(); it++) {
+      if (IsName((*it)->GetDest(), sym)) {
+        if ((*it)->GetOperation() != opAssign) return;
+        init = dynamic_cast<CTacConst*>((*it)->GetSrc(1));
+        if (init == NULL) return;
+        break;
+      }
+    }
+    if (init != NULL) break;
+
+    pre = pre->_pred.size() == 1 ? pre->_pred[0] : NULL;
+  }
+  if (init == NULL) return;
+
+  loop->_trip = Iterations(op, init->GetValue(), bound->GetValue(), k);
+}
+
+ostream& CCfg::print(ostream &out, int indent) const
+{
+  string ind(indent, ' ');
+
+  out << ind << "[[ cfg " << _cb->GetName() << endl;
+
+  for (const auto &bb : _blocks) bb->print(out, indent+2);
+
+  for (const auto &l : _loops) {
+    out << ind << "  loop BB" << l->_header->_id
+        << "  depth: " << l->GetDepth()
+        << "  trip count: ";
+    if (l->_trip < 0) out << "unknown"; else out << l->_trip;
+    out << "  blocks:";
+    for (const auto &bb : l->_blocks) out << " BB" << bb->_id;
+    out << endl;
+  }
+
+  out << ind << "]]" << endl;
+
+  return out;
+}
+
+ostream& operator<<(ostream &out, const CCfg &t)
+{
+  return t.print(out);
+}
+
+ostream& operator<<(ostream &out, const CCfg *t)
+{
+  return t->print(out);
+}
@@ -0,0 +1,273 @@
+//------------------------------------------------------------------------------
+/// @brief SnuPL control flow graph
+//------------------------------------------------------------------------------
+
+#ifndef __SnuPL_CFG_H__
+#define __SnuPL_CFG_H__
+
+#include <iostream>
+#include <list>
+#include <map>
+#include <vector>
+
+#include "ir.h"
+
+using namespace std;
+
+class CCfg;
+class CLoop;
+
+//------------------------------------------------------------------------------
+/// @brief basic block
+///
+/// a maximal sequence of TAC instructions with a single entry (the first
+/// instruction) and a single exit (the last instruction). Basic blocks do not
+/// own their instructions; they reference the instructions of a CCodeBlock.
+///
+class CBasicBlock {
+  public:
+    /// @name constructor/destructor
+    /// @{
+
+    /// @brief constructor
+    /// @param id block number (position in the code block)
+    CBasicBlock(int id);
+
+    /// @}
+
+    /// @name properties
+    /// @{
+
+    /// @brief return the block number
+    int GetId(void) const;
+
+    /// @brief return the instructions of this block
+    const list<CTacInstr*>& GetInstr(void) const;
+
+    /// @brief return the label starting this block (NULL if none)
+    CTacLabel* GetLabel(void) const;
+
+    /// @brief return the last instruction of this block (NULL if empty)
+    CTacInstr* GetLast(void) const;
+
+    /// @brief return the successors of this block
+    const vector<CBasicBlock*>& GetSucc(void) const;
+
+    /// @brief return the predecessors of this block
+    const vector<CBasicBlock*>& GetPred(void) const;
+
+    /// @brief return the immediate dominator (NULL for the entry block and
+    ///        for unreachable blocks)
+    CBasicBlock* GetIDom(void) const;
+
+    /// @brief returns true if the block is reachable from the entry block
+    bool IsReachable(void) const;
+
+    /// @brief return the innermost loop containing this block (NULL if none)
+    CLoop* GetLoop(void) const;
+
+    /// @brief return the source line of the first instruction
+    int GetLineNumber(void) const;
+
+    /// @}
+
+    /// @name output
+    /// @{
+
+    /// @brief print the block to an output stream
+    /// @param out output stream
+    /// @param indent indentation
+    ostream& print(ostream &out, int indent=0) const;
+
+    /// @}
+
+  protected:
+    int _id;                        ///< block number
+    list<CTacInstr*> _instr;        ///< instructions
+    vector<CBasicBlock*> _succ;     ///< successor blocks
+    vector<CBasicBlock*> _pred;     ///< predecessor blocks
+    CBasicBlock *_idom;             ///< immediate dominator
+    int _rpo;                       ///< reverse postorder number (-1: unreachable)
+    CLoop *_loop;                   ///< innermost enclosing loop
+
+    friend class CCfg;
+};
+
+/// @name CBasicBlock output operators
+/// @{
+
+/// @brief CBasicBlock output operator
+///
+/// @param out output stream
+/// @param t reference to CBasicBlock
+/// @retval output stream
+ostream& operator<<(ostream &out, const CBasicBlock &t);
+
+/// @brief CBasicBlock output operator
+///
+/// @param out output stream
+/// @param t reference to CBasicBlock
+/// @retval output stream
+ostream& operator<<(ostream &out, const CBasicBlock *t);
+
+/// @}
+
+
+//------------------------------------------------------------------------------
+/// @brief natural loop
+///
+/// the blocks of all back edges to the same header form one natural loop.
+/// Loops are properly nested; the loop depth of an outermost loop is 1.
+///
+class CLoop {
+  public:
+    /// @name constructor/destructor
+    /// @{
+
+    /// @brief constructor
+    /// @param header loop header
+    CLoop(CBasicBlock *header);
+
+    /// @}
+
+    /// @name properties
+    /// @{
+
+    /// @brief return the loop header
+    CBasicBlock* GetHeader(void) const;
+
+    /// @brief return the blocks of the loop (including those of inner loops)
+    const vector<CBasicBlock*>& GetBlocks(void) const;
+
+    /// @brief return the sources of the back edges to the header
+    const vector<CBasicBlock*>& GetLatches(void) const;
+
+    /// @brief returns true if @a bb is part of this loop
+    bool Contains(const CBasicBlock *bb) const;
+
+    /// @brief return the enclosing loop (NULL for outermost loops)
+    CLoop* GetParent(void) const;
+
+    /// @brief return the directly nested loops
+    const vector<CLoop*>& GetSubloops(void) const;
+
+    /// @brief return the nesting depth (1 for outermost loops)
+    int GetDepth(void) const;
+
+    /// @brief return the number of iterations of the loop body if it is
+    ///        known at compile time, -1 otherwise
+    long long GetTripCount(void) const;
+
+    /// @}
+
+  protected:
+    CBasicBlock *_header;           ///< loop header
+    vector<CBasicBlock*> _blocks;   ///< blocks in the loop
+    vector<CBasicBlock*> _latches;  ///< back edge sources
+    vector<bool> _member;           ///< membership by block number
+    CLoop *_parent;                 ///< enclosing loop
+    vector<CLoop*> _subloops;       ///< nested loops
+    long long _trip;                ///< trip count (-1: unknown)
+
+    friend class CCfg;
+};
+
+
+//------------------------------------------------------------------------------
+/// @brief control flow graph
+///
+/// the control flow graph of a code block with dominator tree and natural
+/// loops. The graph references the instructions of the code block; it has to
+/// be rebuilt whenever the code block is modified.
+///
+class CCfg {
+  public:
+    /// @name constructor/destructor
+    /// @{
+
+    /// @brief constructor
+    /// @param cb code block
+    CCfg(CCodeBlock *cb);
+
+    /// @brief destructor
+    ~CCfg(void);
+
+    /// @}
+
+    /// @name properties
+    /// @{
+
+    /// @brief return the code block
+    CCodeBlock* GetCodeBlock(void) const;
+
+    /// @brief return the basic blocks in code block order
+    const vector<CBasicBlock*>& GetBlocks(void) const;
+
+    /// @brief return the entry block (NULL if the code block is empty)
+    CBasicBlock* GetEntry(void) const;
+
+    /// @brief return the block starting with @a label (NULL if none)
+    CBasicBlock* GetBlock(const CTacLabel *label) const;
+
+    /// @brief returns true if @a a dominates @a b
+    bool Dominates(const CBasicBlock *a, const CBasicBlock *b) const;
+
+    /// @brief return all loops, outer loops before inner loops
+    const vector<CLoop*>& GetLoops(void) const;
+
+    /// @}
+
+    /// @name output
+    /// @{
+
+    /// @brief print the graph to an output stream
+    /// @param out output stream
+    /// @param indent indentation
+    ostream& print(ostream &out, int indent=0) const;
+
+    /// @}
+
+  protected:
+    /// @brief split the code block into basic blocks and connect them
+    void BuildBlocks(void);
+
+    /// @brief compute the immediate dominators
+    void ComputeDominators(void);
+
+    /// @brief find the natural loops and their nesting
+    void FindLoops(void);
+
+    /// @brief compute the trip count of @a loop if possible
+    void ComputeTripCount(CLoop *loop);
+
+    /// @brief add an edge from @a from to @a to
+    void AddEdge(CBasicBlock *from, CBasicBlock *to);
+
+    CCodeBlock *_cb;                ///< code block
+    vector<CBasicBlock*> _blocks;   ///< basic blocks
+    vector<CBasicBlock*> _rpo;      ///< reachable blocks in reverse postorder
+    map<const CTacLabel*, CBasicBlock*> _labels; ///< label to block map
+    vector<CLoop*> _loops;          ///< natural loops
+};
+
+/// @name CCfg output operators
+/// @{
+
+/// @brief CCfg output operator
+///
+/// @param out output stream
+/// @param t reference to CCfg
+/// @retval output stream
+ostream& operator<<(ostream &out, const CCfg &t);
+
+/// @brief CCfg output operator
+///
+/// @param out output stream
+/// @param t reference to CCfg
+/// @retval output stream
+ostream& operator<<(ostream &out, const CCfg *t);
+
+/// @}
+
+
+#endif // __SnuPL_CFG_H__
@@ -0,0 +1,439 @@
+//------------------------------------------------------------------------------
+/// @brief SnuPL static cost model
+//------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <iomanip>
+#include <set>
+#include <sstream>
+
+#include "cost.h"
+#include "remarks.h"
+using namespace std;
+
+
+//------------------------------------------------------------------------------
+// instruction latencies (IA32, in cycles)
+//
+static const struct {
+  const char *mnemonic;
+  int latency;
+} x86Latency[] = {
+  { "movl",    1 }, { "movzbl",  1 }, { "movzwl",  1 }, { "movb",    1 },
+  { "movw",    1 }, { "mov",     1 }, { "leal",    1 }, { "addl",    1 },
+  { "subl",    1 }, { "adcl",    1 }, { "sbbl",    1 }, { "andl",    1 },
+  { "orl",     1 }, { "xorl",    1 }, { "negl",    1 }, { "notl",    1 },
+  { "incl",    1 }, { "cmpl",    1 }, { "cdq",     1 }, { "imull",   3 },
+  { "idivl",  26 }, { "pushl",   1 }, { "popl",    1 }, { "call",    2 },
+  { "ret",     2 }, { "jmp",     1 }, { "cld",     1 }, { "rep",    20 },
+  { "rdtsc",  25 }, { "nop",     0 },
+};
+
+// additional latency of a memory load/store (L1 hit)
+#define LOAD_LATENCY  4
+#define STORE_LATENCY 1
+
+// estimated cycles spent in the runtime routines (excl. the call itself)
+// I/O routines perform one system call per invocation (ReadInt: per char)
+static const struct {
+  const char *name;
+  int cycles;
+  bool io;
+} rteCost[] = {
+  { "DIM",         10, false },
+  { "DOFS",         8, false },
+  { "ReadInt",   6000, true  },
+  { "WriteInt",  1500, true  },
+  { "WriteChar", 1200, true  },
+  { "WriteStr",  1500, true  },
+  { "WriteLn",   1200, true  },
+};
+
+// frames larger than this are reported as expensive to clear
+#define LARGE_FRAME 1024
+
+static ostream null_out(NULL);
+
+
+//------------------------------------------------------------------------------
+// CCostModel
+//
+CCostModel::CCostModel(void)
+  : CBackendx86(null_out), _instr(NULL)
+{
+  // the code is only priced
+  SetComments(false);
+}
+
+CCostModel::~CCostModel(void)
+{
+}
+
+void CCostModel::Analyze(CModule *m)
+{
+  assert(m != NULL);
+  _m = m;
+
+  // analyze callees before callers so that calls can be charged with the
+  // cost of the callee; scopes on a call cycle see each other as recursive
+  for (const auto &s : m->GetSubscopes()) _procs[s->GetName()] = s;
+
+  vector<CScope*> order, work;
+  set<CScope*> seen;
+  vector<pair<CScope*, list<CTacInstr*>::const_iterator> > stack;
+
+  work.push_back(m);
+  for (const auto &s : m->GetSubscopes()) work.push_back(s);
+
+  for (const auto &root : work) {
+    if (seen.count(root)) continue;
+    seen.insert(root);
+    stack.push_back(make_pair(root, root->GetCodeBlock()->GetInstr().begin()));
+
+    while (!stack.empty()) {
+      CScope *s = stack.back().first;
+      list<CTacInstr*>::const_iterator &it = stack.back().second;
+
+      if (it == s->GetCodeBlock()->GetInstr().end()) {
+        order.push_back(s);
+        stack.pop_back();
+        continue;
+      }
+
+      CTacInstr *i = *it++;
+      if (i->GetOperation() != opCall) continue;
+
+      const CTacName *n = dynamic_cast<const CTacName*>(i->GetSrc(1));
+      map<string, CScope*>::iterator p = _procs.find(n->GetSymbol()->GetName());
+      if ((p != _procs.end()) && !seen.count(p->second)) {
+        seen.insert(p->second);
+        stack.push_back(make_pair(p->second,
+                                  p->second->GetCodeBlock()->GetInstr().begin()));
+      }
+    }
+  }
+
+  // the backend must not report remarks a second time
+  CRemarks *rm = CRemarks::Get();
+  int filter = rm->GetFilter();
+  rm->SetFilter(0);
+
+  for (const auto &s : order) AnalyzeScope(s);
+
+  rm->SetFilter(filter);
+}
+
+void CCostModel::AnalyzeScope(CScope *scope)
+{
+  // price the code emitted by the backend
+  _instr = NULL;
+  _frame = 0;
+  _rep = 0;
+  _memset = 0;
+  _recursive = false;
+  _icost.clear();
+  _icall.clear();
+  _idiv.clear();
+
+  SetScope(scope);
+  CBackendx86::EmitScope(scope);
+
+  // cost of the basic blocks
+  CCfg cfg(scope->GetCodeBlock());
+  map<CBasicBlock*, double> bcost;
+
+  for (const auto &bb : cfg.GetBlocks()) {
+    double c = 0;
+    for (const auto &i : bb->GetInstr()) c += _icost[i];
+    bcost[bb] = bb->IsReachable() ? c : 0;
+  }
+
+  // cost of one invocation
+  double total = _frame;
+  for (const auto &bb : cfg.GetBlocks()) {
+    if (bb->GetLoop() == NULL) total += bcost[bb];
+  }
+
+  // loops, outermost first. The number of times a loop is entered per
+  // invocation is the product of the iterations of the enclosing loops.
+  map<CLoop*, double> entries;
+  size_t first = _loops.size();
+
+  for (const auto &l : cfg.GetLoops()) {
+    double e = 1.0;
+    CLoop *p = l->GetParent();
+    if (p != NULL) {
+      long long trip = p->GetTripCount();
+      e = entries[p] * (trip < 0 ? DefaultTripCount : trip) *
+          Weight(p, l->GetHeader());
+    }
+    entries[l] = e;
+
+    SLoopCost lc;
+    lc.scope = scope;
+    lc.line = l->GetHeader()->GetLineNumber();
+    lc.depth = l->GetDepth();
+    lc.trip = l->GetTripCount();
+    lc.entry = LoopCost(l, bcost);
+    lc.total = e * lc.entry;
+    _loops.push_back(lc);
+
+    if (p == NULL) total += lc.entry;
+  }
+
+  // expensive patterns in loops
+  for (const auto &bb : cfg.GetBlocks()) {
+    CLoop *l = bb->GetLoop();
+    if ((l == NULL) || !bb->IsReachable()) continue;
+
+    ostringstream where;
+    where << " in loop (depth " << l->GetDepth() << ", ";
+    if (l->GetTripCount() < 0) where << "unknown trip count)";
+    else where << l->GetTripCount() << " iterations)";
+
+    for (const auto &i : bb->GetInstr()) {
+      int line = i->GetLineNumber();
+
+      if (_idiv[i]) Flag(scope, line, "idivl" + where.str());
+
+      if (_icall.count(i)) {
+        string callee = _icall[i];
+        for (size_t r=0; r<sizeof(rteCost)/sizeof(rteCost[0]); r++) {
+          if (callee != rteCost[r].name) continue;
+          if (rteCost[r].io) Flag(scope, line, "I/O system call (" + callee +
+                                  ")" + where.str());
+          else Flag(scope, line, "runtime " + callee + " call" + where.str());
+        }
+      }
+    }
+  }
+
+  if (_memset >= LARGE_FRAME) {
+    ostringstream msg;
+    msg << "rep stosl clears a " << _memset << " byte frame on every call";
+    Flag(scope, scope->GetLineNumber(), msg.str());
+  }
+
+  SScopeCost sc;
+  sc.scope = scope;
+  sc.total = total;
+  sc.frame = _frame;
+  sc.nloops = _loops.size() - first;
+  sc.recursive = _recursive;
+  _scopes.push_back(sc);
+
+  _cost[scope] = total;
+}
+
+double CCostModel::Weight(CLoop *loop, CBasicBlock *bb) const
+{
+  // code that does not execute on every iteration is assumed to execute on
+  // every other iteration
+  for (const auto &l : loop->GetLatches()) {
+    CBasicBlock *b = l;
+    bool dom = false;
+    while (b != NULL) {
+      if (b == bb) { dom = true; break; }
+      b = b->GetIDom();
+    }
+    if (!dom) return 0.5;
+  }
+  return 1.0;
+}
+
+double CCostModel::LoopCost(CLoop *loop, map<CBasicBlock*, double> &bcost) const
+{
+  double body = 0;
+
+  for (const auto &bb : loop->GetBlocks()) {
+    if (bb->GetLoop() == loop) body += Weight(loop, bb) * bcost[bb];
+  }
+  for (const auto &l : loop->GetSubloops()) {
+    body += Weight(loop, l->GetHeader()) * LoopCost(l, bcost);
+  }
+
+  long long trip = loop->GetTripCount();
+  if (trip < 0) trip = DefaultTripCount;
+
+  // the header is executed once more to exit the loop
+  return trip * body + bcost[loop->GetHeader()];
+}
+
+void CCostModel::Flag(CScope *scope, int line, string message)
+{
+  for (auto &f : _flags) {
+    if ((f.scope == scope) && (f.line == line) && (f.message == message)) {
+      f.count++;
+      return;
+    }
+  }
+
+  SFlag f;
+  f.scope = scope;
+  f.line = line;
+  f.message = message;
+  f.count = 1;
+  _flags.push_back(f);
+}
+
+void CCostModel::EmitInstruction(CTacInstr *i)
+{
+  _instr = i;
+  _icost[i] = 0;
+  CBackendx86::EmitInstruction(i);
+  _instr = NULL;
+}
+
+void CCostModel::EmitInstruction(const string &mnemonic, const string &args,
+                                 const string &)
+{
+  double c = Latency(mnemonic) + MemoryCost(mnemonic, args);
+
+  if ((mnemonic == "movl") && (args.find(", %ecx") != string::npos) &&
+      (args[0] == '$')) {
+    _rep = atoi(args.c_str() + 1);
+  }
+  if (mnemonic == "rep") {
+    c += _rep / 4.0;
+    _memset = _rep * 4;
+  }
+
+  if (mnemonic == "call") {
+    bool found = false;
+    for (size_t r=0; r<sizeof(rteCost)/sizeof(rteCost[0]); r++) {
+      if (args == rteCost[r].name) {
+        c += rteCost[r].cycles;
+        found = true;
+      }
+    }
+    if (!found) {
+      map<string, CScope*>::const_iterator p = _procs.find(args);
+      if ((p != _procs.end()) && _cost.count(p->second)) c += _cost[p->second];
+      else _recursive = true;
+    }
+    if (_instr != NULL) _icall[_instr] = args;
+  }
+
+  if ((mnemonic == "idivl") && (_instr != NULL)) _idiv[_instr] = true;
+
+  if (_instr != NULL) _icost[_instr] += c;
+  else _frame += c;
+}
+
+int CCostModel::Latency(const string mnemonic) const
+{
+  if (mnemonic.empty() || (mnemonic[0] == '#')) return 0;
+
+  for (size_t i=0; i<sizeof(x86Latency)/sizeof(x86Latency[0]); i++) {
+    if (mnemonic == x86Latency[i].mnemonic) return x86Latency[i].latency;
+  }
+
+  // conditional jumps and unknown instructions
+  return 1;
+}
+
+int CCostModel::MemoryCost(const string mnemonic, const string args) const
+{
+  if (args.empty() || (mnemonic[0] == 'j') || (mnemonic == "call") ||
+      (mnemonic[0] == '#')) return 0;
+
+  // split AT&T operands "src, dst"
+  vector<string> ops;
+  size_t pos = 0, comma;
+  while ((comma = args.find(", ", pos)) != string::npos) {
+    ops.push_back(args.substr(pos, comma - pos));
+    pos = comma + 2;
+  }
+  ops.push_back(args.substr(pos));
+
+  int cost = 0;
+  for (size_t i=0; i<ops.size(); i++) {
+    const string &o = ops[i];
+    bool mem = (o.find('(') != string::npos) ||
+               ((o[0] != '$') && (o[0] != '%') && (mnemonic != "rep"));
+    if (!mem) continue;
+
+    if (i+1 < ops.size()) cost += LOAD_LATENCY;               // source
+    else if ((mnemonic.compare(0, 3, "mov") == 0) ||
+             (mnemonic == "popl")) cost += STORE_LATENCY;      // store
+    else if ((mnemonic == "cmpl") || (mnemonic == "pushl") ||
+             (mnemonic == "imull") || (mnemonic == "idivl"))
+      cost += LOAD_LATENCY;                                    // read only
+    else cost += LOAD_LATENCY + STORE_LATENCY;                 // read-modify-write
+  }
+
+  return cost;
+}
+
+ostream& CCostModel::print(ostream &out, const string file) const
+{
+  out << "cost report for " << file << endl
+      << "  estimated cycles per invocation, based on the latencies of the" << endl
+      << "  generated IA32 code. Loops with an unknown trip count are assumed" << endl
+      << "  to run " << DefaultTripCount << " times; conditional code in loops "
+      << "is assumed to run on" << endl
+      << "  every other iteration." << endl
+      << endl;
+
+  // procedures, most expensive first
+  vector<SScopeCost> scopes(_scopes);
+  stable_sort(scopes.begin(), scopes.end(),
+              [](const SScopeCost &a, const SScopeCost &b)
+              { return a.total > b.total; });
+
+  out << "procedures:" << endl
+      << "  " << right << setw(16) << "cycles/call" << setw(10) << "frame"
+      << setw(7) << "loops" << "  " << left << setw(20) << "procedure"
+      << "line" << endl;
+  for (const auto &s : scopes) {
+    out << "  " << right << fixed << setprecision(0)
+        << setw(16) << s.total << setw(10) << s.frame << setw(7) << s.nloops
+        << "  " << left << setw(20) << s.scope->GetDisplayName()
+        << s.scope->GetLineNumber();
+    if (s.recursive) out << "  (recursive calls not included)";
+    out << endl;
+  }
+  out << endl;
+
+  // loops, most expensive first
+  vector<SLoopCost> loops(_loops);
+  stable_sort(loops.begin(), loops.end(),
+              [](const SLoopCost &a, const SLoopCost &b)
+              { return a.total > b.total; });
+
+  out << "loops:" << endl
+      << "  " << right << setw(16) << "cycles/call" << setw(8) << "share"
+      << setw(7) << "depth" << setw(10) << "trip" << "  " << left
+      << setw(20) << "procedure" << "line" << endl;
+  for (const auto &l : loops) {
+    double share = 0;
+    for (const auto &s : _scopes) {
+      if ((s.scope == l.scope) && (s.total > 0)) share = 100.0 * l.total / s.total;
+    }
+
+    ostringstream trip;
+    if (l.trip < 0) trip << "?"; else trip << l.trip;
+
+    out << "  " << right << fixed << setprecision(0)
+        << setw(16) << l.total << setw(7) << setprecision(1) << share << "%"
+        << setw(7) << l.depth << setw(10) << trip.str()
+        << "  " << left << setw(20) << l.scope->GetDisplayName() << l.line
+        << endl;
+  }
+  if (loops.empty()) out << "  (none)" << endl;
+  out << endl;
+
+  // expensive patterns
+  out << "expensive patterns:" << endl;
+  for (const auto &f : _flags) {
+    out << "  " << file << ":" << f.line << ": "
+        << f.scope->GetDisplayName() << ": " << f.message;
+    if (f.count > 1) out << " (" << f.count << "x)";
+    out << endl;
+  }
+  if (_flags.empty()) out << "  (none)" << endl;
+
+  return out;
+}
@@ -0,0 +1,131 @@
+//------------------------------------------------------------------------------
+/// @brief SnuPL static cost model
+//------------------------------------------------------------------------------
+
+#ifndef __SnuPL_COST_H__
+#define __SnuPL_COST_H__
+
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "backend.h"
+#include "cfg.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+/// @brief static cost model
+///
+/// estimates the number of cycles spent in each procedure and loop without
+/// running the program. The model runs the x86 backend on every scope and
+/// prices the emitted instructions with a latency table; loop nesting and
+/// trip counts are taken from the control flow graph. Calls are charged with
+/// the estimated cost of the callee.
+///
+/// Expensive patterns (runtime DIM/DOFS calls, divisions and I/O in loops,
+/// large frame memsets) are reported separately.
+///
+class CCostModel : public CBackendx86 {
+  public:
+    /// @name constructors/destructors
+    /// @{
+
+    CCostModel(void);
+    virtual ~CCostModel(void);
+
+    /// @}
+
+    /// @name analysis
+    /// @{
+
+    /// @brief estimate the cost of all scopes of module @a m
+    void Analyze(CModule *m);
+
+    /// @}
+
+    /// @name output
+    /// @{
+
+    /// @brief print the cost report
+    /// @param out output stream
+    /// @param file source file name
+    ostream& print(ostream &out, const string file) const;
+
+    /// @}
+
+    /// @brief assumed trip count of loops with an unknown trip count
+    static const int DefaultTripCount = 10;
+
+  protected:
+    /// @brief estimated cost of a loop
+    struct SLoopCost {
+      CScope *scope;                ///< scope containing the loop
+      int line;                     ///< source line of the loop header
+      int depth;                    ///< nesting depth
+      long long trip;               ///< trip count (-1: unknown)
+      double entry;                 ///< cycles per execution of the loop
+      double total;                 ///< cycles per invocation of the scope
+    };
+
+    /// @brief estimated cost of a scope
+    struct SScopeCost {
+      CScope *scope;                ///< the scope
+      double total;                 ///< cycles per invocation
+      double frame;                 ///< cycles spent in prologue/epilogue
+      int nloops;                   ///< number of loops
+      bool recursive;               ///< contains calls not fully accounted for
+    };
+
+    /// @brief expensive code pattern
+    struct SFlag {
+      CScope *scope;                ///< scope containing the pattern
+      int line;                     ///< source line
+      string message;               ///< description
+      int count;                    ///< number of occurrences on this line
+    };
+
+    /// @brief estimate the cost of @a scope
+    void AnalyzeScope(CScope *scope);
+
+    /// @brief estimated cost of one execution of @a loop
+    double LoopCost(CLoop *loop, map<CBasicBlock*, double> &bcost) const;
+
+    /// @brief relative execution frequency of @a bb within an iteration of
+    ///        @a loop
+    double Weight(CLoop *loop, CBasicBlock *bb) const;
+
+    /// @brief record an expensive pattern
+    void Flag(CScope *scope, int line, string message);
+
+    /// @brief price the x86 instructions emitted for @a i
+    virtual void EmitInstruction(CTacInstr *i);
+
+    /// @brief price an x86 instruction
+    virtual void EmitInstruction(const string &mnemonic, const string &args="",
+                                 const string &comment="");
+
+    /// @brief return the latency of @a mnemonic
+    int Latency(const string mnemonic) const;
+
+    /// @brief return the additional cost of memory operands in @a args
+    int MemoryCost(const string mnemonic, const string args) const;
+
+    CTacInstr *_instr;              ///< TAC instruction being priced
+    double _frame;                  ///< cost outside the body of the scope
+    map<CTacInstr*, double> _icost; ///< cost of each TAC instruction
+    map<CTacInstr*, string> _icall; ///< runtime/procedure called by instruction
+    map<CTacInstr*, bool> _idiv;    ///< instruction contains a division
+    int _rep;                       ///< count of the next rep-prefixed instruction
+    size_t _memset;                 ///< frame size cleared by rep stosl
+
+    map<string, CScope*> _procs;    ///< procedures by name
+    map<CScope*, double> _cost;     ///< cost per invocation of analyzed scopes
+    vector<SScopeCost> _scopes;     ///< per-scope results
+    vector<SLoopCost> _loops;       ///< per-loop results
+    vector<SFlag> _flags;           ///< expensive patterns
+    bool _recursive;                ///< current scope calls unanalyzed scopes
+};
+
+
+#endif // __SnuPL_COST_H__
@@ -0,0 +1,42 @@
+//------------------------------------------------------------------------------
+/// @brief SnuPL synthetic module generator
+//------------------------------------------------------------------------------
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "synth.h"
+using namespace std;
+
+//------------------------------------------------------------------------------
+// prints a synthetic SnuPL/1 module (see CModuleGenerator) to stdout
+//
+
+void Syntax(void)
+{
+  cout << "Usage: gen_module [--lines N] [--seed S]" << endl
+       << "Print a synthetic SnuPL/1 module of about N lines (default: 1000)." << endl;
+  exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+  long long lines = 1000;
+  unsigned long long seed = 1;
+
+  for (int i=1; i<argc; i++) {
+    if ((strcmp(argv[i], "--lines") == 0) && (i+1 < argc)) {
+      lines = atoll(argv[++i]);
+    } else if ((strcmp(argv[i], "--seed") == 0) && (i+1 < argc)) {
+      seed = strtoull(argv[++i], NULL, 10);
+    } else {
+      Syntax();
+    }
+  }
+
+  CModuleGenerator gen(seed);
+  cout << gen.Generate(lines);
+
+  return EXIT_SUCCESS;
+}
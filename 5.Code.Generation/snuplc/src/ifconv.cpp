@@ -0,0 +1,173 @@
+//------------------------------------------------------------------------------
+/// @brief SnuPL if-conversion
+//------------------------------------------------------------------------------
+
+#include <cassert>
+#include <sstream>
+
+#include "ifconv.h"
+#include "remarks.h"
+using namespace std;
+
+
+//------------------------------------------------------------------------------
+// CIfConversion
+//
+// profitability: executing both arms unconditionally must be cheaper than
+// a mispredicted branch (10-20 cycles). Arms are limited to MaxArm
+// instructions each and MaxSize instructions in total.
+//
+static const int MaxArm = 3;
+static const int MaxSize = 4;
+
+CIfConversion::CIfConversion(CModule *m)
+  : _m(m)
+{
+  assert(m != NULL);
+}
+
+int CIfConversion::Run(void)
+{
+  int n = Convert(_m);
+  for (const auto &s : _m->GetSubscopes()) n += Convert(s);
+  return n;
+}
+
+int CIfConversion::Run(CScope *scope)
+{
+  return Convert(scope);
+}
+
+int CIfConversion::Convert(CScope *scope)
+{
+  CCodeBlock *cb = scope->GetCodeBlock();
+  CRemarks *rm = CRemarks::Get();
+  int n = 0;
+  bool changed = true;
+
+  // converting an inner if statement may turn the enclosing one into a
+  // candidate; restart after every conversion
+  while (changed) {
+    changed = false;
+    vector<CTacInstr*> code(cb->GetInstr().begin(), cb->GetInstr().end());
+
+    for (size_t p=0; (p+3 < code.size()) && !changed; p++) {
+      CTacInstr *br = code[p];
+      if (!IsRelOp(br->GetOperation())) continue;
+
+      // if cond goto T; goto F; T:
+      CTacLabel *t = dynamic_cast<CTacLabel*>(br->GetDest());
+      CTacInstr *gf = code[p+1];
+      if ((gf->GetOperation() != opGoto) || (code[p+2] != t) ||
+          (t->GetRefCnt() != 1)) continue;
+      CTacLabel *f = dynamic_cast<CTacLabel*>(gf->GetDest());
+      if (f->GetRefCnt() != 1) continue;
+
+      // arm T; goto J; F: arm F; J:
+      size_t gj = p+3;
+      while ((gj < code.size()) && !code[gj]->IsBranch() &&
+             (code[gj]->GetOperation() != opLabel)) gj++;
+      if ((gj+1 >= code.size()) || (code[gj]->GetOperation() != opGoto) ||
+          (code[gj+1] != f)) continue;
+      CTacLabel *j = dynamic_cast<CTacLabel*>(code[gj]->GetDest());
+
+      size_t lj = gj+2;
+      while ((lj < code.size()) && !code[lj]->IsBranch() &&
+             (code[lj]->GetOperation() != opLabel)) lj++;
+      if ((lj >= code.size()) || (code[lj] != j)) continue;
+
+      SArm at, af;
+      if (!Arm(code, p+3, gj, at) || !Arm(code, gj+2, lj, af)) continue;
+      if ((at.assign == NULL) && (af.assign == NULL)) continue;
+
+      CTacInstr *last = af.assign != NULL ? af.assign : at.assign;
+      CTacName *dst = dynamic_cast<CTacName*>(last->GetDest());
+      if ((at.assign != NULL) && (af.assign != NULL)) {
+        CTacName *d = dynamic_cast<CTacName*>(at.assign->GetDest());
+        if (d->GetSymbol() != dst->GetSymbol()) continue;
+      } else if (dynamic_cast<CTacTemp*>(dst) != NULL) {
+        continue;
+      }
+
+      if (at.size + af.size > MaxSize) {
+        rm->Add(rkMissed, "ifconv", scope->GetDisplayName(),
+                br->GetLineNumber(),
+                "if statement not converted: arms too large (" +
+                to_string(at.size + af.size) + " instructions)");
+        continue;
+      }
+
+      CTacAddr *vt = at.assign != NULL ? at.assign->GetSrc(1) : dst;
+      CTacAddr *vf = af.assign != NULL ? af.assign->GetSrc(1) : dst;
+      CTacSelect *sel = new CTacSelect(br->GetOperation(), br->GetSrc(1),
+                                       br->GetSrc(2), dst, vt, vf);
+      int line = br->GetLineNumber();
+
+      // the select takes the place of the last assignment; the temporaries
+      // of both arms are computed before it
+      if (last != at.assign) cb->RemoveInstr(at.assign);
+      cb->RemoveInstr(br);
+      cb->RemoveInstr(gf);
+      cb->RemoveInstr(t);
+      cb->RemoveInstr(code[gj]);
+      cb->RemoveInstr(f);
+      cb->ReplaceInstr(last, sel);
+
+      ostringstream msg;
+      msg << "if statement converted to a select of '"
+          << dst->GetSymbol()->GetName() << "'";
+      rm->Add(rkPassed, "ifconv", scope->GetDisplayName(), line, msg.str());
+
+      n++;
+      changed = true;
+    }
+  }
+
+  if (n > 0) cb->CleanupControlFlow();
+
+  return n;
+}
+
+bool CIfConversion::Arm(const vector<CTacInstr*> &code, size_t from,
+                        size_t to, SArm &arm) const
+{
+  arm.size = to - from;
+  arm.assign = NULL;
+
+  if (arm.size == 0) return true;
+  if (arm.size > MaxArm) return false;
+
+  // temporaries computed by cheap, non-trapping operations, followed by
+  // the assignment to the selected variable
+  for (size_t k=from; k<to; k++) {
+    CTacInstr *i = code[k];
+    EOperation op = i->GetOperation();
+
+    if (k+1 == to) {
+      if ((op != opAssign) || !IsPlain(i->GetDest()) ||
+          !IsPlain(i->GetSrc(1))) return false;
+      arm.assign = i;
+    } else {
+      if ((op != opAdd) && (op != opSub) && (op != opNeg) && (op != opPos) &&
+          (op != opAssign)) return false;
+      if ((dynamic_cast<CTacTemp*>(i->GetDest()) == NULL) ||
+          !IsPlain(i->GetSrc(1)) ||
+          ((i->GetSrc(2) != NULL) && !IsPlain(i->GetSrc(2)))) return false;
+    }
+  }
+
+  return true;
+}
+
+bool CIfConversion::IsPlain(const CTac *op)
+{
+  if (dynamic_cast<const CTacConst*>(op) != NULL) return true;
+
+  const CTacName *n = dynamic_cast<const CTacName*>(op);
+  if ((n == NULL) || (dynamic_cast<const CTacReference*>(op) != NULL)) {
+    return false;
+  }
+
+  const CType *t = n->GetSymbol()->GetDataType();
+  return t->IsScalar() || t->IsBoolean();
+}
@@ -0,0 +1,79 @@
+//------------------------------------------------------------------------------
+/// @brief SnuPL if-conversion
+//------------------------------------------------------------------------------
+
+#ifndef __SnuPL_IFCONV_H__
+#define __SnuPL_IFCONV_H__
+
+#include <iostream>
+#include <vector>
+
+#include "ir.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+/// @brief if-conversion
+///
+/// replaces if statements whose arms consist of a few side-effect free
+/// assignments to the same scalar variable by a select (CTacSelect):
+///
+///     if a > b goto T             t0 <- ...          (arm T temporaries)
+///     goto F                      t1 <- ...          (arm F temporaries)
+///   T:                            m <- a > b ? vT : vF
+///     (t0 <- ...)
+///     m <- vT            =>
+///     goto J
+///   F:
+///     (t1 <- ...)
+///     m <- vF
+///   J:
+///
+/// An empty arm selects the variable itself. Both arms are executed
+/// unconditionally, so they must not contain memory references, calls,
+/// divisions, or writes to anything but fresh temporaries before the final
+/// assignment. The pass runs right before code generation since the other
+/// IR passes do not know about selects.
+///
+class CIfConversion {
+  public:
+    /// @name constructor/destructor
+    /// @{
+
+    /// @brief constructor
+    /// @param m module
+    CIfConversion(CModule *m);
+
+    /// @}
+
+    /// @brief convert all suitable if statements of the module
+    /// @retval int number of converted if statements
+    int Run(void);
+
+    /// @brief convert the if statements of a single scope @a scope
+    /// @retval int number of converted if statements
+    int Run(CScope *scope);
+
+  private:
+    /// @brief an arm of an if statement
+    struct SArm {
+      int size;                     ///< number of instructions
+      CTacInstr *assign;            ///< final assignment (NULL if empty)
+    };
+
+    /// @brief convert the if statements of @a scope
+    int Convert(CScope *scope);
+
+    /// @brief analyze the arm in @a code[from..to). Returns false if the
+    ///        arm cannot be executed unconditionally.
+    bool Arm(const vector<CTacInstr*> &code, size_t from, size_t to,
+             SArm &arm) const;
+
+    /// @brief returns true if @a op is a scalar operand that can be read
+    ///        without side effects
+    static bool IsPlain(const CTac *op);
+
+    CModule *_m;                    ///< module
+};
+
+#endif // __SnuPL_IFCONV_H__
@@ -0,0 +1,496 @@
+//------------------------------------------------------------------------------
+/// @brief SnuPL TAC interpreter and compile-time evaluation
+//------------------------------------------------------------------------------
+
+#include <cassert>
+#include <climits>
+#include <sstream>
+
+#include "interp.h"
+#include "remarks.h"
+using namespace std;
+
+
+//------------------------------------------------------------------------------
+// CTacInterpreter
+//
+// addresses handed out to the interpreted code start at MemBase so that they
+// are never mistaken for small integers (or NULL)
+//
+static const int MemBase = 0x10000;
+static const int MaxDepth = 1000;
+
+CTacInterpreter::CTacInterpreter(const CCallGraph *cg, int max_steps,
+                                 int max_memory)
+  : _cg(cg), _max_steps(max_steps), _max_memory(max_memory), _steps(0)
+{
+  assert(cg != NULL);
+}
+
+bool CTacInterpreter::Call(CScope *scope, const vector<int> &args,
+                           int &result)
+{
+  _steps = 0;
+  _error = "";
+  _mem.clear();
+
+  return Execute(scope, args, result, 0);
+}
+
+const string& CTacInterpreter::GetError(void) const
+{
+  return _error;
+}
+
+int CTacInterpreter::GetSteps(void) const
+{
+  return _steps;
+}
+
+void CTacInterpreter::SetMaxSteps(int max_steps)
+{
+  _max_steps = max_steps;
+}
+
+void CTacInterpreter::Invalidate(CScope *scope)
+{
+  _code.erase(scope);
+}
+
+const CTacInterpreter::SCode& CTacInterpreter::Code(CScope *scope)
+{
+  map<CScope*, SCode>::iterator it = _code.find(scope);
+  if (it != _code.end()) return it->second;
+
+  SCode &c = _code[scope];
+
+  // frame layout: arguments, zero-initialized locals and local arrays
+  map<const CSymbol*, int> slot;
+  for (const auto &s : scope->GetSymbolTable()->GetSymbols()) {
+    const CSymParam *p = dynamic_cast<const CSymParam*>(s);
+    if ((p == NULL) && (s->GetSymbolType() != stLocal)) continue;
+
+    SSlot sl;
+    sl.param = p != NULL ? p->GetIndex() : -1;
+    sl.array = p != NULL ? NULL
+                         : dynamic_cast<const CArrayType*>(s->GetDataType());
+    slot[s] = c.slot.size();
+    c.slot.push_back(sl);
+  }
+
+  // resolve the operands, index the labels and the targets of branches
+  const list<CTacInstr*> &ops = scope->GetCodeBlock()->GetInstr();
+  for (const auto &i : ops) {
+    if (i->GetOperation() == opLabel) c.label[i] = c.instr.size();
+
+    SInstr si;
+    si.instr = i;
+    si.dst = Operand(i->IsBranch() ? NULL : i->GetDest(), slot);
+    si.src1 = Operand(i->GetSrc(1), slot);
+    si.src2 = Operand(i->GetSrc(2), slot);
+    si.target = 0;
+
+    // only the address of local arrays can be taken
+    if ((i->GetOperation() == opAddress) && (si.src1.kind == oSlot) &&
+        (c.slot[si.src1.value].array == NULL)) si.src1.kind = oNonLocal;
+
+    c.instr.push_back(si);
+  }
+  for (auto &si : c.instr) {
+    if (si.instr->IsBranch()) si.target = c.label[si.instr->GetDest()];
+  }
+
+  return c;
+}
+
+CTacInterpreter::SOperand CTacInterpreter::Operand(const CTac *op,
+                               const map<const CSymbol*, int> &slot) const
+{
+  SOperand o = { oNone, 0, 0 };
+  if (op == NULL) return o;
+
+  const CTacConst *c = dynamic_cast<const CTacConst*>(op);
+  if (c != NULL) {
+    o.kind = oConst;
+    o.value = c->GetValue();
+    return o;
+  }
+
+  const CTacName *n = dynamic_cast<const CTacName*>(op);
+  if (n == NULL) return o;
+
+  o.kind = oNonLocal;
+  map<const CSymbol*, int>::const_iterator it = slot.find(n->GetSymbol());
+  if (it == slot.end()) return o;
+
+  const CTacReference *r = dynamic_cast<const CTacReference*>(n);
+  if (r != NULL) {
+    const CArrayType *a =
+      dynamic_cast<const CArrayType*>(r->GetDerefSymbol()->GetDataType());
+    if (a == NULL) return o;
+    o.kind = oRef;
+    o.size = a->GetBaseType()->GetDataSize();
+  } else {
+    o.kind = oSlot;
+    o.size = n->GetSymbol()->GetDataType()->GetDataSize();
+  }
+  o.value = it->second;
+
+  return o;
+}
+
+bool CTacInterpreter::Fail(string msg)
+{
+  if (_error == "") _error = msg;
+  return false;
+}
+
+bool CTacInterpreter::Execute(CScope *scope, const vector<int> &args,
+                              int &result, int depth)
+{
+  if (depth > MaxDepth) return Fail("call depth exceeded");
+
+  const CSymProc *proc = dynamic_cast<const CSymProc*>(scope->GetDeclaration());
+  if ((proc == NULL) || !proc->IsPure()) return Fail("not pure");
+
+  const SCode &c = Code(scope);
+  const vector<SInstr> &code = c.instr;
+
+  // set up the frame (array header as emitted by CBackendx86::EmitLocalData)
+  vector<int> f(c.slot.size(), 0);
+  size_t mem = _mem.size();
+
+  for (size_t k=0; k<c.slot.size(); k++) {
+    const SSlot &sl = c.slot[k];
+    if (sl.param >= 0) {
+      if (sl.param >= (int)args.size()) return Fail("missing argument");
+      f[k] = args[sl.param];
+      continue;
+    }
+
+    const CArrayType *a = sl.array;
+    if (a == NULL) continue;
+
+    int ndim = a->GetNDim();
+    int size = 4 + 4*ndim + a->GetDataSize();
+    if ((int)_mem.size() + size > _max_memory) {
+      return Fail("memory budget exceeded");
+    }
+
+    int addr = MemBase + (int)_mem.size();
+    _mem.resize(_mem.size() + size, 0);
+    Store(addr, 4, ndim);
+    for (int d=1; d<=ndim; d++) {
+      Store(addr + 4*d, 4, a->GetNElem());
+      a = dynamic_cast<const CArrayType*>(a->GetInnerType());
+    }
+    f[k] = addr;
+  }
+
+  vector<int> arg;
+  size_t pc = 0;
+
+  while (pc < code.size()) {
+    const SInstr &si = code[pc++];
+    CTacInstr *i = si.instr;
+    EOperation op = i->GetOperation();
+    int a = 0, b = 0, v = 0;
+
+    if (++_steps > _max_steps) return Fail("step budget exceeded");
+
+    switch (op) {
+      case opAdd:
+      case opSub:
+      case opMul:
+      case opDiv:
+      case opMod:
+      case opAnd:
+      case opOr:
+        if (!Read(f, si.src1, a) || !Read(f, si.src2, b)) return false;
+        // 32-bit two's complement arithmetic as on the target
+        switch (op) {
+          case opAdd: v = (int)((unsigned int)a + (unsigned int)b); break;
+          case opSub: v = (int)((unsigned int)a - (unsigned int)b); break;
+          case opMul: v = (int)((unsigned int)a * (unsigned int)b); break;
+          case opDiv:
+            if ((b == 0) || ((a == INT_MIN) && (b == -1))) {
+              return Fail("division overflow");
+            }
+            v = a / b;
+            break;
+          case opMod:
+            if ((b == 0) || ((a == INT_MIN) && (b == -1))) {
+              return Fail("division overflow");
+            }
+            v = a % b;
+            break;
+          case opAnd: v = a && b; break;
+          default:    v = a || b; break;
+        }
+        if (!Write(f, si.dst, v)) return false;
+        break;
+
+      case opNeg:
+      case opPos:
+      case opNot:
+      case opAssign:
+        if (!Read(f, si.src1, a)) return false;
+        if (op == opNeg) v = (int)(0u - (unsigned int)a);
+        else if (op == opNot) v = !a;
+        else v = a;
+        if (!Write(f, si.dst, v)) return false;
+        break;
+
+      case opAddress:
+        if (si.src1.kind != oSlot) return Fail("address of non-local data");
+        if (!Write(f, si.dst, f[si.src1.value])) return false;
+        break;
+
+      case opGoto:
+        pc = si.target;
+        break;
+
+      case opEqual:
+      case opNotEqual:
+      case opLessThan:
+      case opLessEqual:
+      case opBiggerThan:
+      case opBiggerEqual: {
+        if (!Read(f, si.src1, a) || !Read(f, si.src2, b)) return false;
+        bool taken;
+        switch (op) {
+          case opEqual:       taken = a == b; break;
+          case opNotEqual:    taken = a != b; break;
+          case opLessThan:    taken = a <  b; break;
+          case opLessEqual:   taken = a <= b; break;
+          case opBiggerThan:  taken = a >  b; break;
+          default:            taken = a >= b; break;
+        }
+        if (taken) pc = si.target;
+        break;
+      }
+
+      case opSwitch: {
+        if (!Read(f, si.src1, a)) return false;
+        CTacLabel *target = dynamic_cast<CTacSwitch*>(i)->GetTarget(a);
+        if (target != NULL) pc = c.label.find(target)->second;
+        break;
+      }
+
+      case opParam:
+        assert(si.dst.kind == oConst);
+        if (!Read(f, si.src1, v)) return false;
+        if ((int)arg.size() <= si.dst.value) arg.resize(si.dst.value+1);
+        arg[si.dst.value] = v;
+        break;
+
+      case opCall: {
+        const CTacName *n = dynamic_cast<const CTacName*>(i->GetSrc(1));
+        const CSymbol *callee = n->GetSymbol();
+        CScope *cs = _cg->GetScope(callee);
+
+        if ((cs == NULL) && (callee->GetName() == "DIM") && (arg.size() == 2)) {
+          if (!Load(arg[0] + 4*arg[1], 4, v)) return false;
+        } else if ((cs == NULL) && (callee->GetName() == "DOFS") &&
+                   (arg.size() == 1)) {
+          if (!Load(arg[0], 4, v)) return false;
+          v = 4 + 4*v;
+        } else if (cs != NULL) {
+          if (!Execute(cs, arg, v, depth+1)) return false;
+        } else {
+          return Fail("call to '" + callee->GetName() + "'");
+        }
+        arg.clear();
+
+        if ((si.dst.kind != oNone) && !Write(f, si.dst, v)) return false;
+        break;
+      }
+
+      case opReturn:
+        result = 0;
+        if ((si.src1.kind != oNone) && !Read(f, si.src1, result)) return false;
+        _mem.resize(mem);
+        return true;
+
+      case opLabel:
+      case opNop:
+        break;
+
+      default:
+        return Fail("unsupported operation");
+    }
+  }
+
+  return Fail("no return value");
+}
+
+bool CTacInterpreter::Read(const vector<int> &f, const SOperand &op, int &v)
+{
+  switch (op.kind) {
+    case oConst: v = op.value; return true;
+    case oSlot:  v = f[op.value]; return true;
+    case oRef:   return Load(f[op.value], op.size, v);
+    default:     return Fail("access to non-local data");
+  }
+}
+
+bool CTacInterpreter::Write(vector<int> &f, const SOperand &op, int v)
+{
+  switch (op.kind) {
+    case oSlot:
+      // sub-word variables are stored with movb/movw and loaded zero-extended
+      if (op.size == 1) v &= 0xff;
+      else if (op.size == 2) v &= 0xffff;
+      f[op.value] = v;
+      return true;
+    case oRef:
+      return Store(f[op.value], op.size, v);
+    default:
+      return Fail("access to non-local data");
+  }
+}
+
+bool CTacInterpreter::Load(int addr, int size, int &v)
+{
+  int ofs = addr - MemBase;
+  if ((ofs < 0) || (ofs + size > (int)_mem.size())) {
+    return Fail("access out of bounds");
+  }
+
+  unsigned int u = 0;
+  for (int b=size-1; b>=0; b--) u = (u << 8) | _mem[ofs + b];
+  v = (int)u;
+
+  return true;
+}
+
+bool CTacInterpreter::Store(int addr, int size, int v)
+{
+  int ofs = addr - MemBase;
+  if ((ofs < 0) || (ofs + size > (int)_mem.size())) {
+    return Fail("access out of bounds");
+  }
+
+  unsigned int u = (unsigned int)v;
+  for (int b=0; b<size; b++) {
+    _mem[ofs + b] = u & 0xff;
+    u >>= 8;
+  }
+
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// CCallFolding
+//
+CCallFolding::CCallFolding(const CCallGraph *cg)
+  : _cg(cg), _interp(cg, MaxCallSteps), _steps(0)
+{
+  assert(cg != NULL);
+}
+
+int CCallFolding::Run(void)
+{
+  int n = 0;
+
+  for (const auto &s : _cg->GetScopes()) n += Fold(s);
+
+  return n;
+}
+
+int CCallFolding::Fold(CScope *scope)
+{
+  CCodeBlock *cb = scope->GetCodeBlock();
+  if (cb == NULL) return 0;
+
+  CRemarks *rm = CRemarks::Get();
+  int n = 0;
+
+  vector<CTacInstr*> code(cb->GetInstr().begin(), cb->GetInstr().end());
+
+  for (size_t pc=0; pc<code.size(); pc++) {
+    CTacInstr *call = code[pc];
+    if ((call->GetOperation() != opCall) || (call->GetDest() == NULL)) continue;
+
+    const CTacName *fn = dynamic_cast<const CTacName*>(call->GetSrc(1));
+    const CSymProc *proc = dynamic_cast<const CSymProc*>(fn->GetSymbol());
+    CScope *callee = _cg->GetScope(proc);
+    if ((callee == NULL) || !proc->IsPure()) continue;
+
+    // the arguments are passed by the instructions right before the call:
+    // param n-1, ..., param 0. They must all be constants.
+    int np = proc->GetNParams();
+    if ((int)pc < np) continue;
+
+    vector<int> args(np);
+    bool constant = true;
+    for (int p=0; p<np; p++) {
+      CTacInstr *param = code[pc - 1 - p];
+      const CTacConst *idx = dynamic_cast<const CTacConst*>(param->GetDest());
+      const CTacConst *val = dynamic_cast<const CTacConst*>(param->GetSrc(1));
+
+      if ((param->GetOperation() != opParam) || (idx->GetValue() != p) ||
+          (val == NULL)) {
+        constant = false;
+        break;
+      }
+      args[p] = val->GetValue();
+    }
+    if (!constant) continue;
+
+    ostringstream o;
+    o << proc->GetName() << "(";
+    for (int p=0; p<np; p++) o << (p > 0 ? ", " : "") << args[p];
+    o << ")";
+
+    int line = call->GetLineNumber();
+    const SResult &r = Evaluate(callee, args);
+    if (!r.ok) {
+      rm->Add(rkMissed, "fold", scope->GetDisplayName(), line,
+              "call " + o.str() + " not evaluated at compile time: " + r.error);
+      continue;
+    }
+
+    for (int p=0; p<np; p++) cb->RemoveInstr(code[pc - 1 - p]);
+    cb->ReplaceInstr(call,
+      new CTacInstr(opAssign, call->GetDest(), new CTacConst(r.value), NULL));
+    n++;
+
+    o << " = " << r.value << " evaluated at compile time ("
+      << r.steps << " instruction(s))";
+    rm->Add(rkPassed, "fold", scope->GetDisplayName(), line, "call " + o.str());
+  }
+
+  // the prepared code of this scope is stale
+  if (n > 0) _interp.Invalidate(scope);
+
+  return n;
+}
+
+const CCallFolding::SResult& CCallFolding::Evaluate(CScope *callee,
+                                                    const vector<int> &args)
+{
+  pair<CScope*, vector<int> > key(callee, args);
+  map<pair<CScope*, vector<int> >, SResult>::iterator it = _results.find(key);
+  if (it != _results.end()) return it->second;
+
+  SResult &r = _results[key];
+  r.value = 0;
+
+  if (_steps >= MaxModuleSteps) {
+    r.ok = false;
+    r.steps = 0;
+    r.error = "step budget of the module exhausted";
+    return r;
+  }
+
+  int budget = MaxModuleSteps - _steps;
+  _interp.SetMaxSteps(budget < MaxCallSteps ? budget : (int)MaxCallSteps);
+  r.ok = _interp.Call(callee, args, r.value);
+  r.steps = _interp.GetSteps();
+  r.error = _interp.GetError();
+  _steps += r.steps;
+
+  return r;
+}
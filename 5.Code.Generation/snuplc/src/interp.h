@@ -0,0 +1,186 @@
+//------------------------------------------------------------------------------
+/// @brief SnuPL TAC interpreter and compile-time evaluation
+//------------------------------------------------------------------------------
+
+#ifndef __SnuPL_INTERP_H__
+#define __SnuPL_INTERP_H__
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ir.h"
+#include "ipa.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+/// @brief TAC interpreter
+///
+/// executes the TAC of pure procedures (see CSymProc::IsPure()) on integer
+/// arguments. Local arrays are allocated in a private memory with the same
+/// layout as on the target (array header followed by the data); DIM and DOFS
+/// are evaluated natively. Execution fails if a step or memory budget is
+/// exhausted, on division by zero, or if the code accesses anything that is
+/// not local to the procedure (globals, I/O, impure callees).
+///
+class CTacInterpreter {
+  public:
+    /// @name constructor/destructor
+    /// @{
+
+    /// @brief constructor
+    /// @param cg call graph (to find the scopes of callees)
+    /// @param max_steps maximum number of executed instructions per call
+    /// @param max_memory maximum number of bytes for local arrays
+    CTacInterpreter(const CCallGraph *cg, int max_steps=1000000,
+                    int max_memory=65536);
+
+    /// @}
+
+    /// @brief execute @a scope with arguments @a args
+    /// @param scope procedure scope
+    /// @param args argument values
+    /// @param result return value
+    /// @retval true on success, false otherwise (see GetError())
+    bool Call(CScope *scope, const vector<int> &args, int &result);
+
+    /// @brief return the reason why the last call failed
+    const string& GetError(void) const;
+
+    /// @brief return the number of instructions executed by the last call
+    int GetSteps(void) const;
+
+    /// @brief set the maximum number of executed instructions per call
+    void SetMaxSteps(int max_steps);
+
+    /// @brief discard the prepared code of @a scope; must be called when the
+    ///        code of @a scope is modified after it has been executed
+    void Invalidate(CScope *scope);
+
+  private:
+    /// @brief kind of a prepared operand
+    enum EOperand {
+      oNone,                                    ///< no operand
+      oConst,                                   ///< constant
+      oSlot,                                    ///< variable in a frame slot
+      oRef,                                     ///< array element
+      oNonLocal,                                ///< not local to the scope
+    };
+
+    /// @brief operand with its symbol resolved to a frame slot
+    struct SOperand {
+      EOperand kind;                            ///< kind
+      int value;                                ///< constant or frame slot
+      int size;                                 ///< size of the accessed data
+    };
+
+    /// @brief instruction with resolved operands and branch target
+    struct SInstr {
+      CTacInstr *instr;                         ///< instruction
+      SOperand dst, src1, src2;                 ///< operands
+      size_t target;                            ///< pc of the branch target
+    };
+
+    /// @brief initialization of a frame slot
+    struct SSlot {
+      int param;                                ///< argument index or -1
+      const CArrayType *array;                  ///< type of a local array
+    };
+
+    /// @brief code of a scope prepared for execution
+    struct SCode {
+      vector<SInstr> instr;                     ///< instructions
+      vector<SSlot> slot;                       ///< frame layout
+      map<const CTac*, size_t> label;           ///< pc of labels
+    };
+
+    /// @brief return the prepared code of @a scope
+    const SCode& Code(CScope *scope);
+
+    /// @brief resolve operand @a op given the frame slots @a slot
+    SOperand Operand(const CTac *op, const map<const CSymbol*, int> &slot) const;
+
+    /// @brief execute @a scope in a new frame
+    bool Execute(CScope *scope, const vector<int> &args, int &result,
+                 int depth);
+
+    /// @brief return the value of operand @a op in frame @a f
+    bool Read(const vector<int> &f, const SOperand &op, int &v);
+
+    /// @brief store @a v to operand @a op in frame @a f
+    bool Write(vector<int> &f, const SOperand &op, int v);
+
+    /// @brief load/store @a size bytes at address @a addr
+    bool Load(int addr, int size, int &v);
+    bool Store(int addr, int size, int v);
+
+    /// @brief return false and set the error message to @a msg
+    bool Fail(string msg);
+
+    const CCallGraph *_cg;                      ///< call graph
+    int _max_steps;                             ///< step budget
+    int _max_memory;                            ///< memory budget
+    int _steps;                                 ///< executed instructions
+    string _error;                              ///< error message
+    vector<unsigned char> _mem;                 ///< memory of local arrays
+    map<CScope*, SCode> _code;                  ///< prepared code
+};
+
+
+//------------------------------------------------------------------------------
+/// @brief compile-time evaluation of calls
+///
+/// replaces calls to pure functions whose arguments are all constant by the
+/// result computed by the TAC interpreter:
+///
+///   param 1 <- 16
+///   param 0 <- 2                  =>  assign t0 <- 65536
+///   call t0 <- Pow
+///
+/// Each (callee, arguments) pair is evaluated at most once; results and
+/// failures are reused for all call sites. The instructions executed for the
+/// whole module are limited by MaxModuleSteps.
+///
+class CCallFolding {
+  public:
+    /// @name constructor/destructor
+    /// @{
+
+    /// @brief constructor
+    /// @param cg call graph; side effects must have been computed
+    CCallFolding(const CCallGraph *cg);
+
+    /// @}
+
+    /// @brief replace all foldable calls
+    /// @retval int number of replaced calls
+    int Run(void);
+
+  private:
+    /// @brief outcome of the evaluation of a call
+    struct SResult {
+      bool ok;                                  ///< evaluated successfully
+      int value;                                ///< result
+      int steps;                                ///< executed instructions
+      string error;                             ///< reason of a failure
+    };
+
+    /// @brief fold the calls in @a scope
+    int Fold(CScope *scope);
+
+    /// @brief evaluate @a callee with arguments @a args (memoized)
+    const SResult& Evaluate(CScope *callee, const vector<int> &args);
+
+    const CCallGraph *_cg;                      ///< call graph
+    CTacInterpreter _interp;                    ///< interpreter
+    int _steps;                                 ///< executed instructions
+    map<pair<CScope*, vector<int> >, SResult> _results; ///< evaluated calls
+
+    static const int MaxCallSteps = 1000000;    ///< step budget per call
+    static const int MaxModuleSteps = 4000000;  ///< step budget per module
+};
+
+
+#endif // __SnuPL_INTERP_H__
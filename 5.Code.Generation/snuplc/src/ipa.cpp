@@ -0,0 +1,634 @@
+//------------------------------------------------------------------------------
+/// @brief SnuPL interprocedural analysis
+//------------------------------------------------------------------------------
+
+#include <cassert>
+#include <sstream>
+
+#include "ipa.h"
+#include "remarks.h"
+using namespace std;
+
+
+//------------------------------------------------------------------------------
+// CCallGraph
+//
+CCallGraph::CCallGraph(CModule *m)
+  : _m(m)
+{
+  assert(m != NULL);
+
+  AddScope(m);
+
+  // collect the direct calls of every scope
+  for (const auto &s : _scope) {
+    _callees[s.second];
+    _callers[s.second];
+  }
+  _callees[m];
+  _callers[m];
+
+  for (auto &e : _callees) {
+    CScope *caller = e.first;
+    CCodeBlock *cb = caller->GetCodeBlock();
+    if (cb == NULL) continue;
+
+    for (const auto &i : cb->GetInstr()) {
+      if (i->GetOperation() != opCall) continue;
+
+      const CTacName *n = dynamic_cast<const CTacName*>(i->GetSrc(1));
+      assert(n != NULL);
+      CScope *callee = GetScope(n->GetSymbol());
+      if (callee == NULL) continue;
+
+      e.second.insert(callee);
+      _callers[callee].insert(caller);
+    }
+  }
+
+  // postorder: first everything reachable from the module body, then the
+  // procedures that are never called
+  set<CScope*> visited;
+  PostOrder(m, visited);
+  _reachable = visited;
+
+  for (const auto &s : _scope) {
+    if (visited.find(s.second) == visited.end()) PostOrder(s.second, visited);
+  }
+}
+
+void CCallGraph::AddScope(CScope *scope)
+{
+  CSymbol *decl = scope->GetDeclaration();
+  if (decl != NULL) _scope[decl] = scope;
+
+  for (const auto &s : scope->GetSubscopes()) AddScope(s);
+}
+
+void CCallGraph::PostOrder(CScope *scope, set<CScope*> &visited)
+{
+  visited.insert(scope);
+  for (const auto &c : GetCallees(scope)) {
+    if (visited.find(c) == visited.end()) PostOrder(c, visited);
+  }
+  _scopes.push_back(scope);
+}
+
+CModule* CCallGraph::GetModule(void) const
+{
+  return _m;
+}
+
+const vector<CScope*>& CCallGraph::GetScopes(void) const
+{
+  return _scopes;
+}
+
+CScope* CCallGraph::GetScope(const CSymbol *proc) const
+{
+  map<const CSymbol*, CScope*>::const_iterator it = _scope.find(proc);
+  return it != _scope.end() ? it->second : NULL;
+}
+
+const set<CScope*>& CCallGraph::GetCallees(CScope *scope) const
+{
+  map<CScope*, set<CScope*> >::const_iterator it = _callees.find(scope);
+  assert(it != _callees.end());
+  return it->second;
+}
+
+const set<CScope*>& CCallGraph::GetCallers(CScope *scope) const
+{
+  map<CScope*, set<CScope*> >::const_iterator it = _callers.find(scope);
+  assert(it != _callers.end());
+  return it->second;
+}
+
+bool CCallGraph::IsReachable(CScope *scope) const
+{
+  return _reachable.find(scope) != _reachable.end();
+}
+
+bool CCallGraph::IsRecursive(CScope *scope) const
+{
+  // depth-first search for a path from the callees back to the scope
+  set<CScope*> visited;
+  vector<CScope*> work(GetCallees(scope).begin(), GetCallees(scope).end());
+
+  while (work.size() > 0) {
+    CScope *s = work.back();
+    work.pop_back();
+
+    if (s == scope) return true;
+    if (!visited.insert(s).second) continue;
+
+    const set<CScope*> &c = GetCallees(s);
+    work.insert(work.end(), c.begin(), c.end());
+  }
+
+  return false;
+}
+
+ostream& CCallGraph::print(ostream &out, int indent) const
+{
+  string ind(indent, ' ');
+
+  out << ind << "call graph of '" << _m->GetName() << "':" << endl;
+  for (const auto &s : _scopes) {
+    out << ind << "  " << s->GetName() << " ->";
+    if (GetCallees(s).size() == 0) out << " (none)";
+    for (const auto &c : GetCallees(s)) out << " " << c->GetName();
+    if (!IsReachable(s)) out << "  [unreachable]";
+    out << endl;
+  }
+
+  return out;
+}
+
+
+//------------------------------------------------------------------------------
+// CModRefAnalysis
+//
+bool CModRefAnalysis::SSummary::operator!=(const SSummary &s) const
+{
+  return (effects != s.effects) || (ref != s.ref) || (mod != s.mod) ||
+         (pref != s.pref) || (pmod != s.pmod);
+}
+
+CModRefAnalysis::CModRefAnalysis(const CCallGraph *cg)
+  : _cg(cg)
+{
+  assert(cg != NULL);
+}
+
+void CModRefAnalysis::Run(void)
+{
+  const vector<CScope*> &scopes = _cg->GetScopes();
+
+  // summaries only grow; start from "no effects" and iterate until the
+  // summaries of recursive procedures are stable. Scopes are visited in
+  // postorder, so a scope only needs to be summarized again if the summary
+  // of one of its callees changed after it was computed.
+  _summary.clear();
+  set<CScope*> dirty(scopes.begin(), scopes.end());
+  while (!dirty.empty()) {
+    for (const auto &s : scopes) {
+      if (dirty.erase(s) == 0) continue;
+
+      SSummary sum = Summarize(s);
+      SSummary &old = _summary[s];
+      if (sum != old) {
+        old = sum;
+        const set<CScope*> &callers = _cg->GetCallers(s);
+        dirty.insert(callers.begin(), callers.end());
+      }
+    }
+  }
+
+  for (const auto &s : scopes) {
+    CSymProc *proc = dynamic_cast<CSymProc*>(s->GetDeclaration());
+    if (proc == NULL) continue;
+
+    const SSummary &sum = _summary[s];
+    if (sum.effects != seAll) {
+      proc->SetSideEffects(sum.effects, sum.ref, sum.mod, sum.pref, sum.pmod);
+    }
+    Remark(s, sum);
+  }
+}
+
+CModRefAnalysis::SSummary CModRefAnalysis::Summarize(CScope *scope) const
+{
+  SSummary s;
+  CCodeBlock *cb = scope->GetCodeBlock();
+  if (cb == NULL) return s;
+
+  map<const CSymbol*, const CSymbol*> addr;   // temporary -> array
+  map<int, const CSymbol*> arg;                // argument -> array
+
+  for (const auto &i : cb->GetInstr()) {
+    EOperation op = i->GetOperation();
+
+    if (op == opAddress) {
+      // taking the address of an array is not an access
+      const CTacName *d = dynamic_cast<const CTacName*>(i->GetDest());
+      const CTacName *n = dynamic_cast<const CTacName*>(i->GetSrc(1));
+      if ((d != NULL) && (n != NULL)) addr[d->GetSymbol()] = n->GetSymbol();
+      continue;
+    }
+
+    if (op == opParam) {
+      // remember what array an argument refers to: either an address
+      // computed by &() or an array parameter passed on
+      const CTacConst *idx = dynamic_cast<const CTacConst*>(i->GetDest());
+      const CTacName *n = dynamic_cast<const CTacName*>(i->GetSrc(1));
+      if ((idx != NULL) && (n != NULL)) {
+        map<const CSymbol*, const CSymbol*>::const_iterator a =
+          addr.find(n->GetSymbol());
+        if (a != addr.end()) arg[idx->GetValue()] = a->second;
+        else if (n->GetSymbol()->GetSymbolType() == stParam)
+          arg[idx->GetValue()] = n->GetSymbol();
+      }
+    }
+
+    if (op == opCall) {
+      const CTacName *n = dynamic_cast<const CTacName*>(i->GetSrc(1));
+      const CSymProc *proc = dynamic_cast<const CSymProc*>(n->GetSymbol());
+      assert(proc != NULL);
+
+      // effects of the callee: from its summary if it is part of the module,
+      // otherwise (predefined procedures) from the symbol
+      SSummary predef;
+      const SSummary *cs = &predef;
+      CScope *callee = _cg->GetScope(proc);
+      if (callee != NULL) {
+        map<CScope*, SSummary>::const_iterator it = _summary.find(callee);
+        if (it != _summary.end()) cs = &it->second;
+      } else {
+        predef.effects = proc->GetSideEffects();
+        predef.ref = proc->GetGlobalRefs();
+        predef.mod = proc->GetGlobalMods();
+        for (int p=0; p<proc->GetNParams(); p++) {
+          if (proc->ReadsParam(p)) predef.pref.insert(p);
+          if (proc->WritesParam(p)) predef.pmod.insert(p);
+        }
+      }
+      const SSummary &c = *cs;
+
+      if (c.effects == seAll) s.effects = seAll;
+      s.effects |= c.effects & seIO;
+      for (const auto &g : c.ref) Access(s, g, false);
+      for (const auto &g : c.mod) Access(s, g, true);
+
+      // map array parameter effects of the callee to the arguments
+      for (int p=0; p<2; p++) {
+        const set<int> &params = p == 0 ? c.pref : c.pmod;
+        for (const auto &idx : params) {
+          map<int, const CSymbol*>::const_iterator a = arg.find(idx);
+          if (a != arg.end()) Access(s, a->second, p == 1);
+          else s.effects = seAll;
+        }
+      }
+
+      arg.clear();
+
+      const CTacName *d = dynamic_cast<const CTacName*>(i->GetDest());
+      if (d != NULL) Access(s, d->GetSymbol(), true);
+      continue;
+    }
+
+    // ordinary instructions: operands and destination
+    for (int o=1; o<=(int)i->GetNumSrc(); o++) {
+      const CTacName *n = dynamic_cast<const CTacName*>(i->GetSrc(o));
+      if (n == NULL) continue;
+
+      const CTacReference *r = dynamic_cast<const CTacReference*>(n);
+      if (r != NULL) Access(s, r->GetDerefSymbol(), false);
+      else if (n->GetSymbol()->GetSymbolType() == stGlobal)
+        Access(s, n->GetSymbol(), false);
+    }
+
+    const CTacName *d = dynamic_cast<const CTacName*>(i->GetDest());
+    if (d != NULL) {
+      const CTacReference *r = dynamic_cast<const CTacReference*>(d);
+      Access(s, r != NULL ? r->GetDerefSymbol() : d->GetSymbol(), true);
+    }
+  }
+
+  return s;
+}
+
+void CModRefAnalysis::Access(SSummary &s, const CSymbol *sym, bool write) const
+{
+  switch (sym->GetSymbolType()) {
+    case stGlobal:
+      // string constants are initialized data and never change
+      if (!write && (sym->GetData() != NULL)) break;
+      if (write) { s.effects |= seWriteGlobal; s.mod.insert(sym); }
+      else       { s.effects |= seReadGlobal;  s.ref.insert(sym); }
+      break;
+
+    case stParam:
+      // scalar parameters are passed by value; only accesses through array
+      // parameters are visible to the caller
+      if (!sym->GetDataType()->IsPointer()) break;
+      {
+        int idx = dynamic_cast<const CSymParam*>(sym)->GetIndex();
+        if (write) { s.effects |= seWriteParam; s.pmod.insert(idx); }
+        else       { s.effects |= seReadParam;  s.pref.insert(idx); }
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+
+void CModRefAnalysis::Remark(CScope *scope, const SSummary &s) const
+{
+  CRemarks *rm = CRemarks::Get();
+  if (!rm->IsEnabled(rkAnalysis)) return;
+
+  ostringstream o;
+
+  if (s.effects == seAll) {
+    o << "unknown side effects";
+  } else if (s.effects == seNone) {
+    o << "pure";
+  } else {
+    const char *sep = "";
+
+    if (s.ref.size() > 0) {
+      o << sep << "reads global" << (s.ref.size() > 1 ? "s" : "");
+      for (const auto &g : s.ref) o << " " << g->GetName();
+      sep = "; ";
+    }
+    if (s.mod.size() > 0) {
+      o << sep << "writes global" << (s.mod.size() > 1 ? "s" : "");
+      for (const auto &g : s.mod) o << " " << g->GetName();
+      sep = "; ";
+    }
+    if (s.pref.size() > 0) {
+      o << sep << "reads array parameter" << (s.pref.size() > 1 ? "s" : "");
+      for (const auto &p : s.pref) o << " " << p;
+      sep = "; ";
+    }
+    if (s.pmod.size() > 0) {
+      o << sep << "writes array parameter" << (s.pmod.size() > 1 ? "s" : "");
+      for (const auto &p : s.pmod) o << " " << p;
+      sep = "; ";
+    }
+    if (s.effects & seIO) o << sep << "performs I/O";
+  }
+
+  rm->Add(rkAnalysis, "ipa", scope->GetDisplayName(), scope->GetLineNumber(),
+          o.str());
+}
+
+
+//------------------------------------------------------------------------------
+// CGlobalAnalysis
+//
+// loading a global at the entry of a procedure costs one load; globals read
+// less than MinReads times are not loaded
+//
+static const int MinReads = 2;
+
+/// @brief returns true if the relation @a op holds for @a a and @a b
+static bool Holds(EOperation op, int a, int b)
+{
+  switch (op) {
+    case opEqual:       return a == b;
+    case opNotEqual:    return a != b;
+    case opLessThan:    return a <  b;
+    case opLessEqual:   return a <= b;
+    case opBiggerThan:  return a >  b;
+    case opBiggerEqual: return a >= b;
+    default:            assert(false); return false;
+  }
+}
+
+CGlobalAnalysis::CGlobalAnalysis(const CCallGraph *cg)
+  : _cg(cg)
+{
+  assert(cg != NULL);
+}
+
+int CGlobalAnalysis::Run(void)
+{
+  Classify();
+
+  int n = _value.size();
+  for (const auto &s : _cg->GetScopes()) {
+    Fold(s);
+    n += Cache(s);
+  }
+
+  return n;
+}
+
+void CGlobalAnalysis::Classify(void)
+{
+  CRemarks *rm = CRemarks::Get();
+  CModule *m = _cg->GetModule();
+
+  // scalar globals; initialized data (strings) is never scalar
+  set<const CSymbol*> globals;
+  for (const auto &s : m->GetSymbolTable()->GetSymbols()) {
+    if ((s->GetSymbolType() == stGlobal) && s->GetDataType()->IsScalar() &&
+        (s->GetData() == NULL)) globals.insert(s);
+  }
+
+  // writes in all scopes; globals whose address is taken may be written
+  // through the address
+  map<const CSymbol*, vector<const CTacInstr*> > writes;
+  set<const CSymbol*> escaped;
+
+  for (const auto &scope : _cg->GetScopes()) {
+    for (const auto &i : scope->GetCodeBlock()->GetInstr()) {
+      for (int o=1; o<=(int)i->GetNumSrc(); o++) {
+        const CTacName *n = dynamic_cast<const CTacName*>(i->GetSrc(o));
+        if (n == NULL) continue;
+
+        const CTacReference *r = dynamic_cast<const CTacReference*>(n);
+        if (r != NULL) escaped.insert(r->GetDerefSymbol());
+        else if (i->GetOperation() == opAddress) escaped.insert(n->GetSymbol());
+      }
+
+      const CTacName *d = dynamic_cast<const CTacName*>(i->GetDest());
+      if (d == NULL) continue;
+
+      const CTacReference *r = dynamic_cast<const CTacReference*>(d);
+      if (r != NULL) escaped.insert(r->GetDerefSymbol());
+      else if (globals.count(d->GetSymbol()) > 0)
+        writes[d->GetSymbol()].push_back(i);
+    }
+  }
+
+  // the straight-line code at the start of the module body runs exactly once
+  // and before all procedures of the module. Calls to runtime procedures do
+  // not access globals.
+  set<const CTacInstr*> prologue;
+  for (const auto &i : m->GetCodeBlock()->GetInstr()) {
+    EOperation op = i->GetOperation();
+    if ((op == opLabel) || (op == opReturn) || (op == opSwitch) ||
+        i->IsBranch()) break;
+    if (op == opCall) {
+      const CTacName *n = dynamic_cast<const CTacName*>(i->GetSrc(1));
+      const CSymProc *proc = dynamic_cast<const CSymProc*>(n->GetSymbol());
+      if (_cg->GetScope(proc) != NULL) break;
+    }
+    prologue.insert(i);
+  }
+
+  for (const auto &g : globals) {
+    if (escaped.count(g) > 0) continue;
+
+    const vector<const CTacInstr*> &w = writes[g];
+    ostringstream msg;
+
+    if (w.size() == 0) {
+      _value[g] = 0;
+      msg << "global '" << g->GetName() << "' is never written; reads "
+          << "are replaced by 0";
+    } else if ((w.size() == 1) && (w[0]->GetOperation() == opAssign) &&
+               (prologue.count(w[0]) > 0) &&
+               (dynamic_cast<const CTacConst*>(w[0]->GetSrc(1)) != NULL)) {
+      int value = dynamic_cast<const CTacConst*>(w[0]->GetSrc(1))->GetValue();
+      _value[g] = value;
+      _init[g] = w[0];
+      msg << "global '" << g->GetName() << "' is written once with "
+          << value << " before any call; subsequent reads are replaced by "
+          << value;
+    } else {
+      continue;
+    }
+
+    rm->Add(rkAnalysis, "globals", m->GetName(), m->GetLineNumber(),
+            msg.str());
+  }
+}
+
+int CGlobalAnalysis::Fold(CScope *scope)
+{
+  if (_value.size() == 0) return 0;
+
+  CCodeBlock *cb = scope->GetCodeBlock();
+
+  // in the module body, globals written once still hold their initial value
+  // before the assignment. Procedures use the constant values directly; the
+  // map is only copied for the module body.
+  bool body = scope == _cg->GetModule();
+  map<const CSymbol*, int> body_values;
+  map<const CTacInstr*, const CSymbol*> assigns;
+  if (body) {
+    body_values = _value;
+    for (const auto &p : _init) {
+      body_values[p.first] = 0;
+      assigns[p.second] = p.first;
+    }
+  }
+  const map<const CSymbol*, int> &values = body ? body_values : _value;
+
+  list<CTacInstr*> code = cb->GetInstr();
+  int n = 0, branches = 0;
+
+  for (const auto &i : code) {
+    if (i->GetOperation() == opLabel) continue;
+
+    const CTacSelect *sel = dynamic_cast<const CTacSelect*>(i);
+    const CTac *ops[] = { i->GetSrc(1), i->GetSrc(2),
+                          sel != NULL ? sel->GetLeft() : NULL,
+                          sel != NULL ? sel->GetRight() : NULL };
+
+    bool fold = false;
+    for (const auto &o : ops) {
+      const CTacName *n = dynamic_cast<const CTacName*>(o);
+      if ((n != NULL) && (dynamic_cast<const CTacReference*>(n) == NULL) &&
+          (values.count(n->GetSymbol()) > 0)) fold = true;
+    }
+
+    if (fold) {
+      CTacInstr *f = cb->ReplaceInstr(i, CCodeBlock::FoldInstr(i, values));
+      n++;
+
+      // conditional branches on constants are always or never taken
+      const CTacConst *a = dynamic_cast<const CTacConst*>(f->GetSrc(1));
+      const CTacConst *b = dynamic_cast<const CTacConst*>(f->GetSrc(2));
+      if (IsRelOp(f->GetOperation()) && (a != NULL) && (b != NULL)) {
+        if (Holds(f->GetOperation(), a->GetValue(), b->GetValue())) {
+          cb->ReplaceInstr(f, new CTacInstr(opGoto, f->GetDest()));
+        } else {
+          cb->RemoveInstr(f);
+        }
+        branches++;
+      } else if ((f->GetOperation() == opSwitch) && (a != NULL)) {
+        CTacLabel *target = dynamic_cast<CTacSwitch*>(f)->GetTarget(a->GetValue());
+        if (target != NULL) cb->ReplaceInstr(f, new CTacInstr(opGoto, target));
+        else cb->RemoveInstr(f);
+        branches++;
+      }
+    } else if (body) {
+      map<const CTacInstr*, const CSymbol*>::const_iterator a = assigns.find(i);
+      if (a != assigns.end()) body_values[a->second] = _value[a->second];
+    }
+  }
+
+  if (branches > 0) cb->CleanupControlFlow();
+
+  if (n > 0) {
+    ostringstream msg;
+    msg << n << " read(s) of constant globals replaced by their value";
+    if (branches > 0) msg << ", " << branches << " branch(es) resolved";
+    CRemarks::Get()->Add(rkPassed, "globals", scope->GetDisplayName(),
+                         scope->GetLineNumber(), msg.str());
+  }
+
+  return n;
+}
+
+int CGlobalAnalysis::Cache(CScope *scope)
+{
+  const CSymProc *proc = dynamic_cast<const CSymProc*>(scope->GetDeclaration());
+  if (proc == NULL) return 0;
+
+  CCodeBlock *cb = scope->GetCodeBlock();
+
+  // reads of integer globals that neither the procedure nor its callees write
+  vector<const CSymbol*> globals;
+  map<const CSymbol*, int> count;
+  map<const CSymbol*, set<CTacInstr*> > users;
+
+  for (const auto &i : cb->GetInstr()) {
+    const CTacSelect *sel = dynamic_cast<const CTacSelect*>(i);
+    const CTac *ops[] = { i->GetSrc(1), i->GetSrc(2),
+                          sel != NULL ? sel->GetLeft() : NULL,
+                          sel != NULL ? sel->GetRight() : NULL };
+
+    for (const auto &o : ops) {
+      const CTacName *n = dynamic_cast<const CTacName*>(o);
+      if ((n == NULL) || (dynamic_cast<const CTacReference*>(n) != NULL))
+        continue;
+
+      const CSymbol *s = n->GetSymbol();
+      if ((s->GetSymbolType() != stGlobal) || !s->GetDataType()->IsInt() ||
+          proc->WritesGlobal(s)) continue;
+
+      if (count[s]++ == 0) globals.push_back(s);
+      users[s].insert(i);
+    }
+  }
+
+  const CSymbol *best = NULL;
+  for (const auto &g : globals) {
+    if ((count[g] >= MinReads) && ((best == NULL) || (count[g] > count[best])))
+      best = g;
+  }
+  if (best == NULL) return 0;
+
+  // load the global at the entry and rename its reads
+  CTacTemp *t = scope->CreateTemp(best->GetDataType());
+  const CSymbol *ts = t->GetSymbol();
+  map<const CSymbol*, const CSymbol*> rename;
+  rename[best] = ts;
+
+  list<CTacInstr*> code;
+  code.push_back(new CTacInstr(opAssign, t, new CTacName(best)));
+  for (const auto &i : cb->GetInstr()) {
+    if (users[best].count(i) > 0) code.push_back(CCodeBlock::CopyInstr(i, rename));
+    else code.push_back(i);
+  }
+  for (const auto &i : users[best]) delete i;
+
+  cb->SetInstr(code);
+  scope->AddRegisterCandidate(ts);
+
+  ostringstream msg;
+  msg << "global '" << best->GetName() << "' is not written by the "
+      << "procedure or its callees; loaded once at the entry ("
+      << count[best] << " reads)";
+  CRemarks::Get()->Add(rkPassed, "globals", scope->GetDisplayName(),
+                       scope->GetLineNumber(), msg.str());
+
+  return 1;
+}
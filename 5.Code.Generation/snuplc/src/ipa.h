@@ -0,0 +1,186 @@
+//------------------------------------------------------------------------------
+/// @brief SnuPL interprocedural analysis
+//------------------------------------------------------------------------------
+
+#ifndef __SnuPL_IPA_H__
+#define __SnuPL_IPA_H__
+
+#include <iostream>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "ir.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+/// @brief call graph
+///
+/// the call graph of a module. Nodes are the scopes of the module (the module
+/// itself and all procedures), edges are direct calls. Calls to the predefined
+/// runtime procedures are not part of the graph since they have no scope.
+///
+class CCallGraph {
+  public:
+    /// @name constructor/destructor
+    /// @{
+
+    /// @brief constructor
+    /// @param m module
+    CCallGraph(CModule *m);
+
+    /// @}
+
+    /// @name properties
+    /// @{
+
+    /// @brief return the module
+    CModule* GetModule(void) const;
+
+    /// @brief return all scopes in postorder (callees before callers)
+    const vector<CScope*>& GetScopes(void) const;
+
+    /// @brief return the scope of procedure @a proc (NULL for predefined
+    ///        procedures)
+    CScope* GetScope(const CSymbol *proc) const;
+
+    /// @brief return the scopes called from @a scope
+    const set<CScope*>& GetCallees(CScope *scope) const;
+
+    /// @brief return the scopes calling @a scope
+    const set<CScope*>& GetCallers(CScope *scope) const;
+
+    /// @brief returns true if @a scope is reachable from the module body
+    bool IsReachable(CScope *scope) const;
+
+    /// @brief returns true if @a scope is part of a call cycle
+    bool IsRecursive(CScope *scope) const;
+
+    /// @}
+
+    /// @brief print the call graph to an output stream
+    /// @param out output stream
+    /// @param indent indentation
+    ostream& print(ostream &out, int indent=0) const;
+
+  private:
+    /// @brief add @a scope and its subscopes to the graph
+    void AddScope(CScope *scope);
+
+    /// @brief compute the postorder starting at @a scope
+    void PostOrder(CScope *scope, set<CScope*> &visited);
+
+    CModule *_m;                                ///< module
+    vector<CScope*> _scopes;                    ///< scopes in postorder
+    map<const CSymbol*, CScope*> _scope;        ///< procedure -> scope
+    map<CScope*, set<CScope*> > _callees;       ///< callees of a scope
+    map<CScope*, set<CScope*> > _callers;       ///< callers of a scope
+    set<CScope*> _reachable;                    ///< scopes reachable from body
+};
+
+
+//------------------------------------------------------------------------------
+/// @brief side effect analysis
+///
+/// computes for every procedure which globals it reads and writes, through
+/// which array parameters it reads and writes, and whether it performs I/O.
+/// Effects of callees are propagated to their callers by mapping the callee's
+/// array parameters to the caller's arguments; recursive procedures are
+/// handled by iterating until no summary changes. The results are stored in
+/// the procedure symbols (see CSymProc::GetSideEffects()).
+///
+class CModRefAnalysis {
+  public:
+    /// @name constructor/destructor
+    /// @{
+
+    /// @brief constructor
+    /// @param cg call graph
+    CModRefAnalysis(const CCallGraph *cg);
+
+    /// @}
+
+    /// @brief run the analysis and annotate the procedure symbols
+    void Run(void);
+
+  private:
+    /// @brief side effect summary of a scope
+    struct SSummary {
+      int effects;                  ///< side effects
+      set<const CSymbol*> ref;      ///< globals read
+      set<const CSymbol*> mod;      ///< globals written
+      set<int> pref;                ///< array parameters read through
+      set<int> pmod;                ///< array parameters written through
+
+      SSummary(void) : effects(seNone) {};
+      bool operator!=(const SSummary &s) const;
+    };
+
+    /// @brief compute the summary of @a scope from the current summaries of
+    ///        its callees
+    SSummary Summarize(CScope *scope) const;
+
+    /// @brief record a read (@a write=false) or write of @a sym in @a s
+    void Access(SSummary &s, const CSymbol *sym, bool write) const;
+
+    /// @brief emit a remark describing the summary of @a scope
+    void Remark(CScope *scope, const SSummary &s) const;
+
+    const CCallGraph *_cg;                      ///< call graph
+    map<CScope*, SSummary> _summary;            ///< summaries
+};
+
+
+//------------------------------------------------------------------------------
+/// @brief global variable analysis
+///
+/// classifies the scalar globals of a module by how they are written:
+/// - never written: all reads are replaced by the initial value (0)
+/// - written once with a constant by the straight-line code at the start of
+///   the module body, before any call to a procedure of the module: reads
+///   in the procedures and in the module body after the assignment are
+///   replaced by the constant
+/// - not written by a procedure or its callees (see CSymProc::WritesGlobal()):
+///   the integer global the procedure reads most often is loaded once at its
+///   entry into a register candidate (see CScope::GetRegisterCandidates())
+///
+/// Globals whose address is taken are not considered. Requires the results
+/// of CModRefAnalysis.
+///
+class CGlobalAnalysis {
+  public:
+    /// @name constructor/destructor
+    /// @{
+
+    /// @brief constructor
+    /// @param cg call graph
+    CGlobalAnalysis(const CCallGraph *cg);
+
+    /// @}
+
+    /// @brief run the analysis and transform the module
+    /// @retval int number of globals folded or loaded at a procedure entry
+    int Run(void);
+
+  private:
+    /// @brief determine the constant globals and their values
+    void Classify(void);
+
+    /// @brief replace the reads of constant globals in @a scope
+    /// @retval int number of instructions changed
+    int Fold(CScope *scope);
+
+    /// @brief load the integer global read most often by the procedure
+    ///        @a scope once at its entry
+    /// @retval int 1 if a global was loaded, 0 otherwise
+    int Cache(CScope *scope);
+
+    const CCallGraph *_cg;                      ///< call graph
+    map<const CSymbol*, int> _value;            ///< constant globals
+    map<const CSymbol*, const CTacInstr*> _init;///< assignment of a global
+                                                ///< written once
+};
+
+
+#endif // __SnuPL_IPA_H__
@@ -34,11 +34,13 @@
 /// DAMAGE.
 //------------------------------------------------------------------------------
 
+#include <algorithm>
 #include <iomanip>
 #include <cassert>
 
 #include "ir.h"
 #include "ast.h"
+#include "remarks.h"
 using namespace std;
 
 
@@ -54,6 +56,7 @@ char EOperationName[][OPERATION_STRLEN] = {
   "sub",                            ///< -  subtraction
   "mul",                            ///< *  multiplication
   "div",                            ///< /  division
+  "mod",                            ///< mod remainder
   "and",                            ///< && binary and
   "or",                             ///< || binary or
 
@@ -93,6 +96,14 @@ char EOperationName[][OPERATION_STRLEN] = {
   // special
   "label",                          ///< jump label; no arguments
   "nop",                            ///< no operation
+
+  // conditional assignment
+  // dst = (left relOp right) ? src1 : src2
+  "select",                         ///< select (see CTacSelect)
+
+  // multi-way branching
+  // goto targets[src1 - low] if src1 is in range
+  "switch",                         ///< jump table (see CTacSwitch)
 };
 
 bool IsRelOp(EOperation t)
@@ -105,6 +116,19 @@ bool IsRelOp(EOperation t)
          (t == opBiggerEqual);
 }
 
+EOperation NegateRelOp(EOperation t)
+{
+  switch (t) {
+    case opEqual:       return opNotEqual;
+    case opNotEqual:    return opEqual;
+    case opLessThan:    return opBiggerEqual;
+    case opLessEqual:   return opBiggerThan;
+    case opBiggerThan:  return opLessEqual;
+    case opBiggerEqual: return opLessThan;
+    default:            assert(false); return t;
+  }
+}
+
 ostream& operator<<(ostream &out, EOperation t)
 {
   out << EOperationName[t];
@@ -227,12 +251,13 @@ ostream& CTacReference::print(ostream &out, int indent) const
 // CTacInstr
 //
 CTacInstr::CTacInstr(string name)
-  : _id(-1), _op(opNop), _src1(NULL), _src2(NULL), _dst(NULL), _name(name)
+  : _id(-1), _op(opNop), _src1(NULL), _src2(NULL), _dst(NULL), _name(name),
+    _line(0)
 {
 }
 
 CTacInstr::CTacInstr(EOperation op, CTac *dst, CTacAddr *src1, CTacAddr *src2)
-  : _id(-1), _op(op), _src1(src1), _src2(src2), _dst(dst)
+  : _id(-1), _op(op), _src1(src1), _src2(src2), _dst(dst), _line(0)
 {
   if (IsBranch()) {
     CTacLabel *lbl = dynamic_cast<CTacLabel*>(_dst);
@@ -289,6 +314,11 @@ CTac* CTacInstr::GetDest(void) const
   return _dst;
 }
 
+int CTacInstr::GetLineNumber(void) const
+{
+  return _line;
+}
+
 void CTacInstr::SetDest(CTac* dst)
 {
   _dst = dst;
@@ -329,6 +359,98 @@ ostream& CTacInstr::print(ostream &out, int indent) const
 }
 
 
+//------------------------------------------------------------------------------
+// CTacSelect
+//
+CTacSelect::CTacSelect(EOperation cond, CTacAddr *left, CTacAddr *right,
+                       CTac *dst, CTacAddr *src1, CTacAddr *src2)
+  : CTacInstr(opSelect, dst, src1, src2), _cond(cond), _left(left),
+    _right(right)
+{
+  assert(IsRelOp(cond));
+  assert((left != NULL) && (right != NULL));
+}
+
+CTacSelect::~CTacSelect(void)
+{
+}
+
+EOperation CTacSelect::GetCondition(void) const
+{
+  return _cond;
+}
+
+CTacAddr* CTacSelect::GetLeft(void) const
+{
+  return _left;
+}
+
+CTacAddr* CTacSelect::GetRight(void) const
+{
+  return _right;
+}
+
+ostream& CTacSelect::print(ostream &out, int indent) const
+{
+  string ind(indent, ' ');
+
+  out << ind << right << dec << setw(3) << _id << ": "
+      << "    " << left << setw(6) << _op << " "
+      << _dst << " <- " << _left << " " << _cond << " " << _right
+      << " ? " << _src1 << " : " << _src2;
+
+  return out;
+}
+
+
+//------------------------------------------------------------------------------
+// CTacSwitch
+//
+CTacSwitch::CTacSwitch(CTacAddr *src, int low,
+                       const vector<CTacLabel*> &targets)
+  : CTacInstr(opSwitch, NULL, src), _low(low), _targets(targets)
+{
+  assert((src != NULL) && (targets.size() > 0));
+  for (const auto &t : _targets) t->AddReference(1);
+}
+
+CTacSwitch::~CTacSwitch(void)
+{
+  for (const auto &t : _targets) t->AddReference(-1);
+}
+
+int CTacSwitch::GetLow(void) const
+{
+  return _low;
+}
+
+const vector<CTacLabel*>& CTacSwitch::GetTargets(void) const
+{
+  return _targets;
+}
+
+CTacLabel* CTacSwitch::GetTarget(int value) const
+{
+  long long i = (long long)value - _low;
+  if ((i < 0) || (i >= (long long)_targets.size())) return NULL;
+  return _targets[i];
+}
+
+ostream& CTacSwitch::print(ostream &out, int indent) const
+{
+  string ind(indent, ' ');
+
+  out << ind << right << dec << setw(3) << _id << ": "
+      << "    " << left << setw(6) << _op << " "
+      << _src1 << " - " << _low << " goto";
+  for (size_t t=0; t<_targets.size(); t++) {
+    out << (t == 0 ? " " : ", ") << _targets[t]->GetLabel();
+  }
+
+  return out;
+}
+
+
 //------------------------------------------------------------------------------
 // CTacLabel
 //
@@ -381,7 +503,7 @@ CScope::CScope(CAstNode *ast, CScope *parent)
   CAstScope *s = dynamic_cast<CAstScope*>(ast);
   assert(s != NULL);
 
-  _name = s->GetName();
+  _name = _display = s->GetName();
   _symtab = s->GetSymbolTable();
   _cb = new CCodeBlock(this);
   s->ToTac(_cb);
@@ -392,6 +514,34 @@ CScope::CScope(CAstNode *ast, CScope *parent)
   }
 }
 
+CScope::CScope(const CScope *scope, const string name, const string display)
+  : _ast(scope->_ast), _name(name), _display(display),
+    _parent(scope->_parent), _temp_id(scope->_temp_id),
+    _label_id(scope->_label_id)
+{
+  assert(_parent != NULL);
+
+  // copy parameters, local variables and temporaries
+  map<const CSymbol*, const CSymbol*> symbols;
+
+  _symtab = new CSymtab(_parent->GetSymbolTable());
+  for (const auto &s : scope->GetSymbolTable()->GetSymbols()) {
+    const CSymParam *p = dynamic_cast<const CSymParam*>(s);
+    CSymbol *c = NULL;
+
+    if (p != NULL) {
+      c = new CSymParam(p->GetIndex(), p->GetName(), p->GetDataType());
+    } else if (s->GetSymbolType() == stLocal) {
+      c = new CSymLocal(s->GetName(), s->GetDataType());
+    } else continue;
+
+    _symtab->AddSymbol(c);
+    symbols[s] = c;
+  }
+
+  _cb = new CCodeBlock(this, scope->GetCodeBlock(), symbols);
+}
+
 CScope::~CScope(void)
 {
   delete _cb;
@@ -402,6 +552,11 @@ string CScope::GetName(void) const
   return _name;
 }
 
+string CScope::GetDisplayName(void) const
+{
+  return _display;
+}
+
 CScope* CScope::GetParent(void) const
 {
   return _parent;
@@ -412,11 +567,22 @@ const vector<CScope*>& CScope::GetSubscopes(void) const
   return _children;
 }
 
+void CScope::AddSubscope(CScope *scope)
+{
+  assert(scope != NULL);
+  _children.push_back(scope);
+}
+
 CSymtab* CScope::GetSymbolTable(void) const
 {
   return _symtab;
 }
 
+int CScope::GetLineNumber(void) const
+{
+  return _ast->GetToken().GetLineNumber();
+}
+
 CCodeBlock* CScope::GetCodeBlock(void) const
 {
   return _cb;
@@ -433,6 +599,11 @@ CTacTemp* CScope::CreateTemp(const CType *type)
   return new CTacTemp(s);
 }
 
+unsigned int CScope::GetNumTemps(void) const
+{
+  return _temp_id;
+}
+
 CTacLabel* CScope::CreateLabel(const char *hint)
 {
   ostringstream tmp;
@@ -442,6 +613,17 @@ CTacLabel* CScope::CreateLabel(const char *hint)
   return new CTacLabel(tmp.str());
 }
 
+void CScope::AddRegisterCandidate(const CSymbol *temp)
+{
+  assert(temp != NULL);
+  _regcand.insert(temp);
+}
+
+const set<const CSymbol*>& CScope::GetRegisterCandidates(void) const
+{
+  return _regcand;
+}
+
 ostream& CScope::print(ostream &out, int indent) const
 {
   string ind(indent, ' ');
@@ -516,16 +698,48 @@ ostream& CModule::print(ostream &out, int indent) const
 // CProcedure
 //
 CProcedure::CProcedure(CAstNode *ast, CScope *parent)
-  : CScope(ast, parent)
+  : CScope(ast, parent), _decl(NULL)
 {
 }
 
+CProcedure::CProcedure(const CProcedure *proc, const string name,
+                       const string display)
+  : CScope(proc, name, display)
+{
+  const CSymProc *orig = dynamic_cast<const CSymProc*>(proc->GetDeclaration());
+  assert(orig != NULL);
+
+  // the declaration uses the parameter symbols of the copy
+  _decl = new CSymProc(name, orig->GetDataType());
+  for (int i=0; i<orig->GetNParams(); i++) {
+    CSymParam *p = const_cast<CSymParam*>(dynamic_cast<const CSymParam*>(
+      _symtab->FindSymbol(orig->GetParam(i)->GetName(), sLocal)));
+    assert(p != NULL);
+    _decl->AddParam(p);
+  }
+
+  // the copy has (at most) the side effects of the original
+  if (orig->GetSideEffects() != seAll) {
+    set<int> pref, pmod;
+    for (int i=0; i<orig->GetNParams(); i++) {
+      if (orig->ReadsParam(i)) pref.insert(i);
+      if (orig->WritesParam(i)) pmod.insert(i);
+    }
+    _decl->SetSideEffects(orig->GetSideEffects(), orig->GetGlobalRefs(),
+                          orig->GetGlobalMods(), pref, pmod);
+  }
+
+  _parent->GetSymbolTable()->AddSymbol(_decl);
+}
+
 CProcedure::~CProcedure(void)
 {
 }
 
 CSymbol* CProcedure::GetDeclaration(void) const
 {
+  if (_decl != NULL) return _decl;
+
   CAstProcedure *s = dynamic_cast<CAstProcedure*>(_ast);
   assert(s != NULL);
 
@@ -554,13 +768,134 @@ ostream& CProcedure::print(ostream &out, int indent) const
 // CCodeBlock
 //
 CCodeBlock::CCodeBlock(CScope *owner)
-  : _owner(owner), _inst_id(0)
+  : _owner(owner), _inst_id(0), _line(0), _cold(NULL)
 {
   assert(_owner != NULL);
 }
 
+CCodeBlock::CCodeBlock(CScope *owner, const CCodeBlock *cb,
+                       const map<const CSymbol*, const CSymbol*> &symbols)
+  : _owner(owner), _inst_id(0), _line(0), _cold(NULL)
+{
+  assert((_owner != NULL) && (cb != NULL));
+
+  // labels first; branches may refer to labels further down
+  map<const CTac*, CTacLabel*> labels;
+  for (const auto &i : cb->GetInstr()) {
+    CTacLabel *l = dynamic_cast<CTacLabel*>(i);
+    if (l != NULL) labels[l] = new CTacLabel(l->GetLabel());
+  }
+
+  for (const auto &i : cb->GetInstr()) {
+    CTacInstr *c;
+
+    if (i->GetOperation() == opLabel) {
+      c = labels[i];
+    } else {
+      c = CopyInstr(i, symbols, labels);
+    }
+
+    c->_line = i->_line;
+    AddInstr(c);
+  }
+}
+
 CCodeBlock::~CCodeBlock(void)
 {
+  // labels last: deleting a branch decrements the reference count of its
+  // target label
+  vector<CTacInstr*> labels;
+  for (const auto &i : _ops) {
+    if (dynamic_cast<CTacLabel*>(i) != NULL) labels.push_back(i);
+    else delete i;
+  }
+  for (const auto &l : labels) delete l;
+}
+
+CTacInstr* CCodeBlock::CopyInstr(const CTacInstr *instr,
+                                 const map<const CSymbol*, const CSymbol*> &symbols,
+                                 const map<const CTac*, CTacLabel*> &labels)
+{
+  return Copy(instr, symbols, labels, NULL);
+}
+
+CTacInstr* CCodeBlock::FoldInstr(const CTacInstr *instr,
+                                 const map<const CSymbol*, int> &values)
+{
+  return Copy(instr, map<const CSymbol*, const CSymbol*>(),
+              map<const CTac*, CTacLabel*>(), &values);
+}
+
+CTacInstr* CCodeBlock::Copy(const CTacInstr *instr,
+                            const map<const CSymbol*, const CSymbol*> &symbols,
+                            const map<const CTac*, CTacLabel*> &labels,
+                            const map<const CSymbol*, int> *values)
+{
+  assert((instr != NULL) && (instr->GetOperation() != opLabel));
+  CTacInstr *c;
+
+  if (instr->GetOperation() == opSwitch) {
+    const CTacSwitch *sw = dynamic_cast<const CTacSwitch*>(instr);
+    vector<CTacLabel*> targets;
+    for (const auto &t : sw->GetTargets()) {
+      map<const CTac*, CTacLabel*>::const_iterator it = labels.find(t);
+      targets.push_back(it != labels.end() ? it->second : t);
+    }
+    c = new CTacSwitch(dynamic_cast<CTacAddr*>(CopyOperand(sw->GetSrc(1), symbols, values)),
+                       sw->GetLow(), targets);
+  } else if (instr->GetOperation() == opSelect) {
+    const CTacSelect *sel = dynamic_cast<const CTacSelect*>(instr);
+    c = new CTacSelect(sel->GetCondition(),
+                       dynamic_cast<CTacAddr*>(CopyOperand(sel->GetLeft(), symbols, values)),
+                       dynamic_cast<CTacAddr*>(CopyOperand(sel->GetRight(), symbols, values)),
+                       CopyOperand(sel->GetDest(), symbols),
+                       dynamic_cast<CTacAddr*>(CopyOperand(sel->GetSrc(1), symbols, values)),
+                       dynamic_cast<CTacAddr*>(CopyOperand(sel->GetSrc(2), symbols, values)));
+  } else {
+    CTac *dst = instr->GetDest();
+    map<const CTac*, CTacLabel*>::const_iterator it = labels.find(dst);
+    if (it != labels.end()) dst = it->second;
+    else if (!instr->IsBranch()) dst = CopyOperand(dst, symbols);
+
+    c = new CTacInstr(instr->GetOperation(), dst,
+                      dynamic_cast<CTacAddr*>(CopyOperand(instr->GetSrc(1), symbols, values)),
+                      dynamic_cast<CTacAddr*>(CopyOperand(instr->GetSrc(2), symbols, values)));
+  }
+
+  c->_line = instr->_line;
+  return c;
+}
+
+CTac* CCodeBlock::CopyOperand(const CTac *op,
+                              const map<const CSymbol*, const CSymbol*> &symbols,
+                              const map<const CSymbol*, int> *values)
+{
+  if (op == NULL) return NULL;
+
+  const CTacConst *c = dynamic_cast<const CTacConst*>(op);
+  if (c != NULL) return new CTacConst(c->GetValue());
+
+  const CTacName *n = dynamic_cast<const CTacName*>(op);
+  assert(n != NULL);
+
+  const CSymbol *s = n->GetSymbol();
+  if ((values != NULL) && (dynamic_cast<const CTacReference*>(op) == NULL)) {
+    map<const CSymbol*, int>::const_iterator v = values->find(s);
+    if (v != values->end()) return new CTacConst(v->second);
+  }
+  map<const CSymbol*, const CSymbol*>::const_iterator it = symbols.find(s);
+  if (it != symbols.end()) s = it->second;
+
+  const CTacReference *r = dynamic_cast<const CTacReference*>(op);
+  if (r != NULL) {
+    const CSymbol *d = r->GetDerefSymbol();
+    it = symbols.find(d);
+    if (it != symbols.end()) d = it->second;
+    return new CTacReference(s, d);
+  }
+
+  if (dynamic_cast<const CTacTemp*>(op) != NULL) return new CTacTemp(s);
+  return new CTacName(s);
 }
 
 string CCodeBlock::GetName(void) const
@@ -573,6 +908,16 @@ CScope* CCodeBlock::GetOwner(void) const
   return _owner;
 }
 
+void CCodeBlock::SetLineNumber(int line)
+{
+  _line = line;
+}
+
+int CCodeBlock::GetLineNumber(void) const
+{
+  return _line;
+}
+
 CTacTemp* CCodeBlock::CreateTemp(const CType *type)
 {
   return _owner->CreateTemp(type);
@@ -587,6 +932,7 @@ CTacInstr* CCodeBlock::AddInstr(CTacInstr *instr)
 {
   assert(instr != NULL);
   instr->SetId(_inst_id++);
+  if (instr->_line == 0) instr->_line = _line;
   _ops.push_back(instr);
 
   return instr;
@@ -597,13 +943,45 @@ const list<CTacInstr*>& CCodeBlock::GetInstr(void) const
   return _ops;
 }
 
+CTacInstr* CCodeBlock::ReplaceInstr(CTacInstr *instr, CTacInstr *with)
+{
+  assert((instr != NULL) && (with != NULL));
+
+  list<CTacInstr*>::iterator it = find(_ops.begin(), _ops.end(), instr);
+  assert(it != _ops.end());
+
+  with->SetId(instr->GetId());
+  with->_line = instr->_line;
+  *it = with;
+  if (_cold == instr) _cold = with;
+  delete instr;
+
+  return with;
+}
+
+void CCodeBlock::RemoveInstr(CTacInstr *instr)
+{
+  assert(instr != NULL);
+
+  list<CTacInstr*>::iterator it = find(_ops.begin(), _ops.end(), instr);
+  assert(it != _ops.end());
+
+  it = _ops.erase(it);
+  if (_cold == instr) _cold = (it == _ops.end() ? NULL : *it);
+  delete instr;
+}
+
 void CCodeBlock::CleanupControlFlow(void)
 {
   list<CTacInstr*>::iterator it = _ops.begin();
+  int nbranches = 0, nlabels = 0;
 
   // 1. pass: delete all branches (absolute/conditional) that jump to the
-  //          immediately next instruction. Deleting branch instruction will
-  //          automatically decrease the reference count of the target label.
+  //          immediately next instruction or to one of the labels right
+  //          after it. Deleting branch instruction will automatically
+  //          decrease the reference count of the target label.
+  //          Branches into the rarely executed code are kept since it is
+  //          not emitted right after the preceding code.
   while (it != _ops.end()) {
     CTacInstr *instr = *it++;
 
@@ -611,9 +989,15 @@ void CCodeBlock::CleanupControlFlow(void)
       CTacLabel *lbl = dynamic_cast<CTacLabel*>(instr->GetDest());
       CTacInstr *next = (it == _ops.end() ? NULL : *it);
 
-      if ((lbl != NULL) && (lbl == next)) {
+      list<CTacInstr*>::iterator l = it;
+      while ((l != _ops.end()) && (*l != lbl) && (*l != _cold) &&
+             ((*l)->GetOperation() == opLabel)) l++;
+
+      if ((lbl != NULL) && (l != _ops.end()) && (*l == lbl) && (lbl != _cold)) {
+        if (_cold == instr) _cold = next;
         delete instr;
         it = _ops.erase(--it);
+        nbranches++;
       }
     }
   }
@@ -628,15 +1012,47 @@ void CCodeBlock::CleanupControlFlow(void)
     if ((lbl != NULL) && (lbl->GetRefCnt() == 0)) {
       delete lbl;
       it = _ops.erase(--it);
+      if (_cold == lbl) _cold = (it == _ops.end() ? NULL : *it);
+      nlabels++;
     }
   }
 
+  CRemarks *rm = CRemarks::Get();
+  if (rm->IsEnabled(rkPassed) && (nbranches + nlabels > 0)) {
+    ostringstream msg;
+    msg << "removed " << nbranches << " branch(es) to the next instruction and "
+        << nlabels << " unreferenced label(s)";
+    rm->Add(rkPassed, "cleanup", _owner->GetDisplayName(),
+            _owner->GetLineNumber(), msg.str());
+  }
+
   // 3. renumber instructions (we shouldn't do that really, but it's prettier)
   _inst_id = 0;
   it = _ops.begin();
   while (it != _ops.end()) (*it++)->SetId(_inst_id++);
 }
 
+void CCodeBlock::SetInstr(const list<CTacInstr*> &instr, CTacInstr *cold)
+{
+  int line = _owner->GetLineNumber();
+
+  _ops = instr;
+  _cold = cold;
+
+  // new instructions inherit the source line of their predecessor
+  _inst_id = 0;
+  for (const auto &i : _ops) {
+    i->SetId(_inst_id++);
+    if (i->_line == 0) i->_line = line;
+    line = i->_line;
+  }
+}
+
+CTacInstr* CCodeBlock::GetColdCode(void) const
+{
+  return _cold;
+}
+
 ostream& CCodeBlock::print(ostream &out, int indent) const
 {
   string ind(indent, ' ');
@@ -645,6 +1061,7 @@ ostream& CCodeBlock::print(ostream &out, int indent) const
 
   list<CTacInstr*>::const_iterator it = _ops.begin();
   while (it != _ops.end()) {
+    if (*it == _cold) out << ind << "  (rarely executed)" << endl;
     (*it++)->print(out, indent+2);
     out << endl;
   }
@@ -39,6 +39,8 @@
 
 #include <iostream>
 #include <list>
+#include <map>
+#include <set>
 #include <vector>
 
 #include "symtab.h"
@@ -54,6 +56,7 @@ enum EOperation {
   opSub,                            ///< -  subtraction
   opMul,                            ///< *  multiplication
   opDiv,                            ///< /  division
+  opMod,                            ///< mod remainder
   opAnd,                            ///< && binary and
   opOr,                             ///< || binary or
 
@@ -93,11 +96,22 @@ enum EOperation {
   // special
   opLabel,                          ///< jump label; no arguments
   opNop,                            ///< no operation
+
+  // conditional assignment
+  // dst = (left relOp right) ? src1 : src2
+  opSelect,                         ///< select (see CTacSelect)
+
+  // multi-way branching
+  // goto targets[src1 - low] if src1 is in range
+  opSwitch,                         ///< jump table (see CTacSwitch)
 };
 
 /// @brief returns true if @a op is a relational operation
 bool IsRelOp(EOperation t);
 
+/// @brief return the relation that holds if relation @a t does not hold
+EOperation NegateRelOp(EOperation t);
+
 /// @brief EOperation output operator
 ///
 /// @param out output stream
@@ -357,6 +371,9 @@ class CTacInstr : public CTac {
     /// @brief return the destination
     CTac* GetDest(void) const;
 
+    /// @brief return the source line this instruction was generated from
+    int GetLineNumber(void) const;
+
     /// @}
 
     /// @name output
@@ -383,11 +400,72 @@ class CTacInstr : public CTac {
     CTacAddr      *_src1;            ///< source operand 1
     CTacAddr      *_src2;            ///< source operand 2
     CTac          *_dst;             ///< destination operand
+    int            _line;            ///< source line (0 if unknown)
 
     friend class CCodeBlock;
 };
 
 
+//------------------------------------------------------------------------------
+/// @brief select class
+///
+/// TAC class for conditional assignments
+///   dst = (left relOp right) ? src1 : src2
+/// The compared operands are not source operands in the sense of GetSrc().
+/// Selects are only created right before code generation (see CIfConversion).
+///
+
+class CTacSelect : public CTacInstr {
+  public:
+    /// @name constructors/destructors
+    /// @{
+
+    /// @brief constructor
+    /// @param cond relational operation
+    /// @param left left operand of the comparison
+    /// @param right right operand of the comparison
+    /// @param dst destination operand
+    /// @param src1 value assigned if the condition holds
+    /// @param src2 value assigned otherwise
+    CTacSelect(EOperation cond, CTacAddr *left, CTacAddr *right,
+               CTac *dst, CTacAddr *src1, CTacAddr *src2);
+
+    /// @brief destructor
+    virtual ~CTacSelect(void);
+
+    /// @}
+
+    /// @name properties
+    /// @{
+
+    /// @brief return the relational operation
+    EOperation GetCondition(void) const;
+
+    /// @brief return the left operand of the comparison
+    CTacAddr* GetLeft(void) const;
+
+    /// @brief return the right operand of the comparison
+    CTacAddr* GetRight(void) const;
+
+    /// @}
+
+    /// @name output
+    /// @{
+
+    /// @brief print the node to an output stream
+    /// @param out output stream
+    /// @param indent indentation
+    virtual ostream& print(ostream &out, int indent=0) const;
+
+    /// @}
+
+  protected:
+    EOperation _cond;                ///< relational operation
+    CTacAddr  *_left;                ///< left operand of the comparison
+    CTacAddr  *_right;               ///< right operand of the comparison
+};
+
+
 //------------------------------------------------------------------------------
 /// @brief label class
 ///
@@ -440,6 +518,62 @@ class CTacLabel : public CTacInstr {
 };
 
 
+//------------------------------------------------------------------------------
+/// @brief switch class
+///
+/// TAC class for multi-way branches through a jump table
+///   if low <= src1 < low + #targets then goto targets[src1 - low]
+/// Like a conditional branch, a switch falls through to the next instruction
+/// if src1 is out of range. Switches are not branches in the sense of
+/// IsBranch() since they have more than one target.
+///
+
+class CTacSwitch : public CTacInstr {
+  public:
+    /// @name constructors/destructors
+    /// @{
+
+    /// @brief constructor
+    /// @param src switch value
+    /// @param low value of the first target
+    /// @param targets targets of the values low, low+1, ...
+    CTacSwitch(CTacAddr *src, int low, const vector<CTacLabel*> &targets);
+
+    /// @brief destructor
+    virtual ~CTacSwitch(void);
+
+    /// @}
+
+    /// @name properties
+    /// @{
+
+    /// @brief return the value of the first target
+    int GetLow(void) const;
+
+    /// @brief return the targets
+    const vector<CTacLabel*>& GetTargets(void) const;
+
+    /// @brief return the target for @a value (NULL if out of range)
+    CTacLabel* GetTarget(int value) const;
+
+    /// @}
+
+    /// @name output
+    /// @{
+
+    /// @brief print the node to an output stream
+    /// @param out output stream
+    /// @param indent indentation
+    virtual ostream& print(ostream &out, int indent=0) const;
+
+    /// @}
+
+  protected:
+    int _low;                        ///< value of the first target
+    vector<CTacLabel*> _targets;     ///< jump table
+};
+
+
 //------------------------------------------------------------------------------
 /// @brief scope class
 ///
@@ -470,12 +604,19 @@ class CScope {
     /// @brief return the scope's name
     string GetName(void) const;
 
+    /// @brief return the name under which the scope is reported to the user
+    ///        (profiles, remarks). Same as GetName() except for copies.
+    string GetDisplayName(void) const;
+
     /// @brief return a reference to the parent scope
     CScope* GetParent(void) const;
 
     /// @brief return a reference to the list of subscopes
     const vector<CScope*>& GetSubscopes(void) const;
 
+    /// @brief add @a scope to the list of subscopes
+    void AddSubscope(CScope *scope);
+
     /// @brief return a reference to the symbol table
     CSymtab* GetSymbolTable(void) const;
 
@@ -484,6 +625,9 @@ class CScope {
     /// Only set for procedures/functions; a module will return null.
     virtual CSymbol* GetDeclaration(void) const = 0;
 
+    /// @brief return the source line of the scope's declaration
+    int GetLineNumber(void) const;
+
     /// @}
 
 
@@ -503,10 +647,20 @@ class CScope {
     /// @param type type of the temporary
     CTacTemp* CreateTemp(const CType *type);
 
+    /// @brief return the number of temporaries created so far
+    unsigned int GetNumTemps(void) const;
+
     /// @brief create a new (unique) label
     /// @param hint optional descriptive string
     CTacLabel* CreateLabel(const char *hint=NULL);
 
+    /// @brief mark temporary @a temp to be kept in a register. The live
+    ///        ranges of the register candidates of a scope are disjoint.
+    void AddRegisterCandidate(const CSymbol *temp);
+
+    /// @brief return the temporaries to be kept in a register
+    const set<const CSymbol*>& GetRegisterCandidates(void) const;
+
     /// @}
 
 
@@ -534,8 +688,14 @@ class CScope {
     /// @}
 
   protected:
+    /// @brief constructor for a copy of @a scope named @a name and reported
+    ///        as @a display. Parameters, local variables, temporaries and the
+    ///        code are copied; the copy has no subscopes.
+    CScope(const CScope *scope, const string name, const string display);
+
     CAstNode *_ast;                  ///< abstract syntax tree
     string _name;                    ///< name
+    string _display;                 ///< name reported to the user
     CSymtab *_symtab;                ///< symbol table
     CScope *_parent;                 ///< superordinate scope
     vector<CScope*> _children;       ///< list of functions
@@ -543,6 +703,7 @@ class CScope {
 
     unsigned int _temp_id;           ///< next id for temporaries
     unsigned int _label_id;          ///< next id for labels
+    set<const CSymbol*> _regcand;    ///< register candidates
 };
 
 /// @name CScope output operators
@@ -622,6 +783,18 @@ class CProcedure : public CScope {
     /// @param ast abstract syntax tree (must be a CAstProcedure instance)
     CProcedure(CAstNode *ast, CScope *parent);
 
+    /// @brief constructor for a copy of @a proc (used for specialization)
+    ///
+    /// The copy gets a new declaration named @a name that is added to the
+    /// symbol table of the parent scope. It is not added to the parent's
+    /// subscopes (see CScope::AddSubscope()).
+    ///
+    /// @param proc procedure to copy
+    /// @param name name of the copy
+    /// @param display name of the copy in profiles and remarks
+    CProcedure(const CProcedure *proc, const string name,
+               const string display);
+
     /// @brief destructor
     virtual ~CProcedure(void);
 
@@ -645,6 +818,9 @@ class CProcedure : public CScope {
     virtual ostream&  print(ostream &out, int indent=0) const;
 
     /// @}
+
+  protected:
+    CSymProc *_decl;                 ///< declaration (copies only)
 };
 
 
@@ -663,6 +839,13 @@ class CCodeBlock {
     /// @param owner scope owning this block
     CCodeBlock(CScope *owner);
 
+    /// @brief constructor for a copy of @a cb
+    /// @param owner scope owning this block
+    /// @param cb code block to copy
+    /// @param symbols maps the local symbols of @a cb to those of @a owner
+    CCodeBlock(CScope *owner, const CCodeBlock *cb,
+               const map<const CSymbol*, const CSymbol*> &symbols);
+
     /// @brief destructor
     virtual ~CCodeBlock(void);
 
@@ -678,6 +861,12 @@ class CCodeBlock {
     /// @brief return the owner of this block
     CScope* GetOwner(void) const;
 
+    /// @brief set the source line of subsequently added instructions
+    void SetLineNumber(int line);
+
+    /// @brief return the source line of subsequently added instructions
+    int GetLineNumber(void) const;
+
     /// @}
 
 
@@ -705,9 +894,44 @@ class CCodeBlock {
     /// @brief return (a reference) to the list of instructions
     const list<CTacInstr*>& GetInstr(void) const;
 
+    /// @brief replace @a instr by @a with. @a with inherits the id and the
+    ///        source line of @a instr; @a instr is deleted
+    /// @retval CTacInstr* inserted instruction
+    CTacInstr* ReplaceInstr(CTacInstr *instr, CTacInstr *with);
+
+    /// @brief remove and delete @a instr
+    void RemoveInstr(CTacInstr *instr);
+
     /// @brief remove unused/superfluous labels and goto instructions
     void CleanupControlFlow(void);
 
+    /// @brief return a copy of @a instr (not a label) with the symbols of
+    ///        its operands mapped through @a symbols and its branch target
+    ///        mapped through @a labels (if contained)
+    static CTacInstr* CopyInstr(const CTacInstr *instr,
+                                const map<const CSymbol*, const CSymbol*> &symbols,
+                                const map<const CTac*, CTacLabel*> &labels =
+                                  map<const CTac*, CTacLabel*>());
+
+    /// @brief return a copy of @a instr (not a label) with the reads of the
+    ///        symbols in @a values replaced by constants
+    static CTacInstr* FoldInstr(const CTacInstr *instr,
+                                const map<const CSymbol*, int> &values);
+
+    /// @brief replace the list of instructions by @a instr, a permutation
+    ///        of the current instructions and new ones. Instructions that are
+    ///        not in @a instr must have been deleted by the caller.
+    /// @param instr new list of instructions
+    /// @param cold first instruction of the rarely executed code at the end
+    ///        of the block (NULL if none)
+    void SetInstr(const list<CTacInstr*> &instr, CTacInstr *cold=NULL);
+
+    /// @brief return the first instruction of the rarely executed code at
+    ///        the end of the block (NULL if none). The code before it never
+    ///        falls through into the rarely executed code; the rarely
+    ///        executed code always ends with a branch or a return.
+    CTacInstr* GetColdCode(void) const;
+
     /// @}
 
 
@@ -735,9 +959,25 @@ class CCodeBlock {
     /// @}
 
   protected:
+    /// @brief return a copy of @a instr (see CopyInstr()) with the reads of
+    ///        the symbols in @a values (if not NULL) replaced by constants
+    static CTacInstr* Copy(const CTacInstr *instr,
+                           const map<const CSymbol*, const CSymbol*> &symbols,
+                           const map<const CTac*, CTacLabel*> &labels,
+                           const map<const CSymbol*, int> *values);
+
+    /// @brief return a copy of operand @a op with its symbols mapped through
+    ///        @a symbols. Names of symbols in @a values (if not NULL) are
+    ///        replaced by constants.
+    static CTac* CopyOperand(const CTac *op,
+                             const map<const CSymbol*, const CSymbol*> &symbols,
+                             const map<const CSymbol*, int> *values=NULL);
+
     CScope *_owner;                  ///< block owner
     list<CTacInstr*> _ops;           ///< operation list
     unsigned int _inst_id;           ///< next id for instructions
+    int _line;                       ///< current source line
+    CTacInstr *_cold;                ///< start of rarely executed code
 };
 
 /// @name CCodeBlock output operators
@@ -0,0 +1,107 @@
+//------------------------------------------------------------------------------
+/// @brief SnuPL subprocess job queue
+//------------------------------------------------------------------------------
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "jobs.h"
+using namespace std;
+
+extern char **environ;
+
+
+//------------------------------------------------------------------------------
+// CJobQueue
+//
+CJobQueue::CJobQueue(int max_jobs)
+  : _max_jobs(max_jobs)
+{
+  if (_max_jobs <= 0) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    _max_jobs = n > 0 ? (int)n : 1;
+  }
+}
+
+CJobQueue::~CJobQueue(void)
+{
+  Wait();
+}
+
+int CJobQueue::GetMaxJobs(void) const
+{
+  return _max_jobs;
+}
+
+bool CJobQueue::Submit(const vector<string> &args)
+{
+  assert(args.size() > 0);
+
+  while ((int)_running.size() >= _max_jobs) Reap();
+
+  vector<char*> argv;
+  for (size_t i=0; i<args.size(); i++) {
+    argv.push_back(const_cast<char*>(args[i].c_str()));
+  }
+  argv.push_back(NULL);
+
+  // the job shares our stdout; do not let it overtake buffered output
+  cout.flush();
+
+  pid_t pid;
+  int res = posix_spawnp(&pid, argv[0], NULL, NULL, &argv[0], environ);
+  if (res != 0) {
+    cout << "  failed to run " << args[0] << ": " << strerror(res) << endl;
+    return false;
+  }
+
+  _running[pid] = CommandLine(args);
+  return true;
+}
+
+void CJobQueue::Wait(void)
+{
+  while (_running.size() > 0) Reap();
+}
+
+string CJobQueue::CommandLine(const vector<string> &args)
+{
+  ostringstream cmd;
+
+  for (size_t i=0; i<args.size(); i++) {
+    if (i > 0) cmd << " ";
+    cmd << args[i];
+  }
+
+  return cmd.str();
+}
+
+void CJobQueue::Reap(void)
+{
+  int status;
+  pid_t pid = waitpid(-1, &status, 0);
+
+  if (pid < 0) {
+    // no children left (should not happen)
+    if (errno != EINTR) _running.clear();
+    return;
+  }
+
+  map<pid_t, string>::iterator it = _running.find(pid);
+  if (it == _running.end()) return;
+
+  if (WIFEXITED(status) && (WEXITSTATUS(status) != 0)) {
+    cout << "  command '" << it->second << "' failed with exit status "
+         << WEXITSTATUS(status) << "." << endl;
+  } else if (WIFSIGNALED(status)) {
+    cout << "  command '" << it->second << "' terminated by signal "
+         << WTERMSIG(status) << "." << endl;
+  }
+
+  _running.erase(it);
+}
@@ -0,0 +1,67 @@
+//------------------------------------------------------------------------------
+/// @brief SnuPL subprocess job queue
+//------------------------------------------------------------------------------
+
+#ifndef __SnuPL_JOBS_H__
+#define __SnuPL_JOBS_H__
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <sys/types.h>
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+/// @brief subprocess job queue
+///
+/// runs external tools (dot, gcc) in the background while the compiler
+/// continues with the next file. At most GetMaxJobs() jobs run at the same
+/// time; Submit() blocks until a slot is free. Failures are reported on the
+/// console when a job is reaped.
+///
+class CJobQueue {
+  public:
+    /// @name constructor/destructor
+    /// @{
+
+    /// @brief constructor
+    /// @param max_jobs maximum number of concurrent jobs (0: number of
+    ///        online processors)
+    CJobQueue(int max_jobs=0);
+
+    /// @brief destructor; waits for all running jobs
+    ~CJobQueue(void);
+
+    /// @}
+
+    /// @name job handling
+    /// @{
+
+    /// @brief return the maximum number of concurrent jobs
+    int GetMaxJobs(void) const;
+
+    /// @brief start the command @a args (searched in PATH) in the background
+    /// @param args command and arguments
+    /// @retval true if the command was started
+    bool Submit(const vector<string> &args);
+
+    /// @brief wait for all running jobs
+    void Wait(void);
+
+    /// @}
+
+    /// @brief return @a args as a command line
+    static string CommandLine(const vector<string> &args);
+
+  private:
+    /// @brief wait for one running job to terminate and report its status
+    void Reap(void);
+
+    int _max_jobs;                  ///< maximum number of concurrent jobs
+    map<pid_t, string> _running;    ///< running jobs (pid -> command line)
+};
+
+
+#endif // __SnuPL_JOBS_H__
@@ -0,0 +1,268 @@
+//------------------------------------------------------------------------------
+/// @brief SnuPL basic block layout
+//------------------------------------------------------------------------------
+
+#include <cassert>
+#include <sstream>
+
+#include "layout.h"
+#include "remarks.h"
+using namespace std;
+
+
+//------------------------------------------------------------------------------
+// CBlockLayout
+//
+// output routines perform a system call; blocks calling them are assumed to
+// report errors or progress
+//
+static const char *outputRoutine[] = {
+  "WriteInt", "WriteChar", "WriteStr", "WriteLn",
+};
+
+CBlockLayout::CBlockLayout(CModule *m)
+  : _m(m)
+{
+  assert(m != NULL);
+}
+
+int CBlockLayout::Run(void)
+{
+  int n = Layout(_m);
+  for (const auto &s : _m->GetSubscopes()) n += Layout(s);
+  return n;
+}
+
+int CBlockLayout::Run(CScope *scope)
+{
+  return Layout(scope);
+}
+
+int CBlockLayout::Layout(CScope *scope)
+{
+  CCodeBlock *cb = scope->GetCodeBlock();
+  CRemarks *rm = CRemarks::Get();
+  CCfg cfg(cb);
+  const vector<CBasicBlock*> &blocks = cfg.GetBlocks();
+  const int nb = blocks.size();
+  const int END = nb;               // falls through to the procedure exit
+  const int NONE = -1;              // does not fall through
+
+  // 1. predict the unlikely blocks: arms of non-loop branches (skipping
+  //    blocks that only jump on), then the blocks that are only reached
+  //    from unlikely blocks
+  vector<bool> cold(nb, false);
+  for (const auto &bb : blocks) {
+    if (!bb->IsReachable() || !IsRelOp(bb->GetLast()->GetOperation()) ||
+        (bb->GetSucc().size() != 2) || IsLoopBranch(bb)) continue;
+
+    CBasicBlock *arm[2];
+    bool unlikely[2];
+    string why[2];
+    for (int k=0; k<2; k++) {
+      arm[k] = bb->GetSucc()[k];
+      while ((arm[k]->GetInstr().size() == 1) &&
+             (arm[k]->GetLast()->GetOperation() == opGoto) &&
+             (arm[k]->GetSucc()[0]->GetPred().size() == 1)) {
+        arm[k] = arm[k]->GetSucc()[0];
+      }
+      unlikely[k] = (arm[k]->GetPred().size() == 1) &&
+                    IsUnlikely(arm[k], why[k]);
+    }
+    if (unlikely[0] == unlikely[1]) continue;
+
+    int k = unlikely[0] ? 0 : 1;
+    cold[arm[k]->GetId()] = true;
+    rm->Add(rkAnalysis, "layout", scope->GetDisplayName(),
+            arm[k]->GetLineNumber(), "block predicted unlikely: " + why[k]);
+  }
+
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (const auto &bb : blocks) {
+      if (cold[bb->GetId()] || !bb->IsReachable() || (bb == cfg.GetEntry()))
+        continue;
+
+      // back edges do not count; a loop is unlikely if its entry is
+      int n = 0, ncold = 0;
+      for (const auto &p : bb->GetPred()) {
+        if (!p->IsReachable() || cfg.Dominates(bb, p)) continue;
+        n++;
+        if (cold[p->GetId()]) ncold++;
+      }
+      if ((n > 0) && (n == ncold)) cold[bb->GetId()] = changed = true;
+    }
+  }
+
+  // 2. likely blocks in their original order followed by the unlikely ones
+  vector<CBasicBlock*> order;
+  for (const auto &bb : blocks) {
+    if (bb->IsReachable() && !cold[bb->GetId()]) order.push_back(bb);
+  }
+  const size_t nhot = order.size();
+  for (const auto &bb : blocks) {
+    if (bb->IsReachable() && cold[bb->GetId()]) order.push_back(bb);
+  }
+  const int ncold = order.size() - nhot, nunreachable = nb - order.size();
+
+  vector<int> fall(nb, NONE);       // fall-through successor
+  vector<CTacLabel*> label(nb);
+  for (const auto &bb : blocks) {
+    EOperation op = bb->GetLast()->GetOperation();
+    if ((op != opGoto) && (op != opReturn)) fall[bb->GetId()] = bb->GetId()+1;
+    label[bb->GetId()] = bb->GetLabel();
+  }
+
+  vector<bool> dropped(nb, false);
+  auto next = [&](size_t p) -> int {
+    size_t q = p+1;
+    while ((q < order.size()) && (q != nhot) && dropped[order[q]->GetId()]) q++;
+    if ((p < nhot) && (q >= nhot)) return END;
+    if (q >= order.size()) return NONE;
+    return order[q]->GetId();
+  };
+  auto target = [&](const CTacInstr *br) -> int {
+    return cfg.GetBlock(dynamic_cast<CTacLabel*>(br->GetDest()))->GetId();
+  };
+
+  // 3. invert conditional branches over a jump to the next block
+  map<int, CTacInstr*> branch;      // replaced conditional branches
+  int ninverted = 0;
+  for (size_t p=0; p<order.size(); p++) {
+    int b = order[p]->GetId(), g = fall[b];
+    CTacInstr *br = order[p]->GetLast();
+    if (!IsRelOp(br->GetOperation()) || (g == END) || (next(p) != g)) continue;
+
+    CBasicBlock *gb = blocks[g];
+    if ((gb->GetInstr().size() != 1) ||
+        (gb->GetLast()->GetOperation() != opGoto) ||
+        (next(p+1) != target(br))) continue;
+
+    branch[b] = new CTacInstr(NegateRelOp(br->GetOperation()),
+                              gb->GetLast()->GetDest(),
+                              br->GetSrc(1), br->GetSrc(2));
+    fall[b] = target(br);
+    dropped[g] = true;
+    ninverted++;
+  }
+
+  if ((ncold == 0) && (nunreachable == 0) && (ninverted == 0)) return 0;
+
+  // 4. blocks that no longer fall through into their successor branch to it
+  //    (or return if they fell through to the procedure exit)
+  vector<CTacInstr*> jump(nb, NULL);
+  for (size_t p=0; p<order.size(); p++) {
+    int b = order[p]->GetId(), f = fall[b], n = next(p);
+    if (dropped[b] || (f == NONE) || (f == n)) continue;
+
+    if ((f != END) && (label[f] == NULL)) label[f] = cb->CreateLabel();
+
+    CTacInstr *br = branch.find(b) != branch.end() ? branch[b]
+                                                   : order[p]->GetLast();
+    if ((f != END) && IsRelOp(br->GetOperation()) && (target(br) == n)) {
+      branch[b] = new CTacInstr(NegateRelOp(br->GetOperation()), label[f],
+                                br->GetSrc(1), br->GetSrc(2));
+      if (br != order[p]->GetLast()) delete br;
+    } else if (f == END) {
+      jump[b] = new CTacInstr(opReturn, NULL);
+    } else {
+      jump[b] = new CTacInstr(opGoto, label[f]);
+    }
+  }
+
+  // 5. emit the blocks in their new order
+  list<CTacInstr*> code;
+  CTacInstr *first_cold = NULL;
+  for (size_t p=0; p<order.size(); p++) {
+    CBasicBlock *bb = order[p];
+    int b = bb->GetId();
+    if (dropped[b]) continue;
+
+    size_t size = code.size();
+    if (label[b] != bb->GetLabel()) code.push_back(label[b]);
+    for (const auto &i : bb->GetInstr()) {
+      if ((i == bb->GetLast()) && (branch.find(b) != branch.end())) {
+        code.push_back(branch[b]);
+      } else {
+        code.push_back(i);
+      }
+    }
+    if (jump[b] != NULL) code.push_back(jump[b]);
+
+    if ((p >= nhot) && (first_cold == NULL)) {
+      list<CTacInstr*>::iterator it = code.begin();
+      advance(it, size);
+      first_cold = *it;
+    }
+  }
+
+  // 6. delete the replaced branches, the dropped jumps and the unreachable
+  //    blocks (branches before labels since they reference them)
+  for (const auto &r : branch) delete blocks[r.first]->GetLast();
+  for (const auto &bb : blocks) {
+    if (dropped[bb->GetId()]) delete bb->GetLast();
+  }
+  vector<CTacLabel*> labels;
+  for (const auto &bb : blocks) {
+    if (bb->IsReachable()) continue;
+    for (const auto &i : bb->GetInstr()) {
+      if (i->GetOperation() == opLabel) labels.push_back(bb->GetLabel());
+      else delete i;
+    }
+  }
+  for (const auto &l : labels) delete l;
+
+  cb->SetInstr(code, first_cold);
+  cb->CleanupControlFlow();
+
+  if (ncold > 0) {
+    rm->Add(rkPassed, "layout", scope->GetDisplayName(), scope->GetLineNumber(),
+            to_string(ncold) + " unlikely block(s) moved out of line");
+  }
+  if (ninverted > 0) {
+    rm->Add(rkPassed, "layout", scope->GetDisplayName(), scope->GetLineNumber(),
+            to_string(ninverted) + " branch(es) inverted to fall through "
+            "into the next block");
+  }
+  if (nunreachable > 0) {
+    rm->Add(rkPassed, "layout", scope->GetDisplayName(), scope->GetLineNumber(),
+            to_string(nunreachable) + " unreachable block(s) removed");
+  }
+
+  return ncold;
+}
+
+bool CBlockLayout::IsLoopBranch(const CBasicBlock *bb)
+{
+  const CLoop *l = bb->GetLoop();
+  if (l == NULL) return false;
+
+  for (const auto &s : bb->GetSucc()) {
+    if ((s == l->GetHeader()) || !l->Contains(s)) return true;
+  }
+  return false;
+}
+
+bool CBlockLayout::IsUnlikely(const CBasicBlock *bb, string &reason)
+{
+  for (const auto &i : bb->GetInstr()) {
+    if (i->GetOperation() != opCall) continue;
+
+    const CTacName *fun = dynamic_cast<const CTacName*>(i->GetSrc(1));
+    string name = fun->GetSymbol()->GetName();
+    for (const auto &r : outputRoutine) {
+      if (name == r) {
+        reason = "calls " + name;
+        return true;
+      }
+    }
+  }
+
+  if (bb->GetLast()->GetOperation() == opReturn) {
+    reason = "returns early";
+    return true;
+  }
+
+  return false;
+}
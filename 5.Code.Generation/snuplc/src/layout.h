@@ -0,0 +1,73 @@
+//------------------------------------------------------------------------------
+/// @brief SnuPL basic block layout
+//------------------------------------------------------------------------------
+
+#ifndef __SnuPL_LAYOUT_H__
+#define __SnuPL_LAYOUT_H__
+
+#include <iostream>
+#include <vector>
+
+#include "ir.h"
+#include "cfg.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+/// @brief basic block layout
+///
+/// orders the basic blocks of each code block such that the likely path
+/// falls through. Branch probabilities are predicted statically:
+///  - loop branches (back edges and loop exits) follow the loop
+///  - an arm of a conditional branch that calls an output routine or
+///    returns early is unlikely, unless both arms are
+///  - blocks only reached from unlikely blocks are unlikely
+///
+/// Unlikely blocks are moved to the end of the code block (see
+/// CCodeBlock::GetColdCode()); the backend emits them into a separate
+/// section. Conditional branches that jump over an unconditional branch
+/// to the next block are inverted:
+///
+///     if a < b goto T             if a >= b goto F
+///     goto F             =>     T:
+///   T:
+///
+/// Unreachable blocks are removed. The pass runs right before code
+/// generation.
+///
+class CBlockLayout {
+  public:
+    /// @name constructor/destructor
+    /// @{
+
+    /// @brief constructor
+    /// @param m module
+    CBlockLayout(CModule *m);
+
+    /// @}
+
+    /// @brief lay out the code blocks of all scopes of the module
+    /// @retval int number of blocks moved out of line
+    int Run(void);
+
+    /// @brief lay out the code block of a single scope @a scope
+    /// @retval int number of blocks moved out of line
+    int Run(CScope *scope);
+
+  private:
+    /// @brief lay out the code block of @a scope
+    int Layout(CScope *scope);
+
+    /// @brief returns true if the conditional branch ending @a bb controls
+    ///        a loop (one of its edges is a back edge or leaves the loop)
+    static bool IsLoopBranch(const CBasicBlock *bb);
+
+    /// @brief returns true if @a bb is unlikely to be executed when it is
+    ///        the target of a conditional branch. The reason is returned
+    ///        in @a reason.
+    static bool IsUnlikely(const CBasicBlock *bb, string &reason);
+
+    CModule *_m;                    ///< module
+};
+
+#endif // __SnuPL_LAYOUT_H__
@@ -53,6 +53,12 @@ CParser::CParser(CScanner *scanner)
 {
   _scanner = scanner;
   _module = NULL;
+  _consumer = NULL;
+}
+
+void CParser::SetConsumer(CProcedureConsumer *consumer)
+{
+  _consumer = consumer;
 }
 
 CAstNode* CParser::Parse(void)
@@ -116,39 +122,52 @@ void CParser::InitSymbolTable(CSymtab *s)
 {
   CTypeManager *tm = CTypeManager::Get();
   CSymProc *fun;
+  set<int> param0;
+  param0.insert(0);
+
+  // the side effects of the runtime procedures are known: DIM and DOFS only
+  // read the array header, which never changes. They are thus pure.
 
   // function DIM(array: pointer to array; dim: integer): integer
   fun = new CSymProc("DIM", tm->GetInt());
   fun->AddParam(new CSymParam(0, "arr", tm->GetPointer(tm->GetNull())));
   fun->AddParam(new CSymParam(1, "dim", tm->GetInt()));
+  fun->SetSideEffects(seNone);
   s->AddSymbol(fun);
 
   // function DOFS(array: pointer to array): integer;
   fun = new CSymProc("DOFS", tm->GetInt());
   fun->AddParam(new CSymParam(0, "arr", tm->GetPointer(tm->GetNull())));
+  fun->SetSideEffects(seNone);
   s->AddSymbol(fun);
 
   // function ReadInt() : integer;
   fun = new CSymProc("ReadInt", tm->GetInt());
+  fun->SetSideEffects(seIO);
   s->AddSymbol(fun);
 
   // procedure WriteInt(i: integer);
   fun = new CSymProc("WriteInt", tm->GetNull());
   fun->AddParam(new CSymParam(0, "i", tm->GetInt()));
+  fun->SetSideEffects(seIO);
   s->AddSymbol(fun);
 
   // procedure WriteChar(c: char);
   fun = new CSymProc("WriteChar", tm->GetNull());
   fun->AddParam(new CSymParam(0, "c", tm->GetChar()));
+  fun->SetSideEffects(seIO);
   s->AddSymbol(fun);
 
   // procedure WriteStr(string: char[]);
   fun = new CSymProc("WriteStr", tm->GetNull());
   fun->AddParam(new CSymParam(0, "str", tm->GetPointer(tm->GetArray(CArrayType::OPEN, tm->GetChar()))));
+  fun->SetSideEffects(seIO | seReadParam, set<const CSymbol*>(),
+                      set<const CSymbol*>(), param0);
   s->AddSymbol(fun);
 
   // procedure WriteLn();
   fun = new CSymProc("WriteLn", tm->GetNull());
+  fun->SetSideEffects(seIO);
   s->AddSymbol(fun);
 }
 
@@ -206,6 +225,24 @@ CAstModule* CParser::module(void)
     Consume(tIdent);
     Consume(tSemicolon);
 
+    // hand the type-checked procedure to the consumer and free it. The
+    // parameters belong to the procedure symbol and survive.
+    if (_consumer != NULL) {
+      CToken et;
+      string msg;
+      if (!sub->TypeCheck(&et, &msg)) SetError(et, msg);
+
+      m->RemoveChild(sub);
+      _consumer->Procedure(m, sub);
+
+      CSymProc *proc = sub->GetSymbol();
+      for (int p=0; p<proc->GetNParams(); p++) {
+        CSymbol *param = const_cast<CSymParam*>(proc->GetParam(p));
+        sub->GetSymbolTable()->RemoveSymbol(param);
+      }
+      delete sub;
+    }
+
     tt = _scanner->Peek().GetType();
   }
 
@@ -500,13 +537,15 @@ CAstStatement* CParser::statSequence(CAstScope *s)
   //
   // stateSequence ::= [ statement { ";" statement } ].
   // statement ::= assignment | subroutineCall
-  //             | ifStatement | whileStatement | returnStatement.
+  //             | ifStatement | whileStatement | caseStatement
+  //             | returnStatement.
   //
   CAstStatement *head = NULL;
   CAstStatement *tail = NULL;
 
   CToken tt = _scanner->Peek();
-  while (!_abort && tt.GetType() != kEnd && tt.GetType() != kElse) {
+  while (!_abort && tt.GetType() != kEnd && tt.GetType() != kElse &&
+         tt.GetType() != tBar) {
     CAstStatement *st = NULL;
 
     // stateSequence -> ... statement ...
@@ -517,6 +556,15 @@ CAstStatement* CParser::statSequence(CAstScope *s)
         {
           const CSymbol *sym = s->GetSymbolTable()->FindSymbol(tt.GetValue(), sLocal);
           if (!sym) sym = s->GetSymbolTable()->FindSymbol(tt.GetValue(), sGlobal);
+
+          // statement -> caseStatement
+          // "case" is not a reserved keyword (existing programs use it as a
+          // name); it starts a case statement unless it is declared
+          if (!sym && (tt.GetValue() == "case")) {
+            st = caseStatement(s);
+            break;
+          }
+
           if (!sym) SetError(tt, "undeclared variable \"" + tt.GetValue() + "\"");
 
           ESymbolType stype = sym->GetSymbolType();
@@ -553,7 +601,8 @@ CAstStatement* CParser::statSequence(CAstScope *s)
     tail = st;
 
     tt = _scanner->Peek();
-    if (tt.GetType() == kEnd || tt.GetType() == kElse) break;
+    if (tt.GetType() == kEnd || tt.GetType() == kElse ||
+        tt.GetType() == tBar) break;
 
     // stateSequence -> ... ";" ...
     Consume(tSemicolon);
@@ -674,6 +723,80 @@ CAstStatWhile* CParser::whileStatement(CAstScope *s)
   return new CAstStatWhile(t, cond, body);
 }
 
+CAstStatCase* CParser::caseStatement(CAstScope *s)
+{
+  //
+  // caseStatement ::= "case" "(" expression ")" "of" caseArm { "|" caseArm }
+  //                   [ "else" stateSequence ] "end".
+  // caseArm ::= caseLabel { "," caseLabel } ":" stateSequence.
+  // caseLabel ::= caseConstant [ ".." caseConstant ].
+  //
+  CToken t;
+
+  // caseStatement -> "case" "(" expression ")" "of" ...
+  // neither "case" nor "of" are reserved keywords
+  Consume(tIdent, &t);
+  Consume(tLParen);
+  CAstStatCase *cs = new CAstStatCase(t, expression(s));
+  Consume(tRParen);
+
+  CToken of;
+  if (Consume(tIdent, &of) && (of.GetValue() != "of"))
+    SetError(of, "expected 'of', got '" + of.GetValue() + "'");
+
+  // caseStatement -> ... caseArm { "|" caseArm } ...
+  do {
+    if (_scanner->Peek().GetType() == tBar) Consume(tBar);
+
+    vector<CAstStatCase::CaseLabel> labels;
+    do {
+      if (labels.size() > 0) Consume(tComma);
+
+      CAstConstant *low = caseConstant(), *high = NULL;
+      if (_scanner->Peek().GetType() == tRange) {
+        Consume(tRange);
+        high = caseConstant();
+      }
+      labels.push_back(make_pair(low, high));
+    } while (!_abort && (_scanner->Peek().GetType() == tComma));
+
+    Consume(tColon);
+    cs->AddArm(labels, statSequence(s));
+  } while (!_abort && (_scanner->Peek().GetType() == tBar));
+
+  // caseStatement -> ... [ "else" stateSequence ] "end"
+  if (_scanner->Peek().GetType() == kElse) {
+    Consume(kElse);
+    cs->SetElseBody(statSequence(s));
+  }
+  Consume(kEnd);
+
+  return cs;
+}
+
+CAstConstant* CParser::caseConstant(void)
+{
+  //
+  // caseConstant ::= [ "+" | "-" ] number | character.
+  //
+  CToken t = _scanner->Peek();
+
+  if (t.GetType() == tChar) return character();
+
+  // caseConstant -> [ "+" | "-" ] ...
+  bool neg = false;
+  if (t.GetType() == tPlusMinus) {
+    Consume(tPlusMinus);
+    neg = (t.GetValue() == "-");
+  }
+
+  // caseConstant -> ... number
+  CAstConstant *c = number();
+  if (neg) c->SetValue(-c->GetValue());
+
+  return c;
+}
+
 CAstStatReturn* CParser::returnStatement(CAstScope *s)
 {
   //
@@ -687,7 +810,7 @@ CAstStatReturn* CParser::returnStatement(CAstScope *s)
 
   // returnStatement -> ... expression
   EToken tt = _scanner->Peek().GetType();
-  if (tt != kEnd && tt != tSemicolon && tt != kElse)
+  if (tt != kEnd && tt != tSemicolon && tt != kElse && tt != tBar)
     expr = expression(s);
 
   return new CAstStatReturn(t, s, expr);
@@ -794,12 +917,18 @@ CAstExpression* CParser::term(CAstScope *s)
   CAstExpression *n = factor(s);
 
   for (CToken t = _scanner->Peek(); ; t = _scanner->Peek()) {
-    // factOp -> "*" | "/" | "&&"
+    // factOp -> "*" | "/" | "mod" | "&&"
+    // "mod" is not a reserved keyword (existing programs use it as a name);
+    // an identifier can never follow a factor, so here it is the operator
     EOperation eop;
     if (t.GetValue() == "&&") {
       Consume(tAndOr, &t);
       eop = opAnd;
     }
+    else if ((t.GetType() == tIdent) && (t.GetValue() == "mod")) {
+      Consume(tIdent, &t);
+      eop = opMod;
+    }
     else if (t.GetType() == tMulDiv) {
       Consume(tMulDiv, &t);
       eop = t.GetValue() == "*" ? opMul : opDiv;
@@ -41,6 +41,23 @@
 #include "ast.h"
 
 
+//------------------------------------------------------------------------------
+/// @brief procedure consumer
+///
+/// receives the procedures of a module one by one while the module is
+/// being parsed (see CParser::SetConsumer())
+///
+class CProcedureConsumer {
+  public:
+    virtual ~CProcedureConsumer(void) {};
+
+    /// @brief called for each procedure @a proc of module @a m as soon as it
+    ///        has been parsed and type-checked. @a proc is no longer a child
+    ///        of @a m and is deleted by the parser when the call returns.
+    virtual void Procedure(CAstModule *m, CAstProcedure *proc) = 0;
+};
+
+
 //------------------------------------------------------------------------------
 /// @brief parser
 ///
@@ -57,6 +74,12 @@ class CParser {
     /// @retval CAstNode program node
     CAstNode* Parse(void);
 
+    /// @brief set the consumer of the procedures (NULL: none). With a
+    ///        consumer, the parser hands each procedure to the consumer and
+    ///        frees it; the module returned by Parse() contains the global
+    ///        symbols and the module body only.
+    void SetConsumer(CProcedureConsumer *consumer);
+
     /// @name error handling
     ///@{
 
@@ -180,6 +203,15 @@ class CParser {
     /// @retval CAstStatWhile which represents this while statement
     CAstStatWhile*        whileStatement(CAstScope *s);
 
+    /// @brief build up AST case statement node by case statement
+    /// @param s AST scope node which owns this case statement
+    /// @retval CAstStatCase which represents this case statement
+    CAstStatCase*         caseStatement(CAstScope *s);
+
+    /// @brief build up AST constant node by case label constant
+    /// @retval CAstConstant which represents this case label constant
+    CAstConstant*         caseConstant(void);
+
     /// @brief build up AST return statement node by return statement
     /// @param s AST scope node which owns this return statement
     /// @retval CAstStatReturn which represents this return statement
@@ -247,6 +279,7 @@ class CParser {
 
     CScanner     *_scanner;       ///< CScanner instance
     CAstModule   *_module;        ///< root node of the program
+    CProcedureConsumer *_consumer;///< consumer of the procedures
     CToken        _token;         ///< current token
 
     /// @name error handling
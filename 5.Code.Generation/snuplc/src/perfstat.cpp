@@ -0,0 +1,118 @@
+//------------------------------------------------------------------------------
+/// @brief run a program and measure wall time and instructions retired
+//------------------------------------------------------------------------------
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+using namespace std;
+
+//------------------------------------------------------------------------------
+// runs a command with the standard streams of the caller and reports
+//
+//   time <wall time in seconds>
+//   instructions <user-level instructions retired | n/a>
+//   status <exit code of the command>
+//
+// Instructions are counted with perf_event_open(2); if the kernel does not
+// support it (or perf_event_paranoid forbids it), "n/a" is reported.
+//
+
+/// @brief open an instruction counter for process @a pid (-1 on failure)
+static int OpenCounter(pid_t pid)
+{
+  struct perf_event_attr attr;
+
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+  attr.disabled = 1;
+  attr.enable_on_exec = 1;
+  attr.inherit = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+
+  return syscall(__NR_perf_event_open, &attr, pid, -1, -1, 0);
+}
+
+void Syntax(void)
+{
+  cerr << "Usage: perfstat [-o FILE] COMMAND [ARGS...]" << endl
+       << "Run COMMAND and report its wall time and instructions retired to"
+       << endl << "FILE (default: stderr)." << endl;
+  exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+  const char *outfile = NULL;
+  int arg = 1;
+
+  if ((argc > 2) && (strcmp(argv[1], "-o") == 0)) {
+    outfile = argv[2];
+    arg = 3;
+  }
+  if (arg >= argc) Syntax();
+
+  // the child waits until the counter is attached before it runs the command
+  int go[2];
+  if (pipe(go) < 0) { perror("pipe"); return EXIT_FAILURE; }
+
+  pid_t pid = fork();
+  if (pid < 0) { perror("fork"); return EXIT_FAILURE; }
+
+  if (pid == 0) {
+    char c;
+    close(go[1]);
+    if (read(go[0], &c, 1) < 0) _exit(127);
+    close(go[0]);
+    execvp(argv[arg], &argv[arg]);
+    perror(argv[arg]);
+    _exit(127);
+  }
+
+  close(go[0]);
+  int fd = OpenCounter(pid);
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  if (write(go[1], "x", 1) < 0) perror("write");
+  close(go[1]);
+
+  int status;
+  while (waitpid(pid, &status, 0) < 0) {
+    if (errno != EINTR) { perror("waitpid"); return EXIT_FAILURE; }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  long long instructions = -1;
+  if ((fd >= 0) && (read(fd, &instructions, sizeof(instructions)) !=
+                    sizeof(instructions))) {
+    instructions = -1;
+  }
+
+  ofstream file;
+  if (outfile != NULL) file.open(outfile);
+  ostream &out = outfile != NULL ? file : cerr;
+
+  out << "time " << (end.tv_sec - start.tv_sec) +
+                    (end.tv_nsec - start.tv_nsec) / 1e9 << endl;
+  out << "instructions ";
+  if (instructions >= 0) out << instructions; else out << "n/a";
+  out << endl;
+  out << "status " << (WIFEXITED(status) ? WEXITSTATUS(status)
+                                          : 128 + WTERMSIG(status)) << endl;
+
+  return EXIT_SUCCESS;
+}
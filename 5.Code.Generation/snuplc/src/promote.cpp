@@ -0,0 +1,284 @@
+//------------------------------------------------------------------------------
+/// @brief SnuPL scalar promotion
+//------------------------------------------------------------------------------
+
+#include <cassert>
+#include <sstream>
+
+#include "promote.h"
+#include "remarks.h"
+using namespace std;
+
+
+//------------------------------------------------------------------------------
+// CScalarPromotion
+//
+// promotion costs a load on entry and a store per exit; globals accessed
+// less than MinAccesses times in a loop are not promoted
+//
+static const int MinAccesses = 2;
+
+CScalarPromotion::CScalarPromotion(CModule *m)
+  : _m(m)
+{
+  assert(m != NULL);
+}
+
+int CScalarPromotion::Run(void)
+{
+  int n = Promote(_m);
+  for (const auto &s : _m->GetSubscopes()) n += Promote(s);
+  return n;
+}
+
+int CScalarPromotion::Run(CScope *scope)
+{
+  return Promote(scope);
+}
+
+int CScalarPromotion::Promote(CScope *scope)
+{
+  CCodeBlock *cb = scope->GetCodeBlock();
+  SEdits edits;
+  int n = 0;
+
+  // the register already holds a value in the whole scope
+  if (scope->GetRegisterCandidates().size() > 0) return 0;
+
+  // loops need a branch back to a label defined before it; scopes without
+  // one are not worth building the control flow graph for
+  set<const CTac*> labels;
+  bool backward = false;
+  for (const auto &i : cb->GetInstr()) {
+    if (i->GetOperation() == opLabel) labels.insert(i);
+    else if (i->IsBranch() && (labels.count(i->GetDest()) > 0)) backward = true;
+    else if (i->GetOperation() == opSwitch) backward = true;
+    if (backward) break;
+  }
+  if (!backward) return 0;
+
+  {
+    CCfg cfg(cb);
+    for (const auto &l : cfg.GetLoops()) {
+      if (l->GetParent() == NULL) n += Promote(scope, cfg, l, edits);
+    }
+  }
+  if (n == 0) return 0;
+
+  list<CTacInstr*> code;
+  for (const auto &i : cb->GetInstr()) {
+    if (edits.before.find(i) != edits.before.end()) {
+      for (const auto &b : edits.before[i]) code.push_back(b);
+    }
+    if (edits.replace.find(i) != edits.replace.end()) {
+      code.push_back(edits.replace[i]);
+    } else {
+      code.push_back(i);
+    }
+    if (edits.after.find(i) != edits.after.end()) {
+      for (const auto &a : edits.after[i]) code.push_back(a);
+    }
+  }
+  for (const auto &r : edits.replace) delete r.first;
+
+  cb->SetInstr(code);
+
+  return n;
+}
+
+int CScalarPromotion::Promote(CScope *scope, const CCfg &cfg,
+                              const CLoop *loop, SEdits &edits)
+{
+  CRemarks *rm = CRemarks::Get();
+  int line = loop->GetHeader()->GetLineNumber();
+
+  // integer globals accessed in the loop and the procedures it calls
+  vector<const CSymbol*> globals;
+  map<const CSymbol*, int> count;
+  map<const CSymbol*, set<CTacInstr*> > users;
+  set<const CSymbol*> written;
+  vector<const CSymProc*> calls;
+
+  for (const auto &bb : loop->GetBlocks()) {
+    for (const auto &i : bb->GetInstr()) {
+      if (i->GetOperation() == opCall) {
+        const CTacName *fun = dynamic_cast<const CTacName*>(i->GetSrc(1));
+        calls.push_back(dynamic_cast<const CSymProc*>(fun->GetSymbol()));
+      }
+
+      const CTacSelect *sel = dynamic_cast<const CTacSelect*>(i);
+      const CTac *ops[] = { i->GetDest(), i->GetSrc(1), i->GetSrc(2),
+                            sel != NULL ? sel->GetLeft() : NULL,
+                            sel != NULL ? sel->GetRight() : NULL };
+
+      for (size_t k=0; k<sizeof(ops)/sizeof(ops[0]); k++) {
+        const CTacName *n = dynamic_cast<const CTacName*>(ops[k]);
+        if ((n == NULL) || (dynamic_cast<const CTacReference*>(n) != NULL))
+          continue;
+
+        const CSymbol *s = n->GetSymbol();
+        if ((s->GetSymbolType() != stGlobal) || !s->GetDataType()->IsInt())
+          continue;
+
+        if (count[s]++ == 0) globals.push_back(s);
+        if (k == 0) written.insert(s);
+        users[s].insert(i);
+      }
+    }
+  }
+
+  // the most frequently accessed global that no call accesses
+  const CSymbol *best = NULL;
+  for (const auto &g : globals) {
+    if (count[g] < MinAccesses) continue;
+
+    const CSymProc *callee = NULL;
+    for (const auto &c : calls) {
+      if ((c->ReadsGlobal(g) || c->WritesGlobal(g)) && (callee == NULL))
+        callee = c;
+    }
+    if (callee != NULL) {
+      rm->Add(rkMissed, "promote", scope->GetDisplayName(), line,
+              "global '" + g->GetName() + "' not promoted: call to '" +
+              callee->GetName() + "' may access it");
+      continue;
+    }
+
+    if ((best == NULL) || (count[g] > count[best])) best = g;
+  }
+
+  vector<pair<CTacInstr*, bool> > load, store;
+  if ((best != NULL) &&
+      !FindEdges(cfg, loop, written.count(best) > 0, load, store)) {
+    rm->Add(rkMissed, "promote", scope->GetDisplayName(), line,
+            "global '" + best->GetName() + "' not promoted: the loop is "
+            "entered or left by a branch that cannot take the load or store");
+    best = NULL;
+  }
+
+  if (best == NULL) {
+    int n = 0;
+    for (const auto &l : loop->GetSubloops()) {
+      n += Promote(scope, cfg, l, edits);
+    }
+    return n;
+  }
+
+  // rename the global in the loop; stores precede loads at the same point
+  // since the temporaries of all loops share a register
+  CTacTemp *t = scope->CreateTemp(best->GetDataType());
+  const CSymbol *ts = t->GetSymbol();
+  map<const CSymbol*, const CSymbol*> rename;
+  rename[best] = ts;
+
+  for (const auto &i : users[best]) {
+    edits.replace[i] = CCodeBlock::CopyInstr(i, rename);
+  }
+
+  for (const auto &p : load) {
+    CTacInstr *ld = new CTacInstr(opAssign, new CTacTemp(ts),
+                                  new CTacName(best));
+    vector<CTacInstr*> &v = p.second ? edits.after[p.first]
+                                     : edits.before[p.first];
+    v.push_back(ld);
+  }
+  for (const auto &p : store) {
+    CTacInstr *st = new CTacInstr(opAssign, new CTacName(best),
+                                  new CTacTemp(ts));
+    vector<CTacInstr*> &v = p.second ? edits.after[p.first]
+                                     : edits.before[p.first];
+    v.insert(v.begin(), st);
+  }
+
+  scope->AddRegisterCandidate(ts);
+
+  ostringstream msg;
+  msg << "global '" << best->GetName() << "' kept in a register in the loop ("
+      << count[best] << " accesses, " << load.size() << " load(s), "
+      << store.size() << " store(s))";
+  rm->Add(rkPassed, "promote", scope->GetDisplayName(), line, msg.str());
+
+  return 1;
+}
+
+bool CScalarPromotion::FindEdges(const CCfg &cfg, const CLoop *loop,
+                                 bool written,
+                                 vector<pair<CTacInstr*, bool> > &load,
+                                 vector<pair<CTacInstr*, bool> > &store) const
+{
+  const vector<CBasicBlock*> &blocks = cfg.GetBlocks();
+  const CBasicBlock *h = loop->GetHeader();
+
+  // entry edges: at the end of the predecessor, before its branch. A
+  // predecessor that branches into the loop or elsewhere would require
+  // splitting the edge.
+  for (const auto &p : h->GetPred()) {
+    if (!p->IsReachable() || loop->Contains(p)) continue;
+
+    CTacInstr *last = p->GetLast();
+    if (last->GetOperation() == opSwitch) {
+      return false;
+    } else if (p->GetSucc().size() == 1) {
+      load.push_back(make_pair(last, !last->IsBranch()));
+    } else if (cfg.GetBlock(dynamic_cast<CTacLabel*>(last->GetDest())) != h) {
+      load.push_back(make_pair(last, true));
+    } else {
+      return false;
+    }
+  }
+
+  if (!written) return true;
+
+  // exit edges: at the start of exit blocks only entered from the loop,
+  // otherwise on the fall-through edge. Returns in the loop store the value
+  // before returning.
+  set<const CBasicBlock*> done;
+  for (const auto &bb : loop->GetBlocks()) {
+    CTacInstr *last = bb->GetLast();
+    EOperation op = last->GetOperation();
+
+    if (op == opReturn) {
+      store.push_back(make_pair(last, false));
+      continue;
+    }
+
+    vector<pair<const CBasicBlock*, bool> > exits;
+    if (last->IsBranch()) {
+      const CBasicBlock *t = cfg.GetBlock(dynamic_cast<CTacLabel*>(last->GetDest()));
+      if (!loop->Contains(t)) exits.push_back(make_pair(t, true));
+    }
+    if (op == opSwitch) {
+      for (const auto &l : dynamic_cast<CTacSwitch*>(last)->GetTargets()) {
+        const CBasicBlock *t = cfg.GetBlock(l);
+        if (!loop->Contains(t)) exits.push_back(make_pair(t, true));
+      }
+    }
+    if (op != opGoto) {
+      size_t f = bb->GetId() + 1;
+      const CBasicBlock *next = f < blocks.size() ? blocks[f] : NULL;
+      if (!loop->Contains(next)) exits.push_back(make_pair(next, false));
+    }
+
+    for (const auto &e : exits) {
+      bool inside = e.first != NULL;
+      if (inside) {
+        for (const auto &p : e.first->GetPred()) {
+          if (p->IsReachable() && !loop->Contains(p)) inside = false;
+        }
+      }
+
+      if (inside) {
+        if (done.insert(e.first).second) {
+          CTacInstr *first = e.first->GetInstr().front();
+          store.push_back(make_pair(first, first->GetOperation() == opLabel));
+        }
+      } else if (!e.second) {
+        store.push_back(make_pair(last, true));
+      } else {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,86 @@
+//------------------------------------------------------------------------------
+/// @brief SnuPL scalar promotion
+//------------------------------------------------------------------------------
+
+#ifndef __SnuPL_PROMOTE_H__
+#define __SnuPL_PROMOTE_H__
+
+#include <iostream>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "ir.h"
+#include "cfg.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+/// @brief scalar promotion of globals in loops
+///
+/// replaces the accesses to an integer global inside a loop by accesses to
+/// a new temporary. The temporary is loaded from the global on the edges
+/// entering the loop and, if the loop writes the global, stored back on the
+/// edges leaving it (and before returns in the loop):
+///
+///     goto C                      t <- g
+///   B:                            goto C
+///     g <- g + 1         =>     B:
+///   C:                            t <- t + 1
+///     if g < n goto B           C:
+///                                 if t < n goto B
+///                                 g <- t
+///
+/// A global is only promoted if none of the calls in the loop reads or
+/// writes it (see CSymProc::ReadsGlobal()). Scalars are passed by value, so
+/// globals cannot be accessed through references.
+/// The backend keeps the temporary in a register; since there is only one
+/// register available, at most one global is promoted per loop nest, the
+/// most frequently accessed one of the outermost loop that has a candidate.
+///
+class CScalarPromotion {
+  public:
+    /// @name constructor/destructor
+    /// @{
+
+    /// @brief constructor
+    /// @param m module
+    CScalarPromotion(CModule *m);
+
+    /// @}
+
+    /// @brief promote globals in the loops of all scopes of the module
+    /// @retval int number of promoted globals
+    int Run(void);
+
+    /// @brief promote globals in the loops of a single scope @a scope
+    /// @retval int number of promoted globals
+    int Run(CScope *scope);
+
+  private:
+    /// @brief instructions to insert and replace in a code block
+    struct SEdits {
+      map<const CTacInstr*, vector<CTacInstr*> > before;
+      map<const CTacInstr*, vector<CTacInstr*> > after;
+      map<const CTacInstr*, CTacInstr*> replace;
+    };
+
+    /// @brief promote globals in the loops of @a scope
+    int Promote(CScope *scope);
+
+    /// @brief promote a global in @a loop or, if there is none, in its
+    ///        subloops
+    int Promote(CScope *scope, const CCfg &cfg, const CLoop *loop,
+                SEdits &edits);
+
+    /// @brief find the points where the promoted value has to be loaded
+    ///        (@a load) and stored (@a store). Returns false if an edge
+    ///        cannot be handled without splitting it.
+    bool FindEdges(const CCfg &cfg, const CLoop *loop, bool written,
+                   vector<pair<CTacInstr*, bool> > &load,
+                   vector<pair<CTacInstr*, bool> > &store) const;
+
+    CModule *_m;                    ///< module
+};
+
+#endif // __SnuPL_PROMOTE_H__
@@ -0,0 +1,151 @@
+//------------------------------------------------------------------------------
+/// @brief SnuPL optimization remarks
+//------------------------------------------------------------------------------
+
+#include <cassert>
+#include <sstream>
+
+#include "remarks.h"
+using namespace std;
+
+
+//------------------------------------------------------------------------------
+// ERemarkKind
+//
+ostream& operator<<(ostream &out, ERemarkKind k)
+{
+  switch (k) {
+    case rkPassed:   out << "passed"; break;
+    case rkMissed:   out << "missed"; break;
+    case rkAnalysis: out << "analysis"; break;
+  }
+  return out;
+}
+
+
+//------------------------------------------------------------------------------
+// CRemark
+//
+CRemark::CRemark(ERemarkKind kind, const string pass, const string function,
+                 int line, const string message)
+  : _kind(kind), _pass(pass), _function(function), _line(line),
+    _message(message)
+{
+}
+
+
+//------------------------------------------------------------------------------
+// CRemarks
+//
+CRemarks* CRemarks::_global_rm = NULL;
+
+CRemarks::CRemarks(void)
+  : _filter(0)
+{
+}
+
+CRemarks* CRemarks::Get(void)
+{
+  if (_global_rm == NULL) _global_rm = new CRemarks();
+
+  return _global_rm;
+}
+
+void CRemarks::SetFilter(int kinds)
+{
+  _filter = kinds;
+}
+
+int CRemarks::GetFilter(void) const
+{
+  return _filter;
+}
+
+bool CRemarks::IsEnabled(ERemarkKind kind) const
+{
+  return (_filter & kind) != 0;
+}
+
+bool CRemarks::ParseFilter(const string spec, int &kinds)
+{
+  kinds = 0;
+
+  size_t pos = 0;
+  while (pos <= spec.size()) {
+    size_t end = spec.find_first_of("|,", pos);
+    if (end == string::npos) end = spec.size();
+    string k = spec.substr(pos, end - pos);
+
+    if (k == "passed") kinds |= rkPassed;
+    else if (k == "missed") kinds |= rkMissed;
+    else if (k == "analysis") kinds |= rkAnalysis;
+    else if (k == "all") kinds |= rkPassed | rkMissed | rkAnalysis;
+    else return false;
+
+    pos = end + 1;
+  }
+
+  return kinds != 0;
+}
+
+void CRemarks::Add(ERemarkKind kind, const string pass, const string function,
+                   int line, const string message)
+{
+  if (!IsEnabled(kind)) return;
+
+  _remarks.push_back(CRemark(kind, pass, function, line, message));
+}
+
+const vector<CRemark>& CRemarks::GetRemarks(void) const
+{
+  return _remarks;
+}
+
+void CRemarks::Clear(void)
+{
+  _remarks.clear();
+}
+
+ostream& CRemarks::print(ostream &out, const string file) const
+{
+  for (const auto &r : _remarks) {
+    out << file << ":" << r.GetLineNumber() << ": remark[" << r.GetKind()
+        << "]: " << r.GetFunction() << ": " << r.GetPass() << ": "
+        << r.GetMessage() << endl;
+  }
+
+  return out;
+}
+
+ostream& CRemarks::toYAML(ostream &out, const string file) const
+{
+  for (const auto &r : _remarks) {
+    string kind;
+    switch (r.GetKind()) {
+      case rkPassed:   kind = "Passed"; break;
+      case rkMissed:   kind = "Missed"; break;
+      case rkAnalysis: kind = "Analysis"; break;
+    }
+
+    out << "--- !" << kind << endl
+        << "Pass:            " << Quote(r.GetPass()) << endl
+        << "DebugLoc:        { File: " << Quote(file)
+        << ", Line: " << r.GetLineNumber() << " }" << endl
+        << "Function:        " << Quote(r.GetFunction()) << endl
+        << "Message:         " << Quote(r.GetMessage()) << endl
+        << "..." << endl;
+  }
+
+  return out;
+}
+
+string CRemarks::Quote(const string s)
+{
+  // single-quoted YAML scalar: the only escape is '' for '
+  string q = "'";
+  for (char c : s) {
+    if (c == '\'') q += "''";
+    else q += c;
+  }
+  return q + "'";
+}
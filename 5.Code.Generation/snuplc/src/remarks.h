@@ -0,0 +1,149 @@
+//------------------------------------------------------------------------------
+/// @brief SnuPL optimization remarks
+//------------------------------------------------------------------------------
+
+#ifndef __SnuPL_REMARKS_H__
+#define __SnuPL_REMARKS_H__
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+/// @brief remark kinds
+///
+/// the values can be combined into a filter mask (see CRemarks::SetFilter)
+///
+enum ERemarkKind {
+  rkPassed   = 1,                   ///< a transformation was applied
+  rkMissed   = 2,                   ///< a transformation was not applied
+  rkAnalysis = 4,                   ///< analysis result
+};
+
+/// @brief ERemarkKind output operator
+///
+/// @param out output stream
+/// @param k ERemarkKind
+/// @retval output stream
+ostream& operator<<(ostream &out, ERemarkKind k);
+
+
+//------------------------------------------------------------------------------
+/// @brief optimization remark
+///
+/// a single message of a pass about a procedure and a source line
+///
+class CRemark {
+  public:
+    /// @name constructor/destructor
+    /// @{
+
+    /// @brief constructor
+    /// @param kind remark kind
+    /// @param pass name of the pass issuing the remark
+    /// @param function name of the procedure/module the remark refers to
+    /// @param line source line (0 if unknown)
+    /// @param message remark text
+    CRemark(ERemarkKind kind, const string pass, const string function,
+            int line, const string message);
+
+    /// @}
+
+    /// @name properties
+    /// @{
+
+    ERemarkKind GetKind(void) const { return _kind; };
+    string GetPass(void) const { return _pass; };
+    string GetFunction(void) const { return _function; };
+    int GetLineNumber(void) const { return _line; };
+    string GetMessage(void) const { return _message; };
+
+    /// @}
+
+  private:
+    ERemarkKind _kind;              ///< kind
+    string _pass;                   ///< pass name
+    string _function;               ///< procedure name
+    int _line;                      ///< source line
+    string _message;                ///< message
+};
+
+
+//------------------------------------------------------------------------------
+/// @brief remark collector
+///
+/// global collector for optimization remarks. Passes check IsEnabled() before
+/// composing a message so that disabled remarks cost nothing.
+///
+class CRemarks {
+  public:
+    /// @brief return the global remark collector
+    static CRemarks* Get(void);
+
+    /// @name filtering
+    /// @{
+
+    /// @brief set the kinds of remarks to collect (bitmask of ERemarkKind)
+    void SetFilter(int kinds);
+
+    /// @brief return the kinds of remarks collected
+    int GetFilter(void) const;
+
+    /// @brief returns true if remarks of @a kind are collected
+    bool IsEnabled(ERemarkKind kind) const;
+
+    /// @brief parse a filter specification of the form "passed|missed"
+    /// @param spec kinds separated by '|' or ','; "all" selects all kinds
+    /// @param kinds resulting filter mask
+    /// @retval true if the specification is valid
+    static bool ParseFilter(const string spec, int &kinds);
+
+    /// @}
+
+    /// @name remark handling
+    /// @{
+
+    /// @brief add a remark (ignored if @a kind is not enabled)
+    void Add(ERemarkKind kind, const string pass, const string function,
+             int line, const string message);
+
+    /// @brief return all collected remarks
+    const vector<CRemark>& GetRemarks(void) const;
+
+    /// @brief discard all collected remarks
+    void Clear(void);
+
+    /// @}
+
+    /// @name output
+    /// @{
+
+    /// @brief print the remarks in textual form
+    /// @param out output stream
+    /// @param file source file name
+    ostream& print(ostream &out, const string file) const;
+
+    /// @brief print the remarks as a YAML document stream
+    /// @param out output stream
+    /// @param file source file name
+    ostream& toYAML(ostream &out, const string file) const;
+
+    /// @}
+
+  private:
+    /// @brief constructor
+    CRemarks(void);
+
+    /// @brief quote a string for YAML output
+    static string Quote(const string s);
+
+    int _filter;                    ///< enabled remark kinds
+    vector<CRemark> _remarks;       ///< collected remarks
+
+    static CRemarks *_global_rm;    ///< global remark collector instance
+};
+
+
+#endif // __SnuPL_REMARKS_H__
@@ -79,6 +79,8 @@ char ETokenName[][TOKEN_STRLEN] = {
   "tColon",                         ///< a colon
   "tComma",                         ///< a comma
   "tDot",                           ///< a dot
+  "tRange",                         ///< a range ('..')
+  "tBar",                           ///< a bar ('|')
   "tLBrak",                         ///< a left bracket
   "tRBrak",                         ///< a right bracket
   "tLParen",                        ///< a left paren
@@ -124,6 +126,8 @@ char ETokenStr[][TOKEN_STRLEN] = {
   "tColon",                         ///< a colon
   "tComma",                         ///< a comma
   "tDot",                           ///< a dot
+  "tRange",                         ///< a range ('..')
+  "tBar",                           ///< a bar ('|')
   "tLBrak",                         ///< a left bracket
   "tRBrak",                         ///< a right bracket
   "tLParen",                        ///< a left paren
@@ -401,6 +405,8 @@ CToken* CScanner::Scan()
         tokval += GetChar();
         token = tAndOr;
       }
+      else if (c == '|')
+        token = tBar;
       break;
 
     case '!':
@@ -430,7 +436,12 @@ CToken* CScanner::Scan()
       break;
 
     case '.':
-      token = tDot;
+      if (_in->good() && (_in->peek() == '.')) {
+        tokval += GetChar();
+        token = tRange;
+      }
+      else
+        token = tDot;
       break;
 
     case '\'':
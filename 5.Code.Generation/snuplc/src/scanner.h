@@ -78,6 +78,8 @@ enum EToken {
   tColon,                           ///< a colon
   tComma,                           ///< a comma
   tDot,                             ///< a dot
+  tRange,                           ///< a range ('..')
+  tBar,                             ///< a bar ('|')
   tLBrak,                           ///< a left bracket
   tRBrak,                           ///< a right bracket
   tLParen,                          ///< a left paren
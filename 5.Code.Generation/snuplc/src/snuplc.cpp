@@ -35,25 +35,62 @@
 #include <cassert>
 #include <cstring>
 #include <cstdlib>
+#include <cstdio>
 #include <iostream>
 #include <fstream>
+#include <iomanip>
 #include <vector>
+#include <chrono>
+#include <sys/resource.h>
 
 #include "scanner.h"
 #include "parser.h"
 #include "ir.h"
+#include "ipa.h"
+#include "interp.h"
+#include "spec.h"
+#include "ifconv.h"
+#include "promote.h"
+#include "layout.h"
 #include "backend.h"
+#include "remarks.h"
+#include "cost.h"
+#include "jobs.h"
 using namespace std;
 
 
 bool dump_ast = false;
 bool dump_tac = false;
 bool dump_asm = true;
+bool asm_comments = true;
 bool dump_dot = true;
 bool run_dot  = true;
 bool run_gcc  = false;
+int max_jobs  = 0;
+bool profile  = false;
+string profile_file = "";
+bool memoize = false;
+// optimizations: off by default, enabled by --optimize unless set explicitly
+// (-1: not set, 0: off, 1: on)
+bool optimize = false;
+int fold_calls = -1;
+int specialize = -1;
+int global_analysis = -1;
+int if_convert = -1;
+int promote = -1;
+int block_layout = -1;
+int dead_proc_elim = -1;
+int icf = -1;
+int ipra = -1;
+int regcall = -1;
+int accumulate = -1;
+int remarks = 0;
+bool cost_report = false;
+bool time_phases = false;
+bool stream = false;
 string rte_path = "rte/IA32/";
 vector<string> files;
+CJobQueue *jobs = NULL;
 
 
 void Syntax(string msg)
@@ -69,8 +106,51 @@ void Syntax(string msg)
        << "  --tac          output the IR in textual/graphical form. Default: off" << endl
        << "  --exe          generate executable from compiled assembly file. Default: off" << endl
        << "  --no-asm       output assembly code to console instead of a file. Default: file" << endl
+       << "  --no-asm-comments" << endl
+       << "                 do not annotate the assembly code with the IR. Default: annotate" << endl
        << "  --no-dot       do not output the AST/IR in graphical form. Default: output in graphical form" << endl
        << "  --no-run-dot   do not run the dot command automatically. Default: run automatically" << endl
+       << "  --jobs <n>     run at most <n> dot/gcc commands in the background. Default:" << endl
+       << "                 number of processors" << endl
+       << "  --profile      instrument procedures to print a flat profile at exit. Default: off" << endl
+       << "  --profile-file <file>" << endl
+       << "                 like --profile, but write the profile to <file>. Default: stderr" << endl
+       << "  --optimize     enable all of the optimizations below. Each of them can also be" << endl
+       << "                 enabled on its own, or disabled with its --no-/--keep-/--push-" << endl
+       << "                 form when combined with --optimize. Default: off" << endl
+       << "  --fold-calls   evaluate calls to pure functions with constant arguments at" << endl
+       << "                 compile time" << endl
+       << "  --specialize   specialize procedures for constant arguments and known array" << endl
+       << "                 shapes" << endl
+       << "  --global-analysis" << endl
+       << "                 fold globals that are never written or written once with a" << endl
+       << "                 constant at the start of the module body, and load a global that" << endl
+       << "                 a procedure does not write once at its entry" << endl
+       << "  --if-convert   replace small if statements by conditional moves" << endl
+       << "  --promote      keep the most used global of a loop in a register" << endl
+       << "  --block-layout move basic blocks that are unlikely to execute out of line" << endl
+       << "  --remove-dead-procs" << endl
+       << "                 do not emit procedures that are never called" << endl
+       << "  --icf          fold procedures that compile to identical code" << endl
+       << "  --ipra         save only the callee-saved registers a procedure clobbers" << endl
+       << "  --regcall      pass the first two arguments of calls between procedures in %ecx" << endl
+       << "                 and %edx" << endl
+       << "  --accumulate-args" << endl
+       << "                 store outgoing arguments into an area reserved in the caller's" << endl
+       << "                 frame instead of pushing them" << endl
+       << "  --memoize      cache the results of pure recursive functions with integer" << endl
+       << "                 arguments. Default: off" << endl
+       << "  --cost-report  write a static cost estimate per procedure and loop to <file>.cost." << endl
+       << "                 Default: off" << endl
+       << "  --time-phases  print the time spent in each compiler phase and the peak memory" << endl
+       << "                 usage. Default: off" << endl
+       << "  --stream       compile, emit and free each procedure as soon as it is parsed." << endl
+       << "                 Only per-procedure optimizations are performed; cannot be" << endl
+       << "                 combined with --ast, --tac, --profile, --memoize or --cost-report." << endl
+       << "                 Default: off" << endl
+       << "  --remarks=<kinds>" << endl
+       << "                 report optimization remarks of the given kinds ('passed', 'missed'," << endl
+       << "                 'analysis' or 'all', separated by '|' or ','). Default: off" << endl
        << endl
        << endl
        << "Examples:" << endl
@@ -85,8 +165,17 @@ void Syntax(string msg)
        << "  $ snuplc --ast fibonacci.mod" << endl
        << endl
        << "  compile fibonacci.mod and also output the IR in textual and graphical form" << endl
-       << "  The IR is saved in fibonacci.mod.tac (textual) and fibonacci.mod.tac.dot (graphical form)" << endl
+       << "  The IR is saved in fibonacci.mod.tac (textual) and fibonacci.mod.tac.<scope>.dot" << endl
+       << "  (graphical form, one file per procedure)" << endl
        << "  $ snuplc --tac fibonacci.mod" << endl
+       << endl
+       << "  compile fibonacci.mod to an executable that prints the cycles spent in each" << endl
+       << "  procedure to stderr at exit" << endl
+       << "  $ snuplc --exe --profile fibonacci.mod" << endl
+       << endl
+       << "  compile fibonacci.mod and report missed optimizations on the console and" << endl
+       << "  in fibonacci.mod.remarks.yaml" << endl
+       << "  $ snuplc --remarks=missed fibonacci.mod" << endl
        << endl;
 
   exit(EXIT_FAILURE);
@@ -101,9 +190,55 @@ void ParseArgs(int argc, char *argv[])
       if (strcmp(argv[i], "--ast") == 0) dump_ast = true;
       else if (strcmp(argv[i], "--tac") == 0) dump_tac = true;
       else if (strcmp(argv[i], "--no-asm") == 0) dump_asm = false;
+      else if (strcmp(argv[i], "--no-asm-comments") == 0) asm_comments = false;
       else if (strcmp(argv[i], "--no-dot") == 0) dump_dot = false;
       else if (strcmp(argv[i], "--no-run-dot") == 0) run_dot = false;
       else if (strcmp(argv[i], "--exe") == 0) run_gcc = true;
+      else if (strcmp(argv[i], "--profile") == 0) profile = true;
+      else if (strcmp(argv[i], "--memoize") == 0) memoize = true;
+      else if (strcmp(argv[i], "--optimize") == 0) optimize = true;
+      else if (strcmp(argv[i], "--fold-calls") == 0) fold_calls = 1;
+      else if (strcmp(argv[i], "--no-fold-calls") == 0) fold_calls = 0;
+      else if (strcmp(argv[i], "--specialize") == 0) specialize = 1;
+      else if (strcmp(argv[i], "--no-specialize") == 0) specialize = 0;
+      else if (strcmp(argv[i], "--global-analysis") == 0) global_analysis = 1;
+      else if (strcmp(argv[i], "--no-global-analysis") == 0) global_analysis = 0;
+      else if (strcmp(argv[i], "--if-convert") == 0) if_convert = 1;
+      else if (strcmp(argv[i], "--no-if-convert") == 0) if_convert = 0;
+      else if (strcmp(argv[i], "--promote") == 0) promote = 1;
+      else if (strcmp(argv[i], "--no-promote") == 0) promote = 0;
+      else if (strcmp(argv[i], "--block-layout") == 0) block_layout = 1;
+      else if (strcmp(argv[i], "--no-block-layout") == 0) block_layout = 0;
+      else if (strcmp(argv[i], "--remove-dead-procs") == 0) dead_proc_elim = 1;
+      else if (strcmp(argv[i], "--keep-dead-procs") == 0) dead_proc_elim = 0;
+      else if (strcmp(argv[i], "--icf") == 0) icf = 1;
+      else if (strcmp(argv[i], "--no-icf") == 0) icf = 0;
+      else if (strcmp(argv[i], "--ipra") == 0) ipra = 1;
+      else if (strcmp(argv[i], "--no-ipra") == 0) ipra = 0;
+      else if (strcmp(argv[i], "--regcall") == 0) regcall = 1;
+      else if (strcmp(argv[i], "--no-regcall") == 0) regcall = 0;
+      else if (strcmp(argv[i], "--accumulate-args") == 0) accumulate = 1;
+      else if (strcmp(argv[i], "--push-args") == 0) accumulate = 0;
+      else if (strcmp(argv[i], "--jobs") == 0) {
+        i++;
+        if (i == argc) Syntax("Missing argument after --jobs");
+        max_jobs = atoi(argv[i]);
+        if (max_jobs <= 0) Syntax("Invalid number of jobs '" + string(argv[i]) + "'.");
+      }
+      else if (strcmp(argv[i], "--profile-file") == 0) {
+        i++;
+        if (i == argc) Syntax("Missing argument after --profile-file");
+        profile = true;
+        profile_file = string(argv[i]);
+      }
+      else if (strcmp(argv[i], "--cost-report") == 0) cost_report = true;
+      else if (strcmp(argv[i], "--time-phases") == 0) time_phases = true;
+      else if (strcmp(argv[i], "--stream") == 0) stream = true;
+      else if (strncmp(argv[i], "--remarks=", 10) == 0) {
+        if (!CRemarks::ParseFilter(string(argv[i] + 10), remarks)) {
+          Syntax("Invalid remark kinds in '" + string(argv[i]) + "'.");
+        }
+      }
       else if (strcmp(argv[i], "--rte") == 0) {
         i++;
         if (i == argc) Syntax("Missing argument after --rte");
@@ -115,38 +250,113 @@ void ParseArgs(int argc, char *argv[])
     else files.push_back(string(argv[i]));
     i++;
   }
+
+  // optimizations that were not set explicitly follow --optimize
+  int *opt[] = { &fold_calls, &specialize, &global_analysis, &if_convert,
+                 &promote, &block_layout, &dead_proc_elim, &icf, &ipra,
+                 &regcall, &accumulate };
+  for (size_t o=0; o<sizeof(opt)/sizeof(opt[0]); o++) {
+    if (*opt[o] < 0) *opt[o] = optimize;
+  }
+
+  if (stream && (dump_ast || dump_tac || profile || memoize || cost_report)) {
+    Syntax("--stream cannot be combined with --ast, --tac, --profile, "
+           "--memoize or --cost-report.");
+  }
+}
+
+/// @brief run @a cmd in the background (see CJobQueue)
+void RunJob(const vector<string> &cmd)
+{
+  cout << "  running command '" << CJobQueue::CommandLine(cmd) << "'..." << endl;
+  jobs->Submit(cmd);
 }
 
 void RunDOT(string file)
 {
   if (run_dot) {
-    ostringstream cmd;
-    cmd << "dot -Tpdf -o" << file << ".pdf " << file;
+    vector<string> cmd;
+    cmd.push_back("dot");
+    cmd.push_back("-Tpdf");
+    cmd.push_back("-o" + file + ".pdf");
+    cmd.push_back(file);
 
-    cout << "  running command '" << cmd.str() << "'..." << endl;
-    if (system(cmd.str().c_str()) < 0) {
-      cout << "  failed to run dot." << endl;
-    }
+    RunJob(cmd);
   }
 }
 
 void RunCompile(string file)
 {
   if (run_gcc) {
-    ostringstream cmd;
+    vector<string> cmd;
 
     string exe(file);
     exe.erase(exe.find(".mod"));
 
-    cmd << "gcc -m32 -o" << exe << " "
-        << rte_path << "IO.s" << " "
-        << rte_path << "ARRAY.s" << " "
-        << file;
+    cmd.push_back("gcc");
+    cmd.push_back("-m32");
+    cmd.push_back("-o" + exe);
+    cmd.push_back(rte_path + "IO.s");
+    cmd.push_back(rte_path + "ARRAY.s");
+    if (profile) cmd.push_back(rte_path + "PROFILE.s");
+    cmd.push_back(file);
 
-    cout << "  running command '" << cmd.str() << "'..." << endl;
-    if (system(cmd.str().c_str()) < 0) {
-      cout << "  failed to run gcc." << endl;
-    }
+    RunJob(cmd);
+  }
+}
+
+void DumpRemarks(string file)
+{
+  if (remarks != 0) {
+    CRemarks *r = CRemarks::Get();
+
+    // output remarks to the console and in YAML form
+    r->print(cout, file);
+
+    ofstream out(file + ".remarks.yaml");
+    r->toYAML(out, file);
+  }
+}
+
+typedef chrono::steady_clock::time_point TTime;
+
+/// @brief return the current time
+TTime Now(void)
+{
+  return chrono::steady_clock::now();
+}
+
+/// @brief print the time spent in @a phase between @a start and @a end
+void PrintPhase(string phase, TTime start, TTime end)
+{
+  if (time_phases) {
+    chrono::duration<double> d = end - start;
+    cout << "  time " << left << setw(12) << phase << " "
+         << fixed << setprecision(4) << d.count() << " s" << endl;
+  }
+}
+
+/// @brief print the peak memory usage of the compiler
+void PrintMemory(void)
+{
+  if (time_phases) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    cout << "  memory " << left << setw(10) << "peak" << " "
+         << ru.ru_maxrss << " KB" << endl;
+  }
+}
+
+void DumpCost(string file, CModule *m)
+{
+  if (cost_report) {
+    assert(m != NULL);
+
+    CCostModel cm;
+    cm.Analyze(m);
+
+    ofstream out(file + ".cost");
+    cm.print(out, file);
   }
 }
 
@@ -175,7 +385,7 @@ void DumpAST(string file, CAstModule *ast)
           << endl;
       ast->toDot(dot, 2);
       dot << "}" << endl;
-      dot.flush();
+      dot.close();
 
       RunDOT(fn);
     }
@@ -192,27 +402,146 @@ void DumpTAC(string file, CModule *m)
     out << file << ":" << endl
         << m << endl;
 
-    // output TAC in graphical form
+    // output TAC in graphical form, one graph per scope so that the graphs
+    // can be rendered in parallel
     if (dump_dot) {
-      string fn = file + ".tac.dot";
-      ofstream dot(fn);
-
-      dot << "digraph IR {" << endl
-          << "  graph [fontname=\"Times New Roman\",fontsize=10];" << endl
-          << "  node  [fontname=\"Courier New\",fontsize=10];" << endl
-          << "  edge  [fontname=\"Times New Roman\",fontsize=10];" << endl
-          << endl;
-      m->toDot(dot, 2);
+      vector<CScope*> scopes(1, m);
       const vector<CScope*> &proc = m->GetSubscopes();
-      for (size_t p=0; p<proc.size(); p++) {
-        proc[p]->toDot(dot, 2);
+      scopes.insert(scopes.end(), proc.begin(), proc.end());
+
+      for (size_t p=0; p<scopes.size(); p++) {
+        string fn = file + ".tac." + scopes[p]->GetName() + ".dot";
+        ofstream dot(fn);
+
+        dot << "digraph IR {" << endl
+            << "  graph [fontname=\"Times New Roman\",fontsize=10];" << endl
+            << "  node  [fontname=\"Courier New\",fontsize=10];" << endl
+            << "  edge  [fontname=\"Times New Roman\",fontsize=10];" << endl
+            << endl;
+        scopes[p]->toDot(dot, 2);
+        dot << "}" << endl;
+        dot.close();
+
+        RunDOT(fn);
       }
-      dot<< "}" << endl;
-      dot.flush();
+    }
+  }
+}
 
-      RunDOT(fn);
+/// @brief lowers, optimizes and emits the procedures of a module as soon as
+///        they have been parsed (see --stream). Only the module-level
+///        symbols and the module body are kept until the end of the module;
+///        interprocedural optimizations are not performed.
+class CStreamCompiler : public CProcedureConsumer {
+  public:
+    CStreamCompiler(CBackendx86 *be)
+      : _be(be), _m(NULL), _res(true)
+    {
+    }
+
+    virtual ~CStreamCompiler(void)
+    {
+      delete _m;
+    }
+
+    virtual void Procedure(CAstModule *m, CAstProcedure *proc)
+    {
+      Begin(m);
+
+      CProcedure *p = new CProcedure(proc, _m);
+      Optimize(p);
+      _be->EmitProcedure(p);
+      delete p;
+    }
+
+    /// @brief emit the body of module @a m. Returns false if the output
+    ///        could not be written.
+    bool End(CAstModule *m)
+    {
+      if (_m != NULL) m->ToTac(_m->GetCodeBlock());
+      else Begin(m);
+
+      Optimize(_m);
+      return _be->EndModule() && _res;
     }
+
+  private:
+    /// @brief start emitting module @a m. The body of @a m has not been
+    ///        parsed yet when called for the first procedure.
+    void Begin(CAstModule *m)
+    {
+      if (_m == NULL) {
+        _m = new CModule(m);
+        _res = _be->BeginModule(_m);
+      }
+    }
+
+    /// @brief run the per-procedure optimizations on @a scope
+    void Optimize(CScope *scope)
+    {
+      if (if_convert) CIfConversion(_m).Run(scope);
+      if (promote) CScalarPromotion(_m).Run(scope);
+      if (block_layout) CBlockLayout(_m).Run(scope);
+    }
+
+    CBackendx86 *_be;               ///< backend
+    CModule *_m;                    ///< module (body lowered by End())
+    bool _res;                      ///< result of BeginModule()
+};
+
+/// @brief compile @a file with parser @a p in streaming mode
+void CompileStream(string file, CParser *p)
+{
+  ostream *out = &cout;
+  ofstream *sout = NULL;
+
+  if (dump_asm) {
+    sout = new ofstream(file + ".s");
+    out = sout;
+  }
+
+  TTime t_start = Now();
+  CBackendx86 *be = new CBackendx86(*out);
+  be->SetIPRA(ipra);
+  be->SetRegisterArgs(regcall);
+  be->SetAccumulateArgs(accumulate);
+  be->SetComments(asm_comments);
+
+  CStreamCompiler *sc = new CStreamCompiler(be);
+  p->SetConsumer(sc);
+  CAstModule *ast = dynamic_cast<CAstModule*>(p->Parse());
+
+  bool ok = !p->HasError();
+  if (ok) ok = sc->End(ast);
+  TTime t_end = Now();
+
+  if (sout != NULL) {
+    sout->flush();
+    delete sout;
+  }
+
+  if (p->HasError()) {
+    const CToken *error = p->GetErrorToken();
+    cout << "parse error at " << error->GetLineNumber() << ":"
+         << error->GetCharPosition() << " : "
+         << p->GetErrorMessage() << endl;
+  } else if (!ok) {
+    cout << "cannot write assembly code" << endl;
+  }
+
+  if (ok) {
+    PrintPhase("total", t_start, t_end);
+    PrintMemory();
+
+    DumpRemarks(file);
+    RunCompile(file + ".s");
+  } else if (dump_asm) {
+    // do not leave partially emitted code behind
+    remove((file + ".s").c_str());
   }
+
+  delete sc;
+  delete be;
 }
 
 int main(int argc, char *argv[])
@@ -223,6 +552,9 @@ int main(int argc, char *argv[])
 
   if (it == files.end()) Syntax("No input files.");
 
+  CRemarks::Get()->SetFilter(remarks);
+  jobs = new CJobQueue(max_jobs);
+
   while (it != files.end()) {
     string file = *it++;
 
@@ -231,7 +563,16 @@ int main(int argc, char *argv[])
     CParser *p = new CParser(s);
 
     cout << "compiling " << file << "..." << endl;
+    CRemarks::Get()->Clear();
+
+    if (stream) {
+      CompileStream(file, p);
+      continue;
+    }
+
+    TTime t_start = Now();
     CAstNode *ast = p->Parse();
+    TTime t_parse = Now();
 
     if (p->HasError()) {
       const CToken *error = p->GetErrorToken();
@@ -244,6 +585,37 @@ int main(int argc, char *argv[])
       // AST to TAC conversion
       CModule *m = new CModule(ast);
 
+      // interprocedural side effect analysis; only needed by the passes
+      // that move or remove code across calls
+      CCallGraph *cg = new CCallGraph(m);
+      if (fold_calls || global_analysis || promote || memoize) {
+        CModRefAnalysis(cg).Run();
+      }
+
+      // compile-time evaluation of pure calls and specialization. Both only
+      // remove calls or redirect them to copies with the same side effects;
+      // the call graph has to be rebuilt, the side effects remain valid.
+      int changes = 0;
+      if (fold_calls) changes += CCallFolding(cg).Run();
+      if (specialize) changes += CSpecialization(m).Run();
+      if (changes > 0) {
+        delete cg;
+        cg = new CCallGraph(m);
+      }
+
+      // constant globals and globals not written by a procedure
+      if (global_analysis) CGlobalAnalysis(cg).Run();
+
+      // if-conversion; the selects are only understood by the backend
+      if (if_convert) CIfConversion(m).Run();
+
+      // promote globals accessed in loops to a register
+      if (promote) CScalarPromotion(m).Run();
+
+      // basic block layout; last since the IR passes do not preserve it
+      if (block_layout) CBlockLayout(m).Run();
+      TTime t_ir = Now();
+
       DumpTAC(file, m);
 
       // output x86 assembly to console or file
@@ -255,20 +627,43 @@ int main(int argc, char *argv[])
         out = sout;
       }
 
-      CBackend *be = new CBackendx86(*out);
+      TTime t_be_start = Now();
+      CBackendx86 *be = new CBackendx86(*out);
+      be->SetProfile(profile, profile_file);
+      be->SetCallGraph(cg);
+      be->SetMemoize(memoize);
+      be->SetDeadProcElim(dead_proc_elim);
+      be->SetCodeFolding(icf);
+      be->SetIPRA(ipra);
+      be->SetRegisterArgs(regcall);
+      be->SetAccumulateArgs(accumulate);
+      be->SetComments(asm_comments);
       be->Emit(m);
 
       if (sout != NULL) {
         sout->flush();
         delete sout;
       }
+      TTime t_be = Now();
 
+      PrintPhase("parse", t_start, t_parse);
+      PrintPhase("ir", t_parse, t_ir);
+      PrintPhase("backend", t_be_start, t_be);
+      PrintPhase("total", t_start, t_be);
+      PrintMemory();
+
+      DumpCost(file, m);
+      DumpRemarks(file);
       RunCompile(file + ".s");
 
       delete be;
+      delete cg;
       delete m;
     }
   }
 
+  // wait for dot and gcc
+  delete jobs;
+
   return EXIT_SUCCESS;
 }
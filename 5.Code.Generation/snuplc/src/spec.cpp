@@ -0,0 +1,454 @@
+//------------------------------------------------------------------------------
+/// @brief SnuPL procedure specialization
+//------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cassert>
+#include <sstream>
+
+#include "spec.h"
+#include "cfg.h"
+#include "remarks.h"
+using namespace std;
+
+
+//------------------------------------------------------------------------------
+// CSpecialization
+//
+// the growth budget is never smaller than MinBudget instructions so that
+// small modules can be specialized at all
+//
+static const int MinBudget = 200;
+
+CSpecialization::CSpecialization(CModule *m, int growth)
+  : _m(m), _growth(growth), _budget(0)
+{
+  assert(m != NULL);
+}
+
+int CSpecialization::Run(void)
+{
+  vector<CScope*> work(_m->GetSubscopes().begin(), _m->GetSubscopes().end());
+  work.push_back(_m);
+
+  int size = 0, n = 0;
+  for (const auto &s : work) {
+    size += Size(s);
+    if (s != _m) {
+      _proc[s->GetDeclaration()] = s;
+      Analyze(s);
+    }
+  }
+  _budget = max(MinBudget, size * _growth / 100);
+
+  // shapes of global and local arrays are known everywhere; folding them
+  // first also keeps the copies small
+  for (const auto &s : work) n += FoldShapes(s);
+
+  // copies are appended to the work list and specialized in turn
+  for (size_t i=0; i<work.size(); i++) n += Specialize(work[i], work);
+
+  return n;
+}
+
+void CSpecialization::Analyze(CScope *proc)
+{
+  vector<CTacInstr*> code(proc->GetCodeBlock()->GetInstr().begin(),
+                          proc->GetCodeBlock()->GetInstr().end());
+  set<int> &cparam = _cparam[proc], &aparam = _aparam[proc];
+  set<int> assigned;
+
+  for (size_t pc=0; pc<code.size(); pc++) {
+    CTacInstr *i = code[pc];
+    EOperation op = i->GetOperation();
+
+    // scalar parameters compared in branches or switched on; parameters that
+    // are assigned cannot be replaced by a constant
+    const CTacName *d = dynamic_cast<const CTacName*>(i->GetDest());
+    if ((d != NULL) && (dynamic_cast<const CTacReference*>(d) == NULL) &&
+        (d->GetSymbol()->GetSymbolType() == stParam)) {
+      assigned.insert(dynamic_cast<const CSymParam*>(d->GetSymbol())->GetIndex());
+    }
+
+    if (((op >= opEqual) && (op <= opBiggerEqual)) || (op == opSwitch)) {
+      for (int s=1; s<=2; s++) {
+        const CTacName *n = dynamic_cast<const CTacName*>(i->GetSrc(s));
+        if ((n != NULL) && (dynamic_cast<const CTacReference*>(n) == NULL) &&
+            (n->GetSymbol()->GetSymbolType() == stParam)) {
+          cparam.insert(dynamic_cast<const CSymParam*>(n->GetSymbol())->GetIndex());
+        }
+      }
+    }
+
+    // array parameters queried by DIM/DOFS (param 0 right before the call)
+    if ((op == opCall) && (pc > 0) &&
+        (code[pc-1]->GetOperation() == opParam)) {
+      const CTacName *fn = dynamic_cast<const CTacName*>(i->GetSrc(1));
+      const CTacName *n = dynamic_cast<const CTacName*>(code[pc-1]->GetSrc(1));
+      string name = fn->GetSymbol()->GetName();
+
+      if (((name == "DIM") || (name == "DOFS")) && (n != NULL) &&
+          (n->GetSymbol()->GetSymbolType() == stParam)) {
+        aparam.insert(dynamic_cast<const CSymParam*>(n->GetSymbol())->GetIndex());
+      }
+    }
+  }
+
+  for (const auto &a : assigned) cparam.erase(a);
+}
+
+int CSpecialization::Specialize(CScope *scope, vector<CScope*> &work)
+{
+  CCodeBlock *cb = scope->GetCodeBlock();
+  CRemarks *rm = CRemarks::Get();
+  vector<CTacInstr*> code(cb->GetInstr().begin(), cb->GetInstr().end());
+  map<const CSymbol*, const CSymbol*> addr;
+  int n = 0;
+
+  for (size_t pc=0; pc<code.size(); pc++) {
+    CTacInstr *i = code[pc];
+    EOperation op = i->GetOperation();
+
+    if (op == opAddress) {
+      const CTacName *d = dynamic_cast<const CTacName*>(i->GetDest());
+      const CTacName *s = dynamic_cast<const CTacName*>(i->GetSrc(1));
+      addr[d->GetSymbol()] = s->GetSymbol();
+      continue;
+    }
+    if (op != opCall) continue;
+
+    const CTacName *fn = dynamic_cast<const CTacName*>(i->GetSrc(1));
+    map<const CSymbol*, CScope*>::const_iterator p = _proc.find(fn->GetSymbol());
+    if (p == _proc.end()) continue;
+
+    CScope *proc = p->second;
+    const CSymProc *decl = dynamic_cast<const CSymProc*>(fn->GetSymbol());
+    int np = decl->GetNParams();
+    vector<CTacInstr*> params;
+    if (!Arguments(code, pc, np, params)) continue;
+
+    vector<SArg> args(np);
+    bool known = false;
+    ostringstream key;
+    key << proc->GetName();
+
+    for (int k=0; k<np; k++) {
+      const CTacInstr *param = params[k];
+      SArg &a = args[k];
+      a.known = false;
+      a.value = 0;
+      a.shape = NULL;
+
+      const CTacConst *c = dynamic_cast<const CTacConst*>(param->GetSrc(1));
+      if ((c != NULL) && (_cparam[proc].count(k) > 0)) {
+        a.known = true;
+        a.value = c->GetValue();
+        key << " " << k << "=" << a.value;
+      }
+      if (_aparam[proc].count(k) > 0) {
+        a.shape = Shape(scope, Origin(param->GetSrc(1), addr));
+        if (a.shape != NULL) {
+          a.known = true;
+          key << " " << k << ":" << a.shape;
+        }
+      }
+      known = known || a.known;
+    }
+    if (!known) continue;
+
+    // reuse or create a copy for this signature
+    map<string, CScope*>::const_iterator it = _clone.find(key.str());
+    CScope *clone = NULL;
+
+    if (it != _clone.end()) {
+      clone = it->second;
+    } else if (Size(proc) > _budget) {
+      rm->Add(rkMissed, "specialize", scope->GetDisplayName(),
+              i->GetLineNumber(), "call to '" + proc->GetDisplayName() +
+              "' not specialized: code growth budget exhausted");
+      _clone[key.str()] = NULL;
+    } else {
+      clone = Clone(proc, args);
+      _clone[key.str()] = clone;
+      work.push_back(clone);
+      n++;
+    }
+    if (clone == NULL) continue;
+
+    code[pc] = cb->ReplaceInstr(i, new CTacInstr(opCall, i->GetDest(),
+                                new CTacName(clone->GetDeclaration()), NULL));
+  }
+
+  return n;
+}
+
+CScope* CSpecialization::Clone(CScope *proc, const vector<SArg> &args)
+{
+  CProcedure *p = dynamic_cast<CProcedure*>(proc);
+  assert(p != NULL);
+
+  // the copies are reported under the name of the original
+  ostringstream name, display;
+  name << proc->GetName() << "." << ++_nclones[proc];
+  display << proc->GetDisplayName() << " [spec " << _nclones[proc] << "]";
+
+  CProcedure *clone = new CProcedure(p, name.str(), display.str());
+  proc->GetParent()->AddSubscope(clone);
+
+  // bind the known arguments
+  const CSymProc *decl = dynamic_cast<const CSymProc*>(clone->GetDeclaration());
+  map<const CSymbol*, int> value;
+  ostringstream what;
+
+  for (size_t k=0; k<args.size(); k++) {
+    if (!args[k].known) continue;
+
+    const CSymbol *param = decl->GetParam(k);
+    what << (what.str().size() > 0 ? ", " : "") << param->GetName();
+    if (args[k].shape != NULL) {
+      _shape[clone][param] = args[k].shape;
+      what << ": " << args[k].shape;
+    } else {
+      value[param] = args[k].value;
+      what << " = " << args[k].value;
+    }
+  }
+
+  // replace the constant parameters by their values
+  CCodeBlock *cb = clone->GetCodeBlock();
+  vector<CTacInstr*> code(cb->GetInstr().begin(), cb->GetInstr().end());
+
+  for (const auto &i : code) {
+    if (i->GetOperation() == opLabel) continue;
+
+    bool changed = false;
+
+    for (int s=1; s<=2; s++) {
+      const CTacName *n = dynamic_cast<const CTacName*>(i->GetSrc(s));
+      if ((n == NULL) || (dynamic_cast<const CTacReference*>(n) != NULL)) continue;
+
+      if (value.find(n->GetSymbol()) != value.end()) changed = true;
+    }
+
+    if (changed) cb->ReplaceInstr(i, CCodeBlock::FoldInstr(i, value));
+  }
+
+  FoldShapes(clone);
+  Simplify(clone);
+
+  int size = Size(clone);
+  _budget -= size;
+
+  ostringstream msg;
+  msg << "specialized copy '" << clone->GetDisplayName() << "' for "
+      << what.str() << " (" << size << " instructions, original "
+      << Size(proc) << ")";
+  CRemarks::Get()->Add(rkPassed, "specialize", proc->GetDisplayName(),
+                       proc->GetLineNumber(), msg.str());
+
+  return clone;
+}
+
+int CSpecialization::FoldShapes(CScope *scope)
+{
+  CCodeBlock *cb = scope->GetCodeBlock();
+  vector<CTacInstr*> code(cb->GetInstr().begin(), cb->GetInstr().end());
+  map<const CSymbol*, const CSymbol*> addr;
+  int n = 0;
+
+  for (size_t pc=0; pc<code.size(); pc++) {
+    CTacInstr *i = code[pc];
+    EOperation op = i->GetOperation();
+
+    if (op == opAddress) {
+      const CTacName *d = dynamic_cast<const CTacName*>(i->GetDest());
+      const CTacName *s = dynamic_cast<const CTacName*>(i->GetSrc(1));
+      addr[d->GetSymbol()] = s->GetSymbol();
+      continue;
+    }
+    if ((op != opCall) || (i->GetDest() == NULL) || (pc < 1)) continue;
+
+    const CTacName *fn = dynamic_cast<const CTacName*>(i->GetSrc(1));
+    string name = fn->GetSymbol()->GetName();
+    if ((_proc.find(fn->GetSymbol()) != _proc.end()) ||
+        ((name != "DIM") && (name != "DOFS"))) continue;
+
+    // DOFS: param 0 <- a; call t <- DOFS
+    // DIM:  param 1 <- d; (...) param 0 <- a; call t <- DIM
+    vector<CTacInstr*> params;
+    if (!Arguments(code, pc, name == "DIM" ? 2 : 1, params)) continue;
+
+    CTacInstr *arr = params[0];
+    const CArrayType *shape = Shape(scope, Origin(arr->GetSrc(1), addr));
+    if (shape == NULL) continue;
+
+    int value;
+    if (params.size() == 1) {
+      value = 4 + 4*shape->GetNDim();
+    } else {
+      CTacInstr *dim = params[1];
+      const CTacConst *d = dynamic_cast<const CTacConst*>(dim->GetSrc(1));
+      if ((d == NULL) || (d->GetValue() < 1) ||
+          (d->GetValue() > shape->GetNDim())) continue;
+
+      const CArrayType *a = shape;
+      for (int k=1; k<d->GetValue(); k++) {
+        a = dynamic_cast<const CArrayType*>(a->GetInnerType());
+      }
+      value = a->GetNElem();
+      cb->RemoveInstr(dim);
+    }
+
+    cb->RemoveInstr(arr);
+    code[pc] = cb->ReplaceInstr(i, new CTacInstr(opAssign, i->GetDest(),
+                                                 new CTacConst(value), NULL));
+    n++;
+  }
+
+  if (n == 0) return 0;
+
+  // remove address computations that are no longer used
+  set<const CSymbol*> used;
+  for (const auto &i : cb->GetInstr()) {
+    const CTac *ops[3] = { i->GetSrc(1), i->GetSrc(2), NULL };
+    if (dynamic_cast<const CTacReference*>(i->GetDest()) != NULL) {
+      ops[2] = i->GetDest();
+    }
+    for (int o=0; o<3; o++) {
+      const CTacName *name = dynamic_cast<const CTacName*>(ops[o]);
+      if (name != NULL) used.insert(name->GetSymbol());
+    }
+  }
+
+  code.assign(cb->GetInstr().begin(), cb->GetInstr().end());
+  for (const auto &i : code) {
+    if (i->GetOperation() != opAddress) continue;
+    const CTacName *d = dynamic_cast<const CTacName*>(i->GetDest());
+    if (used.find(d->GetSymbol()) == used.end()) cb->RemoveInstr(i);
+  }
+
+  ostringstream msg;
+  msg << "replaced " << n << " DIM/DOFS call(s) on arrays of known shape "
+      << "by constants";
+  CRemarks::Get()->Add(rkPassed, "specialize", scope->GetDisplayName(),
+                       scope->GetLineNumber(), msg.str());
+
+  return n;
+}
+
+void CSpecialization::Simplify(CScope *scope)
+{
+  CCodeBlock *cb = scope->GetCodeBlock();
+  vector<CTacInstr*> code(cb->GetInstr().begin(), cb->GetInstr().end());
+
+  // resolve branches and switches on constants
+  for (const auto &i : code) {
+    EOperation op = i->GetOperation();
+    if (op == opSwitch) {
+      const CTacConst *v = dynamic_cast<const CTacConst*>(i->GetSrc(1));
+      if (v == NULL) continue;
+
+      CTacLabel *target = dynamic_cast<CTacSwitch*>(i)->GetTarget(v->GetValue());
+      if (target != NULL) cb->ReplaceInstr(i, new CTacInstr(opGoto, target));
+      else cb->RemoveInstr(i);
+      continue;
+    }
+    if ((op < opEqual) || (op > opBiggerEqual)) continue;
+
+    const CTacConst *a = dynamic_cast<const CTacConst*>(i->GetSrc(1));
+    const CTacConst *b = dynamic_cast<const CTacConst*>(i->GetSrc(2));
+    if ((a == NULL) || (b == NULL)) continue;
+
+    bool taken;
+    switch (op) {
+      case opEqual:       taken = a->GetValue() == b->GetValue(); break;
+      case opNotEqual:    taken = a->GetValue() != b->GetValue(); break;
+      case opLessThan:    taken = a->GetValue() <  b->GetValue(); break;
+      case opLessEqual:   taken = a->GetValue() <= b->GetValue(); break;
+      case opBiggerThan:  taken = a->GetValue() >  b->GetValue(); break;
+      default:            taken = a->GetValue() >= b->GetValue(); break;
+    }
+
+    if (taken) cb->ReplaceInstr(i, new CTacInstr(opGoto, i->GetDest(), NULL, NULL));
+    else cb->RemoveInstr(i);
+  }
+
+  // remove unreachable code
+  vector<CTacInstr*> dead;
+  {
+    CCfg cfg(cb);
+    for (const auto &bb : cfg.GetBlocks()) {
+      if (!bb->IsReachable()) {
+        dead.insert(dead.end(), bb->GetInstr().begin(), bb->GetInstr().end());
+      }
+    }
+  }
+  for (const auto &i : dead) cb->RemoveInstr(i);
+
+  cb->CleanupControlFlow();
+}
+
+const CSymbol* CSpecialization::Origin(const CTacAddr *op,
+                          const map<const CSymbol*, const CSymbol*> &addr) const
+{
+  const CTacName *n = dynamic_cast<const CTacName*>(op);
+  if ((n == NULL) || (dynamic_cast<const CTacReference*>(n) != NULL)) {
+    return NULL;
+  }
+
+  map<const CSymbol*, const CSymbol*>::const_iterator it =
+    addr.find(n->GetSymbol());
+  if (it != addr.end()) return it->second;
+  if (n->GetSymbol()->GetSymbolType() == stParam) return n->GetSymbol();
+
+  return NULL;
+}
+
+const CArrayType* CSpecialization::Shape(CScope *scope,
+                                         const CSymbol *sym) const
+{
+  if (sym == NULL) return NULL;
+
+  const CArrayType *a = dynamic_cast<const CArrayType*>(sym->GetDataType());
+  if (a != NULL) {
+    // declared arrays are never open, but better be safe
+    for (const CArrayType *t = a; t != NULL;
+         t = dynamic_cast<const CArrayType*>(t->GetInnerType())) {
+      if (t->GetNElem() == CArrayType::OPEN) return NULL;
+    }
+    return a;
+  }
+
+  map<CScope*, map<const CSymbol*, const CArrayType*> >::const_iterator s =
+    _shape.find(scope);
+  if (s == _shape.end()) return NULL;
+
+  map<const CSymbol*, const CArrayType*>::const_iterator it =
+    s->second.find(sym);
+  return it != s->second.end() ? it->second : NULL;
+}
+
+bool CSpecialization::Arguments(const vector<CTacInstr*> &code, size_t pc,
+                                int np, vector<CTacInstr*> &params)
+{
+  // arguments are passed in reverse order: param np-1, ..., param 0, call
+  params.assign(np, NULL);
+
+  int k = 0;
+  while ((k < np) && (pc > 0)) {
+    CTacInstr *i = code[--pc];
+    if (i->GetOperation() == opCall) return false;
+    if (i->GetOperation() != opParam) continue;
+
+    const CTacConst *idx = dynamic_cast<const CTacConst*>(i->GetDest());
+    if (idx->GetValue() != k) return false;
+    params[k++] = i;
+  }
+
+  return k == np;
+}
+
+int CSpecialization::Size(CScope *scope)
+{
+  return (int)scope->GetCodeBlock()->GetInstr().size();
+}
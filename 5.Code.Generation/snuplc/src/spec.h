@@ -0,0 +1,108 @@
+//------------------------------------------------------------------------------
+/// @brief SnuPL procedure specialization
+//------------------------------------------------------------------------------
+
+#ifndef __SnuPL_SPEC_H__
+#define __SnuPL_SPEC_H__
+
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "ir.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+/// @brief procedure specialization
+///
+/// interprocedural constant propagation by cloning. For every call site the
+/// pass determines which arguments are known: constants passed to scalar
+/// parameters that control branches in the callee, and the concrete shape
+/// (CArrayType) of arrays passed to open array parameters that the callee
+/// queries with DIM/DOFS. Call sites with the same known arguments are
+/// redirected to a specialized copy of the callee in which
+///  - the constant parameters are replaced by their values,
+///  - DIM/DOFS calls on parameters of known shape are replaced by constants,
+///  - branches on constants are resolved and unreachable code is removed.
+/// The total size of the copies is limited by a code growth budget.
+///
+/// Independently of cloning, DIM/DOFS calls on global and local arrays (whose
+/// shape is always known) are replaced by constants in all procedures.
+///
+class CSpecialization {
+  public:
+    /// @name constructor/destructor
+    /// @{
+
+    /// @brief constructor
+    /// @param m module
+    /// @param growth allowed code growth in percent of the module's size
+    CSpecialization(CModule *m, int growth=50);
+
+    /// @}
+
+    /// @brief specialize the module
+    /// @retval int number of changes (specialized procedures and folded
+    ///         DIM/DOFS calls)
+    int Run(void);
+
+  private:
+    /// @brief known argument of a call site
+    struct SArg {
+      bool known;                   ///< argument is known
+      int value;                    ///< constant value (scalars)
+      const CArrayType *shape;      ///< array shape (arrays)
+    };
+
+    /// @brief redirect the call sites in @a scope to specialized procedures.
+    ///        New copies are appended to @a work.
+    int Specialize(CScope *scope, vector<CScope*> &work);
+
+    /// @brief create a copy of @a proc specialized for @a args
+    CScope* Clone(CScope *proc, const vector<SArg> &args);
+
+    /// @brief replace DIM/DOFS calls on arrays of known shape by constants
+    int FoldShapes(CScope *scope);
+
+    /// @brief resolve branches on constants and remove unreachable code
+    void Simplify(CScope *scope);
+
+    /// @brief determine which parameters of @a proc profit from
+    ///        specialization
+    void Analyze(CScope *proc);
+
+    /// @brief return the array symbol @a op refers to (NULL if unknown).
+    ///        @a addr maps temporaries to the arrays whose address they hold.
+    const CSymbol* Origin(const CTacAddr *op,
+                          const map<const CSymbol*, const CSymbol*> &addr) const;
+
+    /// @brief return the shape of array @a sym in @a scope (NULL if unknown)
+    const CArrayType* Shape(CScope *scope, const CSymbol *sym) const;
+
+    /// @brief find the @a np param instructions of the call at @a code[pc].
+    ///        Argument evaluation code between them is skipped, nested calls
+    ///        are not.
+    /// @retval true if all arguments were found
+    static bool Arguments(const vector<CTacInstr*> &code, size_t pc, int np,
+                          vector<CTacInstr*> &params);
+
+    /// @brief return the number of instructions of @a scope
+    static int Size(CScope *scope);
+
+    CModule *_m;                                ///< module
+    int _growth;                                ///< growth in percent
+    int _budget;                                ///< remaining budget (instr.)
+    map<const CSymbol*, CScope*> _proc;         ///< original procedures
+    map<CScope*, set<int> > _cparam;            ///< params used in branches
+    map<CScope*, set<int> > _aparam;            ///< params used in DIM/DOFS
+    map<CScope*, map<const CSymbol*, const CArrayType*> > _shape;
+                                                ///< specialized param. shapes
+    map<string, CScope*> _clone;                ///< copies by signature
+    map<CScope*, int> _nclones;                 ///< number of copies
+};
+
+
+#endif // __SnuPL_SPEC_H__
@@ -215,7 +215,7 @@ int CSymParam::GetIndex(void) const
 // CSymProc
 //
 CSymProc::CSymProc(const string name, const CType *return_type)
-  : CSymbol(name, stProcedure, return_type)
+  : CSymbol(name, stProcedure, return_type), _effects(seAll), _known(false)
 {
 }
 
@@ -235,6 +235,59 @@ const CSymParam* CSymProc::GetParam(int index) const
   return _param[index];
 }
 
+void CSymProc::SetSideEffects(int effects,
+                              const set<const CSymbol*> &ref,
+                              const set<const CSymbol*> &mod,
+                              const set<int> &pref, const set<int> &pmod)
+{
+  _effects = effects;
+  _known = true;
+  _ref = ref;
+  _mod = mod;
+  _pref = pref;
+  _pmod = pmod;
+}
+
+int CSymProc::GetSideEffects(void) const
+{
+  return _effects;
+}
+
+bool CSymProc::IsPure(void) const
+{
+  return _effects == seNone;
+}
+
+bool CSymProc::ReadsGlobal(const CSymbol *g) const
+{
+  return (_effects & seReadGlobal) && (!_known || _ref.count(g));
+}
+
+bool CSymProc::WritesGlobal(const CSymbol *g) const
+{
+  return (_effects & seWriteGlobal) && (!_known || _mod.count(g));
+}
+
+bool CSymProc::ReadsParam(int index) const
+{
+  return (_effects & seReadParam) && (!_known || _pref.count(index));
+}
+
+bool CSymProc::WritesParam(int index) const
+{
+  return (_effects & seWriteParam) && (!_known || _pmod.count(index));
+}
+
+const set<const CSymbol*>& CSymProc::GetGlobalRefs(void) const
+{
+  return _ref;
+}
+
+const set<const CSymbol*>& CSymProc::GetGlobalMods(void) const
+{
+  return _mod;
+}
+
 ostream& CSymProc::print(ostream &out, int indent) const
 {
   string ind(indent, ' ');
@@ -291,6 +344,15 @@ bool CSymtab::AddSymbol(CSymbol *s)
   }
 }
 
+void CSymtab::RemoveSymbol(CSymbol *s)
+{
+  map<string, CSymbol*>::iterator it = _symtab.find(s->GetName());
+  assert((it != _symtab.end()) && (it->second == s));
+
+  _symtab.erase(it);
+  s->SetSymbolTable(NULL);
+}
+
 const CSymbol* CSymtab::FindSymbol(const string name, EScope scope) const
 {
   map<string, CSymbol*>::const_iterator it = _symtab.find(name);
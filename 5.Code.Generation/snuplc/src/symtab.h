@@ -35,6 +35,7 @@
 
 #include <iostream>
 #include <map>
+#include <set>
 #include <vector>
 
 #include "data.h"
@@ -284,11 +285,32 @@ class CSymParam : public CSymLocal {
 };
 
 
+//------------------------------------------------------------------------------
+/// @brief side effects of a procedure
+///
+/// the values can be combined. Parameter effects refer to data accessed
+/// through array (pointer) parameters; scalar parameters are passed by value.
+///
+enum ESideEffect {
+  seNone        = 0,                ///< no side effects
+  seReadGlobal  = 1,                ///< reads global variables
+  seWriteGlobal = 2,                ///< writes global variables
+  seReadParam   = 4,                ///< reads through array parameters
+  seWriteParam  = 8,                ///< writes through array parameters
+  seIO          = 16,               ///< performs I/O
+  seAll         = 31,               ///< unknown side effects
+};
+
+
 //------------------------------------------------------------------------------
 /// @brief procedure symbol
 ///
 /// class representing a procedure/function symbol
 ///
+/// the side effects of a procedure are unknown (seAll) until they are set by
+/// the interprocedural analysis (see CModRefAnalysis) or, for the predefined
+/// procedures, when the symbol table is initialized.
+///
 class CSymProc : public CSymbol {
   public:
     /// @name constructor/destructor
@@ -319,6 +341,49 @@ class CSymProc : public CSymbol {
 
     /// @}
 
+    /// @name side effects
+    /// @{
+
+    /// @brief set the side effects (combination of ESideEffect)
+    ///
+    /// @param effects side effects
+    /// @param ref globals read (only relevant with seReadGlobal)
+    /// @param mod globals written (only relevant with seWriteGlobal)
+    /// @param pref indices of array parameters read through
+    /// @param pmod indices of array parameters written through
+    void SetSideEffects(int effects,
+                        const set<const CSymbol*> &ref = set<const CSymbol*>(),
+                        const set<const CSymbol*> &mod = set<const CSymbol*>(),
+                        const set<int> &pref = set<int>(),
+                        const set<int> &pmod = set<int>());
+
+    /// @brief return the side effects (combination of ESideEffect)
+    int GetSideEffects(void) const;
+
+    /// @brief returns true if the procedure has no side effects, i.e., its
+    ///        result only depends on the values of its arguments
+    bool IsPure(void) const;
+
+    /// @brief returns true if the procedure may read global @a g
+    bool ReadsGlobal(const CSymbol *g) const;
+
+    /// @brief returns true if the procedure may write global @a g
+    bool WritesGlobal(const CSymbol *g) const;
+
+    /// @brief returns true if the procedure may read through parameter @a index
+    bool ReadsParam(int index) const;
+
+    /// @brief returns true if the procedure may write through parameter @a index
+    bool WritesParam(int index) const;
+
+    /// @brief return the globals read
+    const set<const CSymbol*>& GetGlobalRefs(void) const;
+
+    /// @brief return the globals written
+    const set<const CSymbol*>& GetGlobalMods(void) const;
+
+    /// @}
+
     /// @brief print the symbol to an output stream
     /// @param out output stream
     /// @param indent indentation
@@ -326,6 +391,13 @@ class CSymProc : public CSymbol {
 
   private:
     vector<CSymParam*> _param;      ///< parameter list
+
+    int _effects;                   ///< side effects
+    bool _known;                    ///< side effects have been computed
+    set<const CSymbol*> _ref;       ///< globals read
+    set<const CSymbol*> _mod;       ///< globals written
+    set<int> _pref;                 ///< array parameters read through
+    set<int> _pmod;                 ///< array parameters written through
 };
 
 
@@ -367,6 +439,10 @@ class CSymtab {
     /// @retval false if such a symbol already exists in the local symbol table
     bool AddSymbol(CSymbol *s);
 
+    /// @brief remove symbol @a s from the local symbol table without
+    ///        deleting it
+    void RemoveSymbol(CSymbol *s);
+
     /// @brief return a symbol with a given name
     /// @param name symbol name (identifier)
     /// @param scope search scope (default: sGlobal)
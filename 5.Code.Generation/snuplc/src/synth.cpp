@@ -0,0 +1,185 @@
+//------------------------------------------------------------------------------
+/// @brief SnuPL synthetic module generator
+//------------------------------------------------------------------------------
+
+#include "synth.h"
+using namespace std;
+
+
+//------------------------------------------------------------------------------
+// CModuleGenerator
+//
+CModuleGenerator::CModuleGenerator(unsigned long long seed)
+  : _state(seed), _nglobals(0), _narrays(0), _nlines(0)
+{
+}
+
+string CModuleGenerator::Generate(long long lines)
+{
+  if (lines < 100) lines = 100;
+
+  _out.str("");
+  _nlines = 0;
+
+  // about one global scalar and one global array per 50 and 200 lines
+  _nglobals = 8 + lines / 50;
+  _narrays = 2 + lines / 200;
+
+  Line(0, "//");
+  Line(0, "// synthetic module (generated by gen_module)");
+  Line(0, "//");
+  Line(0, "");
+  Line(0, "module synthetic;");
+  Line(0, "");
+  Line(0, "var");
+  for (int g=0; g<_nglobals; g++) {
+    ostringstream o;
+    o << "  g" << g << ": integer;";
+    Line(0, o.str());
+  }
+  for (int a=0; a<_narrays; a++) {
+    ostringstream o;
+    o << "  a" << a << ": integer[" << 16 + Rnd(64) << "];";
+    Line(0, o.str());
+  }
+  Line(0, "");
+
+  int nprocs = 0;
+  while (_nlines < lines - 10) Procedure(nprocs++);
+
+  Line(0, "begin");
+  if (nprocs > 0) {
+    ostringstream o;
+    o << "  g0 := p" << nprocs-1 << "(1, 2, a0);";
+    Line(0, o.str());
+  }
+  Line(0, "  WriteInt(g0)");
+  Line(0, "end synthetic.");
+
+  return _out.str();
+}
+
+long long CModuleGenerator::GetLines(void) const
+{
+  return _nlines;
+}
+
+int CModuleGenerator::Rnd(int n)
+{
+  _state = _state * 6364136223846793005ULL + 1442695040888963407ULL;
+  return (int)((_state >> 33) % (unsigned long long)n);
+}
+
+void CModuleGenerator::Line(int ind, const string &s)
+{
+  _out << string(2*ind, ' ') << s << '\n';
+  _nlines++;
+}
+
+string CModuleGenerator::Operand(void)
+{
+  ostringstream o;
+  switch (Rnd(5)) {
+    case 0:  o << Rnd(1000); break;
+    case 1:  o << "g" << Rnd(_nglobals); break;
+    case 2:  o << "a" << Rnd(_narrays) << "[" << Rnd(16) << "]"; break;
+    case 3:  o << "x"; break;
+    default: o << "y"; break;
+  }
+  return o.str();
+}
+
+string CModuleGenerator::Expression(int terms, int depth)
+{
+  static const char *op[] = { " + ", " - ", " * ", " + ", " - " };
+  ostringstream o;
+
+  for (int t=0; t<terms; t++) {
+    if (t > 0) o << op[Rnd(5)];
+    if ((depth < 8) && (terms > 4) && (Rnd(6) == 0)) {
+      o << "(" << Expression(terms / 3, depth+1) << ")";
+      t += terms / 3;
+    } else {
+      o << Operand();
+    }
+  }
+  return o.str();
+}
+
+void CModuleGenerator::LongAssignment(int ind, const string &dst, int lines)
+{
+  Line(ind, dst + " := " + Expression(8));
+  for (int l=1; l<lines; l++) {
+    _out << string(2*ind+4, ' ') << "+ (" << Expression(8) << ")";
+    if (l == lines-1) _out << ";";
+    _out << '\n';
+    _nlines++;
+  }
+}
+
+void CModuleGenerator::Nested(int ind, int depth)
+{
+  ostringstream c;
+  c << "(x < " << Rnd(1000) << ") && (y # g" << Rnd(_nglobals) << ")";
+
+  if (Rnd(2) == 0) {
+    Line(ind, "if (" + c.str() + ") then");
+    Line(ind+1, "x := x + " + Operand() + ";");
+  } else {
+    Line(ind, "while (" + c.str() + ") do");
+    Line(ind+1, "x := x + 1;");
+  }
+
+  if (depth > 1) Nested(ind+1, depth-1);
+  else Line(ind+1, "y := " + Expression(6) + ";");
+
+  Line(ind+1, "ok := !ok || (x > y)");
+  Line(ind, "end;");
+}
+
+void CModuleGenerator::Procedure(int p)
+{
+  ostringstream o;
+
+  o << "function p" << p << "(x, y: integer; v: integer[]): integer;";
+  Line(0, o.str());
+  Line(0, "var i, t: integer;");
+  Line(0, "    c: char;");
+  Line(0, "    ok: boolean;");
+  Line(0, "    l: integer[32];");
+  Line(0, "begin");
+
+  Line(1, "ok := true;");
+  LongAssignment(1, "t", 2 + Rnd(6));
+
+  o.str("");
+  o << "WriteStr(\"p" << p << ": ";
+  for (int i=0, n=40 + Rnd(160); i<n; i++) o << (char)('a' + Rnd(26));
+  o << "\");";
+  Line(1, o.str());
+
+  Line(1, "i := 0;");
+  Line(1, "while (i < 32) do");
+  Line(2, "l[i] := v[i] + " + Operand() + ";");
+  Line(2, "i := i + 1");
+  Line(1, "end;");
+
+  Nested(1, 1 + Rnd(12));
+
+  if (p > 0) {
+    o.str("");
+    o << "x := p" << Rnd(p) << "(x, t, v);";
+    Line(1, o.str());
+  }
+
+  o.str("");
+  o << "g" << Rnd(_nglobals) << " := x + y;";
+  Line(1, o.str());
+  Line(1, "c := 'a';");
+  Line(1, "return t + x");
+
+  o.str("");
+  o << "end p" << p << ";";
+  Line(0, o.str());
+  Line(0, "");
+}
@@ -0,0 +1,74 @@
+//------------------------------------------------------------------------------
+/// @brief SnuPL synthetic module generator
+//------------------------------------------------------------------------------
+
+#ifndef __SnuPL_SYNTH_H__
+#define __SnuPL_SYNTH_H__
+
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+/// @brief synthetic module generator
+///
+/// generates valid SnuPL/1 modules of (approximately) a given number of lines
+/// to measure the throughput of the compiler. The modules contain many
+/// procedures, large expressions, deeply nested statements, many global
+/// scalars and arrays, and long string literals. The output only depends on
+/// the number of lines and the seed.
+///
+class CModuleGenerator {
+  public:
+    /// @name constructor/destructor
+    /// @{
+
+    /// @brief constructor
+    /// @param seed seed of the pseudo-random number generator
+    CModuleGenerator(unsigned long long seed=1);
+
+    /// @}
+
+    /// @name generation
+    /// @{
+
+    /// @brief generate a module with about @a lines lines (at least 100)
+    string Generate(long long lines);
+
+    /// @brief return the number of lines of the last generated module
+    long long GetLines(void) const;
+
+    /// @}
+
+  protected:
+    /// @brief deterministic pseudo-random number in [0, n)
+    int Rnd(int n);
+
+    /// @brief emit one line with indentation @a ind
+    void Line(int ind, const string &s);
+
+    /// @brief return an integer operand
+    string Operand(void);
+
+    /// @brief return an integer expression with @a terms operands
+    string Expression(int terms, int depth=0);
+
+    /// @brief emit a long expression spread over @a lines (>= 2) lines
+    void LongAssignment(int ind, const string &dst, int lines);
+
+    /// @brief emit nested statements up to @a depth levels
+    void Nested(int ind, int depth);
+
+    /// @brief emit procedure @a p
+    void Procedure(int p);
+
+    unsigned long long _state;      ///< random number generator state
+    int _nglobals;                  ///< number of global scalars
+    int _narrays;                   ///< number of global arrays
+    long long _nlines;              ///< lines written so far
+    ostringstream _out;             ///< generated module
+};
+
+
+#endif // __SnuPL_SYNTH_H__
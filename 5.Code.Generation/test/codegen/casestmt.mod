@@ -0,0 +1,112 @@
+//
+// casestmt
+//
+// case statements with dense labels (jump table), sparse labels (binary
+// search), ranges, character labels and with and without else arms
+//
+
+module casestmt;
+
+var i, s: integer;
+    a: integer[3];
+
+// dense: dispatched through a jump table
+function dense(v: integer): integer;
+var r: integer;
+begin
+    r := 0;
+    case (v) of
+      0: r := 10
+    | 1: r := 11
+    | 2, 4: r := 12
+    | 3: r := 13
+    | 5..7: r := 14
+    | 9: r := 15
+    else r := -1
+    end;
+    return r
+end dense;
+
+// sparse: dispatched by a binary search
+function sparse(v: integer): integer;
+begin
+    case (v) of
+      -1000: return 1
+    | -3: return 2
+    | 7: return 3
+    | 100..199: return 4
+    | 1000: return 5
+    | 65536: return 6
+    | 2147483647: return 7
+    | -2147483648: return 8
+    end;
+    return 0
+end sparse;
+
+// characters; no else arm
+procedure kind(c: char);
+begin
+    case (c) of
+      'a', 'e', 'i', 'o', 'u': WriteStr("v")
+    | 'b'..'d', 'f'..'h', 'j'..'n', 'p'..'t', 'v'..'z': WriteStr("c")
+    | '0'..'9': WriteStr("d")
+    | ' ': WriteStr("_")
+    end
+end kind;
+
+// 'case' and 'of' are not keywords: variables may still be named 'case' or
+// 'of'. A declared 'case' hides the case statement in its scope.
+function names(of: integer): integer;
+var case: integer;
+begin
+    case := of * 2;
+    return case + 1
+end names;
+
+begin
+    i := -3;
+    while (i < 12) do
+        WriteInt(dense(i)); WriteStr(" ");
+        i := i + 1
+    end;
+    WriteLn();
+
+    s := 0;
+    i := -1001;
+    while (i < 1002) do
+        s := s + sparse(i);
+        i := i + 1
+    end;
+    WriteInt(s); WriteLn();
+    WriteInt(sparse(65536)); WriteInt(sparse(2147483647));
+    WriteInt(sparse(-2147483648)); WriteInt(sparse(65535)); WriteLn();
+
+    kind('h'); kind('e'); kind('l'); kind('l'); kind('o'); kind(' ');
+    kind('4'); kind('2'); kind('!'); WriteLn();
+
+    // selector read from an array and from the input until 0; nested case
+    a[1] := ReadInt();
+    while (a[1] # 0) do
+        case (a[1]) of
+          1..5: WriteStr("small")
+        | 6..9:
+            case (a[1] - 6) of
+              0: WriteStr("six")
+            | 1: WriteStr("seven")
+            else WriteStr("big")
+            end
+        else WriteStr("other")
+        end;
+        WriteLn();
+        a[1] := ReadInt()
+    end;
+
+    // empty arm
+    case (ReadInt()) of
+      3:
+    | 4: WriteStr("four")
+    end;
+    WriteStr("done"); WriteLn();
+
+    WriteInt(names(20)); WriteLn()
+end casestmt.
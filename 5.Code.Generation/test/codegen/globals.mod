@@ -0,0 +1,66 @@
+//
+// globals
+//
+// global analysis (--global-analysis): globals that are never written,
+// written once before any call, read before their only write, written
+// after a call, and loaded once at the entry of a procedure that also
+// receives its arguments in registers (--regcall)
+//
+
+module globals;
+
+var once, late, never, d: integer;
+    v: integer[4];
+
+function getLate(): integer;
+begin
+    return late
+end getLate;
+
+function getOnce(): integer;
+begin
+    return once
+end getOnce;
+
+// d is read but not written here: it is loaded once at the entry. The
+// parameters are passed in registers with --regcall.
+function scale(x, y, z: integer): integer;
+var i, s: integer;
+begin
+    i := 0; s := 0;
+    while (i < x) do
+        s := s + d * y;
+        if (s > d * z) then s := s - d end;
+        i := i + 1
+    end;
+    return s + d + never
+end scale;
+
+procedure show(a, b: integer);
+begin
+    WriteInt(a); WriteStr(" "); WriteInt(b); WriteLn()
+end show;
+
+begin
+    // read before the only write, which happens before any call
+    WriteInt(once); WriteLn();
+    once := 5;
+    WriteInt(once); WriteLn();
+    show(once, getOnce());
+
+    // written after a call: procedures called earlier see the old value
+    show(getLate(), late);
+    late := 7;
+    show(getLate(), late);
+
+    // never written
+    show(never, never + once);
+
+    // d changes between the calls; scale() reads it from memory at its entry
+    d := 3;
+    show(scale(4, 2, 10), d);
+    d := ReadInt();
+    show(scale(5, d, 1), d);
+    v[0] := scale(d, once, late);
+    show(v[0], scale(1, 1, 1))
+end globals.
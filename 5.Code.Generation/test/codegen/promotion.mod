@@ -0,0 +1,158 @@
+//
+// promotion
+//
+// globals kept in a register in loops (--promote): loops left by an early
+// return, loops left through the arms of a case statement, and loops that
+// call procedures which access the global only through a helper
+//
+
+module promotion;
+
+var g, h, n: integer;
+
+// access the globals only through helpers
+function peek(): integer;
+begin
+    return g
+end peek;
+
+function viaPeek(): integer;
+begin
+    return peek()
+end viaPeek;
+
+procedure bump();
+begin
+    h := h + 1
+end bump;
+
+procedure viaBump();
+begin
+    bump()
+end viaBump;
+
+// returns from within the loop: g must be stored before returning
+function find(limit: integer): integer;
+var i: integer;
+begin
+    i := 0;
+    while (i < 100) do
+        g := g + i;
+        if (g > limit) then return i end;
+        i := i + 1
+    end;
+    return -1
+end find;
+
+// nested loops; the inner loop returns
+function nested(limit: integer): integer;
+var i, j: integer;
+begin
+    i := 0;
+    while (i < 10) do
+        j := 0;
+        while (j < 10) do
+            g := g + 1;
+            if (g = limit) then return i * 10 + j end;
+            j := j + 1
+        end;
+        i := i + 1
+    end;
+    return -1
+end nested;
+
+// the loop is left through the arms of a case statement
+function classify(k: integer): integer;
+var i: integer;
+begin
+    i := 0;
+    while (i < k) do
+        h := h + 2;
+        case (i) of
+          0..2: h := h + 1
+        | 3: return h
+        | 5, 7: h := h - 1
+        else i := i + 1
+        end;
+        i := i + 1
+    end;
+    return -h
+end classify;
+
+// the loop is left by a case statement dispatched through a jump table
+function dense(k: integer): integer;
+var i: integer;
+begin
+    i := 0;
+    while (1 = 1) do
+        g := g + 1;
+        case (i) of
+          0: g := g + 10
+        | 1: g := g + 20
+        | 2: g := g + 30
+        | 3: g := g + 40
+        | 4: return g
+        | 5: g := g + 60
+        end;
+        i := i + k
+    end;
+    return 0
+end dense;
+
+// calls read or write the global through a helper: it stays in memory
+function reads(k: integer): integer;
+var i, s: integer;
+begin
+    i := 0; s := 0;
+    while (i < k) do
+        g := g + 1;
+        s := s + viaPeek();
+        i := i + 1
+    end;
+    return s
+end reads;
+
+function writes(k: integer): integer;
+var i: integer;
+begin
+    i := 0;
+    while (i < k) do
+        h := h + 1;
+        viaBump();
+        i := i + 1
+    end;
+    return h
+end writes;
+
+begin
+    g := 0; h := 0;
+    WriteInt(find(20)); WriteStr(" "); WriteInt(g); WriteLn();
+    WriteInt(find(1000)); WriteStr(" "); WriteInt(g); WriteLn();
+
+    g := 0;
+    WriteInt(nested(37)); WriteStr(" "); WriteInt(g); WriteLn();
+    WriteInt(nested(0)); WriteStr(" "); WriteInt(g); WriteLn();
+
+    WriteInt(classify(10)); WriteStr(" "); WriteInt(h); WriteLn();
+    h := 0;
+    WriteInt(classify(3)); WriteStr(" "); WriteInt(h); WriteLn();
+
+    g := 0;
+    WriteInt(dense(1)); WriteStr(" "); WriteInt(g); WriteLn();
+    g := 0;
+    WriteInt(dense(2)); WriteStr(" "); WriteInt(g); WriteLn();
+
+    g := 0;
+    WriteInt(reads(10)); WriteStr(" "); WriteInt(g); WriteLn();
+    h := 0;
+    WriteInt(writes(10)); WriteStr(" "); WriteInt(h); WriteLn();
+
+    // the module body: the loop count is read from the input
+    n := ReadInt();
+    g := 0;
+    while (g < n) do
+        g := g + 3;
+        if (g = 9) then WriteStr("nine ") end
+    end;
+    WriteInt(g); WriteLn()
+end promotion.
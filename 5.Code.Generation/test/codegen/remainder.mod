@@ -0,0 +1,57 @@
+//
+// remainder
+//
+// the 'mod' operator and the remainder idioms 'x - x/y*y' and 'x/y*y = x'
+//
+
+module remainder;
+
+var i, s: integer;
+    a: integer[4];
+
+// 'mod' is not a keyword: procedures may still be named 'mod'
+function mod(v, q: integer): integer;
+begin
+    return v - v / q * q
+end mod;
+
+begin
+    // remainders truncate towards zero like integer division
+    WriteInt(17 mod 5); WriteLn();
+    WriteInt(-17 mod 5); WriteLn();
+    WriteInt((-17) mod 5); WriteLn();
+    WriteInt(17 mod (-5)); WriteLn();
+    WriteInt(mod(23, 7)); WriteLn();
+
+    // divisibility tests
+    a[1] := 3; s := 0; i := 0;
+    while (i < 20) do
+        if (i / a[1] * a[1] = i) then s := s + i end;
+        if (a[1] * (i / a[1]) # i) then s := s + 100 end;
+        i := i + 1
+    end;
+    WriteInt(s); WriteLn();
+    WriteInt(s mod 7 * 2 + 1 mod 1); WriteLn();
+
+    // negative dividends; constant divisors that are and are not powers
+    // of two, both positive and negative
+    i := -9;
+    while (i <= 9) do
+        WriteInt(i mod 4); WriteStr(" ");
+        WriteInt(i mod 3); WriteStr(" ");
+        WriteInt(i mod (-8)); WriteStr(" ");
+        WriteInt(i mod (-6)); WriteStr(" ");
+        WriteInt(i - i/16*16); WriteStr(" ");
+        WriteInt(mod(i, -5)); WriteLn();
+        i := i + 2
+    end;
+
+    // divisors only known at run time, read until a divisor of 0
+    a[0] := ReadInt(); a[2] := ReadInt();
+    while (a[2] # 0) do
+        WriteInt(a[0] mod a[2]); WriteStr(" ");
+        if (a[0] / a[2] * a[2] = a[0]) then WriteStr("divisible") end;
+        WriteLn();
+        a[0] := ReadInt(); a[2] := ReadInt()
+    end
+end remainder.
@@ -24,6 +24,7 @@ syn match   snuEscape       "\\." contained
 syn match   snuOperator     "\(:\|<\|>\)="
 syn match   snuOperator     "&&\|||"
 syn match   snuOperator     "[+\-=*/!<>=#.;]"
+syn match   snuOperator     "\<mod\>"
 syn match   snuComment      "//.*$" contains=snuTodo
 
 syn cluster snuContained    contains=snuEscape,snuTodo